@@ -1,18 +1,1440 @@
 #include <iostream>
 #include <string>
+#include <vector>
+#include <memory>
+#include <utility>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <algorithm>
+#include <charconv>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <stdexcept>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace std;
+namespace fs = std::filesystem;
+
+// Installs live under one library directory: <library>/<gameID>/ holds a
+// game's files, <library>/manifests/<gameID>.manifest lists their chunk
+// hashes and <gameID>.journal beside it remembers what already verified.
+// <library>/installs.registry lists what is installed. RUNGAME_LIBRARY
+// overrides the default "games".
+string libraryRoot() {
+    const char* root = getenv("RUNGAME_LIBRARY");
+    return root && *root ? root : "games";
+}
+
+// Game IDs become path components, so they may not climb out of the library
+void checkGameID(const string& gameID) {
+    if (gameID.empty() || gameID == "." || gameID == ".." || gameID.find('/') != string::npos) {
+        throw invalid_argument("Invalid game ID: " + gameID);
+    }
+}
+
+string installPath(const string& gameID) {
+    checkGameID(gameID);
+    return libraryRoot() + "/" + gameID;
+}
+
+string manifestPath(const string& gameID) {
+    checkGameID(gameID);
+    return libraryRoot() + "/manifests/" + gameID + ".manifest";
+}
+
+string journalPath(const string& gameID) {
+    checkGameID(gameID);
+    return libraryRoot() + "/manifests/" + gameID + ".journal";
+}
+
+// xxHash64 (XXH64). Not cryptographic, but it hashes several GB/s per core,
+// so verification waits on the disk rather than the CPU.
+uint64_t xxHash64(const void* data, size_t length, uint64_t seed = 0) {
+    const uint64_t prime1 = 0x9E3779B185EBCA87ULL, prime2 = 0xC2B2AE3D27D4EB4FULL,
+        prime3 = 0x165667B19E3779F9ULL, prime4 = 0x85EBCA77C2B2AE63ULL, prime5 = 0x27D4EB2F165667C5ULL;
+    auto rotate = [](uint64_t x, int n) { return (x << n) | (x >> (64 - n)); };
+    auto read64 = [](const unsigned char* p) { uint64_t v; memcpy(&v, p, 8); return v; };
+    auto read32 = [](const unsigned char* p) { uint32_t v; memcpy(&v, p, 4); return v; };
+    auto round = [&](uint64_t acc, uint64_t input) {
+        return rotate(acc + input * prime2, 31) * prime1;
+    };
+    auto merge = [&](uint64_t acc, uint64_t value) {
+        return (acc ^ round(0, value)) * prime1 + prime4;
+    };
+
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    const unsigned char* end = p + length;
+    uint64_t hash;
+    if (length >= 32) {
+        uint64_t v1 = seed + prime1 + prime2, v2 = seed + prime2, v3 = seed, v4 = seed - prime1;
+        for (; p + 32 <= end; p += 32) {
+            v1 = round(v1, read64(p));
+            v2 = round(v2, read64(p + 8));
+            v3 = round(v3, read64(p + 16));
+            v4 = round(v4, read64(p + 24));
+        }
+        hash = rotate(v1, 1) + rotate(v2, 7) + rotate(v3, 12) + rotate(v4, 18);
+        hash = merge(merge(merge(merge(hash, v1), v2), v3), v4);
+    } else {
+        hash = seed + prime5;
+    }
+    hash += length;
+    for (; p + 8 <= end; p += 8) hash = rotate(hash ^ round(0, read64(p)), 27) * prime1 + prime4;
+    if (p + 4 <= end) {
+        hash = rotate(hash ^ (read32(p) * prime1), 23) * prime2 + prime3;
+        p += 4;
+    }
+    for (; p < end; ++p) hash = rotate(hash ^ (*p * prime5), 11) * prime1;
+    hash ^= hash >> 33;
+    hash *= prime2;
+    hash ^= hash >> 29;
+    hash *= prime3;
+    return hash ^ (hash >> 32);
+}
+
+// A game's content as a list of files, each cut into chunks with a hash per
+// chunk. Chunks carry their own offset and length, so they need not be the
+// same size.
+struct ChunkRef {
+    uint64_t offset;
+    uint64_t length;
+    uint64_t hash;
+};
+
+struct ManifestFile {
+    string path; // relative to the install root
+    uint64_t size;
+    vector<ChunkRef> chunks;
+};
+
+struct Manifest {
+    vector<ManifestFile> files;
+};
+
+const uint64_t DefaultChunkSize = 4 << 20;
+
+// Flushes a file, or a directory's entries, to disk
+void syncToDisk(const string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) throw runtime_error("Cannot open " + path + ": " + strerror(errno));
+    int synced = ::fsync(fd);
+    ::close(fd);
+    if (synced != 0) throw runtime_error("Cannot sync " + path + ": " + strerror(errno));
+}
+
+// Text format, one line each:
+//   manifest 1
+//   file <size> <chunk count> <path>     (the path runs to the end of the line)
+//   <offset> <length> <hash in hex>      (once per chunk)
+void saveManifest(const Manifest& manifest, const string& path) {
+    string temp = path + ".tmp";
+    {
+        ofstream out(temp, ios::trunc);
+        out << "manifest 1\n";
+        for (const ManifestFile& file : manifest.files) {
+            out << "file " << file.size << " " << file.chunks.size() << " " << file.path << "\n";
+            for (const ChunkRef& chunk : file.chunks) {
+                out << chunk.offset << " " << chunk.length << " " << hex << chunk.hash << dec << "\n";
+            }
+        }
+        if (!out.flush()) throw runtime_error("Cannot write manifest " + temp);
+    }
+    syncToDisk(temp);
+    if (rename(temp.c_str(), path.c_str()) != 0) throw runtime_error("Cannot replace manifest " + path);
+    syncToDisk(fs::path(path).parent_path().empty() ? "." : fs::path(path).parent_path().string());
+}
+
+// Manifest paths are joined onto the install root, so they must be relative
+// and may not name "." or "..": no entry may point outside the install
+bool safeRelativePath(const string& path) {
+    if (path.empty() || path[0] == '/') return false;
+    for (size_t start = 0;;) {
+        size_t slash = path.find('/', start);
+        string part = path.substr(start, slash - start);
+        if (part.empty() || part == "." || part == "..") return false;
+        if (slash == string::npos) return true;
+        start = slash + 1;
+    }
+}
+
+Manifest loadManifest(const string& path) {
+    ifstream in(path);
+    if (!in) throw runtime_error("No manifest at " + path);
+    string line;
+    if (!getline(in, line) || line != "manifest 1") throw runtime_error("Not a manifest: " + path);
+    Manifest manifest;
+    while (getline(in, line)) {
+        istringstream header(line);
+        string tag;
+        size_t count = 0;
+        ManifestFile file;
+        if (!(header >> tag >> file.size >> count) || tag != "file" || header.get() != ' ' || !getline(header, file.path)) {
+            throw runtime_error("Malformed manifest entry in " + path + ": " + line);
+        }
+        if (!safeRelativePath(file.path)) throw runtime_error("Unsafe path in manifest " + path + ": " + file.path);
+        if (count > file.size) throw runtime_error("Bad chunk list in manifest " + path + ": " + file.path);
+        file.chunks.resize(count);
+        // Chunks must tile the file exactly, in order, so a chunk's range
+        // never overflows or reaches past the file size
+        uint64_t next = 0;
+        for (ChunkRef& chunk : file.chunks) {
+            if (!(in >> chunk.offset >> chunk.length >> hex >> chunk.hash >> dec)) {
+                throw runtime_error("Truncated manifest " + path);
+            }
+            if (chunk.offset != next || chunk.length == 0 || chunk.length > file.size - next) {
+                throw runtime_error("Bad chunk list in manifest " + path + ": " + file.path);
+            }
+            next += chunk.length;
+        }
+        if (next != file.size) throw runtime_error("Bad chunk list in manifest " + path + ": " + file.path);
+        if (count > 0) in.ignore(1, '\n'); // the last chunk line's newline
+        manifest.files.push_back(move(file));
+    }
+    return manifest;
+}
+
+// Read-only mapping of a whole file. An empty or missing file maps nothing.
+class MappedFile {
+    private:
+        const unsigned char* bytes = nullptr;
+        uint64_t length = 0;
+        bool found = false;
+
+    public:
+        explicit MappedFile(const string& path) {
+            int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) return;
+            struct stat info;
+            if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+                found = true;
+                length = static_cast<uint64_t>(info.st_size);
+                if (length > 0) {
+                    void* mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (mapped == MAP_FAILED) {
+                        found = false;
+                        length = 0;
+                    } else {
+                        bytes = static_cast<const unsigned char*>(mapped);
+                    }
+                }
+            }
+            ::close(fd); // the mapping stays valid
+        }
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        ~MappedFile() {
+            if (bytes) ::munmap(const_cast<unsigned char*>(bytes), length);
+        }
+
+        bool exists() const { return found; }
+        uint64_t size() const { return length; }
+        const unsigned char* data() const { return bytes; }
+
+        // Hashes [offset, offset + count), asking the kernel to read the
+        // range ahead first. The range must lie inside the file.
+        uint64_t hashRange(uint64_t offset, uint64_t count) const {
+            if (count == 0) return xxHash64(nullptr, 0);
+            uint64_t pageStart = offset & ~static_cast<uint64_t>(sysconf(_SC_PAGESIZE) - 1);
+            ::madvise(const_cast<unsigned char*>(bytes) + pageStart, offset + count - pageStart, MADV_WILLNEED);
+            return xxHash64(bytes + offset, count);
+        }
+};
+
+// Runs work(i) for every i in [0, count) on up to threads threads, handing
+// out indexes one at a time so a slow chunk never holds up a whole batch
+template <typename Work>
+void parallelFor(size_t count, unsigned threads, Work work) {
+    atomic<size_t> next(0);
+    auto drain = [&]() {
+        for (size_t i; (i = next.fetch_add(1, memory_order_relaxed)) < count;) work(i);
+    };
+    vector<thread> pool;
+    size_t helpers = min<size_t>(max(1u, threads), max<size_t>(count, 1)) - 1;
+    for (size_t t = 0; t < helpers; ++t) pool.emplace_back(drain);
+    drain();
+    for (thread& t : pool) t.join();
+}
+
+unsigned defaultThreads() {
+    return max(1u, thread::hardware_concurrency());
+}
+
+// Every regular file under root, sorted by path, with no chunks yet
+Manifest listFiles(const string& root) {
+    Manifest manifest;
+    for (const auto& entry : fs::recursive_directory_iterator(root)) {
+        if (entry.is_regular_file()) {
+            manifest.files.push_back({fs::relative(entry.path(), root).generic_string(), 0, {}});
+        }
+    }
+    sort(manifest.files.begin(), manifest.files.end(), [](const ManifestFile& a, const ManifestFile& b) {
+        return a.path < b.path;
+    });
+    return manifest;
+}
+
+// Cuts every regular file under root into chunkSize chunks and hashes them
+Manifest buildManifest(const string& root, uint64_t chunkSize = DefaultChunkSize, unsigned threads = defaultThreads()) {
+    if (chunkSize == 0) throw invalid_argument("Chunk size must be positive");
+    Manifest manifest = listFiles(root);
+
+    vector<unique_ptr<MappedFile>> mapped;
+    vector<pair<size_t, size_t>> work; // (file, chunk)
+    for (size_t f = 0; f < manifest.files.size(); ++f) {
+        ManifestFile& file = manifest.files[f];
+        mapped.push_back(make_unique<MappedFile>(root + "/" + file.path));
+        file.size = mapped.back()->size();
+        for (uint64_t offset = 0; offset < file.size; offset += chunkSize) {
+            file.chunks.push_back({offset, min(chunkSize, file.size - offset), 0});
+            work.emplace_back(f, file.chunks.size() - 1);
+        }
+    }
+    parallelFor(work.size(), threads, [&](size_t i) {
+        ChunkRef& chunk = manifest.files[work[i].first].chunks[work[i].second];
+        chunk.hash = mapped[work[i].first]->hashRange(chunk.offset, chunk.length);
+    });
+    return manifest;
+}
+
+// What verifyInstall found. Chunks are listed by position in the manifest,
+// so a repair can re-fetch exactly those byte ranges.
+struct BadChunk {
+    size_t file;
+    size_t chunk;
+};
+
+struct VerifyReport {
+    vector<BadChunk> badChunks; // missing, short or wrong, in manifest order
+    vector<size_t> oversizedFiles; // every chunk matches but the file has extra bytes
+    vector<size_t> missingFiles; // absent or not a regular file, including ones with no chunks
+    uint64_t bytesHashed = 0;
+    size_t filesSkipped = 0; // vouched for by the journal, not read
+
+    bool clean() const {
+        return badChunks.empty() && oversizedFiles.empty() && missingFiles.empty();
+    }
+};
+
+// Hashes every chunk of the install in parallel and compares it with the
+// manifest. Each file is mapped once; chunks of all files share one queue,
+// so a single huge file still spreads across every thread.
+VerifyReport verifyInstall(const string& root, const Manifest& manifest, unsigned threads = defaultThreads()) {
+    vector<unique_ptr<MappedFile>> mapped;
+    vector<pair<size_t, size_t>> work;
+    for (size_t f = 0; f < manifest.files.size(); ++f) {
+        mapped.push_back(make_unique<MappedFile>(root + "/" + manifest.files[f].path));
+        for (size_t c = 0; c < manifest.files[f].chunks.size(); ++c) work.emplace_back(f, c);
+    }
+    vector<uint8_t> bad(work.size(), 0);
+    atomic<uint64_t> hashed(0);
+    parallelFor(work.size(), threads, [&](size_t i) {
+        const MappedFile& file = *mapped[work[i].first];
+        const ChunkRef& chunk = manifest.files[work[i].first].chunks[work[i].second];
+        if (chunk.offset > file.size() || chunk.length > file.size() - chunk.offset) {
+            bad[i] = 1;
+            return;
+        }
+        bad[i] = file.hashRange(chunk.offset, chunk.length) != chunk.hash;
+        hashed.fetch_add(chunk.length, memory_order_relaxed);
+    });
+
+    VerifyReport report;
+    report.bytesHashed = hashed.load();
+    for (size_t i = 0; i < work.size(); ++i) {
+        if (bad[i]) report.badChunks.push_back({work[i].first, work[i].second});
+    }
+    for (size_t f = 0; f < manifest.files.size(); ++f) {
+        if (!mapped[f]->exists()) {
+            report.missingFiles.push_back(f);
+        } else if (mapped[f]->size() > manifest.files[f].size) {
+            report.oversizedFiles.push_back(f);
+        }
+    }
+    return report;
+}
+
+// What the filesystem says about a file without reading it. A file whose
+// stamp still matches the one taken when it verified clean is taken to be
+// unchanged. ctime is compared too: tools can set mtime back, but not ctime.
+struct FileStamp {
+    uint64_t size = 0;
+    uint64_t inode = 0;
+    uint64_t device = 0;
+    int64_t mtimeNs = 0;
+    int64_t ctimeNs = 0;
+
+    bool operator==(const FileStamp& other) const {
+        return size == other.size && inode == other.inode && device == other.device &&
+            mtimeNs == other.mtimeNs && ctimeNs == other.ctimeNs;
+    }
+    bool operator!=(const FileStamp& other) const {
+        return !(*this == other);
+    }
+};
+
+// False when path is missing or not a regular file
+bool statFile(const string& path, FileStamp& stamp) {
+    struct stat info;
+    if (::stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) return false;
+    stamp.size = static_cast<uint64_t>(info.st_size);
+    stamp.inode = static_cast<uint64_t>(info.st_ino);
+    stamp.device = static_cast<uint64_t>(info.st_dev);
+    stamp.mtimeNs = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    stamp.ctimeNs = static_cast<int64_t>(info.st_ctim.tv_sec) * 1000000000 + info.st_ctim.tv_nsec;
+    return true;
+}
+
+// Fingerprint of what a manifest entry expects, so a journal entry written
+// against one manifest never vouches for a file under a newer one
+uint64_t entryHash(const ManifestFile& file) {
+    uint64_t hash = xxHash64(file.path.data(), file.path.size(), file.size);
+    for (const ChunkRef& chunk : file.chunks) {
+        uint64_t fields[3] = {chunk.offset, chunk.length, chunk.hash};
+        hash = xxHash64(fields, sizeof(fields), hash);
+    }
+    return hash;
+}
+
+// Remembers which files last verified clean and what they looked like at
+// the time. It only ever saves work: a missing or unreadable journal means
+// everything gets hashed, never that anything passes unread.
+//   journal 1 <last full scrub, unix seconds>
+//   <size> <inode> <device> <mtime ns> <ctime ns> <entry hash in hex> <path>
+class VerificationJournal {
+    private:
+        struct Entry {
+            FileStamp stamp;
+            uint64_t expected; // entryHash of the manifest entry it matched
+        };
+        unordered_map<string, Entry> entries;
+        int64_t scrubbedAt = 0;
+
+    public:
+        static VerificationJournal load(const string& path) {
+            VerificationJournal journal;
+            ifstream in(path);
+            string line, tag;
+            int version = 0;
+            if (!getline(in, line) || !(istringstream(line) >> tag >> version >> journal.scrubbedAt) ||
+                tag != "journal" || version != 1) {
+                return VerificationJournal();
+            }
+            while (getline(in, line)) {
+                istringstream fields(line);
+                Entry entry;
+                string file;
+                if (!(fields >> entry.stamp.size >> entry.stamp.inode >> entry.stamp.device >> entry.stamp.mtimeNs >>
+                      entry.stamp.ctimeNs >> hex >> entry.expected) || fields.get() != ' ' || !getline(fields, file)) {
+                    return VerificationJournal(); // torn or foreign; start over
+                }
+                journal.entries[file] = entry;
+            }
+            return journal;
+        }
+
+        // Written beside the target and renamed over it, so readers see the
+        // old journal or the new one. Concurrent writers each land whole;
+        // the last one wins, which only costs the other's entries a rehash.
+        void save(const string& path) const {
+            static mutex saving;
+            lock_guard<mutex> lock(saving);
+            string temp = path + ".tmp" + to_string(::getpid());
+            {
+                ofstream out(temp, ios::trunc);
+                out << "journal 1 " << scrubbedAt << "\n";
+                for (const auto& [file, entry] : entries) {
+                    out << entry.stamp.size << " " << entry.stamp.inode << " " << entry.stamp.device << " "
+                        << entry.stamp.mtimeNs << " " << entry.stamp.ctimeNs << " " << hex << entry.expected << dec
+                        << " " << file << "\n";
+                }
+                if (!out.flush()) throw runtime_error("Cannot write journal " + temp);
+            }
+            if (rename(temp.c_str(), path.c_str()) != 0) throw runtime_error("Cannot replace journal " + path);
+        }
+
+        bool vouchesFor(const string& file, const FileStamp& stamp, uint64_t expected) const {
+            auto found = entries.find(file);
+            return found != entries.end() && found->second.expected == expected && found->second.stamp == stamp;
+        }
+
+        void record(const string& file, const FileStamp& stamp, uint64_t expected) {
+            entries[file] = {stamp, expected};
+        }
+
+        size_t size() const { return entries.size(); }
+        int64_t lastScrub() const { return scrubbedAt; }
+        void markScrubbed(int64_t when) { scrubbedAt = when; }
+};
+
+// Timestamps only move as often as the kernel's clock ticks, so a file
+// written this close to its verification could change again without its
+// stamp changing. Such files are checked but not journaled until they settle.
+const int64_t RacyWindowNs = 2000000000;
+
+// verifyInstall for only the files the journal cannot vouch for, or for
+// everything when full is set. The journal is rebuilt to hold exactly the
+// manifest's files that are now known clean, and counts as freshly scrubbed
+// whenever nothing was skipped.
+VerifyReport verifyIncremental(const string& root, const Manifest& manifest, VerificationJournal& journal,
+                               bool full = false, unsigned threads = defaultThreads()) {
+    auto now = chrono::system_clock::now().time_since_epoch();
+    int64_t startedNs = chrono::duration_cast<chrono::nanoseconds>(now).count();
+
+    VerifyReport report;
+    VerificationJournal next;
+    next.markScrubbed(journal.lastScrub());
+    Manifest changed;
+    vector<size_t> original; // changed file -> manifest file
+    vector<FileStamp> before;
+    vector<uint8_t> present;
+    for (size_t f = 0; f < manifest.files.size(); ++f) {
+        const ManifestFile& file = manifest.files[f];
+        FileStamp stamp;
+        bool found = statFile(root + "/" + file.path, stamp);
+        uint64_t expected = entryHash(file);
+        if (!full && found && journal.vouchesFor(file.path, stamp, expected)) {
+            next.record(file.path, stamp, expected);
+            ++report.filesSkipped;
+            continue;
+        }
+        changed.files.push_back(file);
+        original.push_back(f);
+        before.push_back(stamp);
+        present.push_back(found);
+    }
+
+    VerifyReport partial = verifyInstall(root, changed, threads);
+    report.bytesHashed = partial.bytesHashed;
+    vector<uint8_t> failed(changed.files.size(), 0);
+    for (const BadChunk& bad : partial.badChunks) {
+        report.badChunks.push_back({original[bad.file], bad.chunk});
+        failed[bad.file] = 1;
+    }
+    for (size_t f : partial.oversizedFiles) {
+        report.oversizedFiles.push_back(original[f]);
+        failed[f] = 1;
+    }
+    for (size_t f : partial.missingFiles) {
+        report.missingFiles.push_back(original[f]);
+        failed[f] = 1;
+    }
+
+    // A file only goes in the journal if it looked the same before and after
+    // it was hashed; otherwise it may have changed under the hash
+    for (size_t i = 0; i < changed.files.size(); ++i) {
+        if (failed[i] || !present[i]) continue;
+        FileStamp after;
+        if (!statFile(root + "/" + changed.files[i].path, after) || after != before[i]) continue;
+        if (max(after.mtimeNs, after.ctimeNs) > startedNs - RacyWindowNs) continue;
+        next.record(changed.files[i].path, after, entryHash(changed.files[i]));
+    }
+    if (report.filesSkipped == 0) next.markScrubbed(startedNs / 1000000000);
+    journal = move(next);
+    return report;
+}
+
+// How often a full scrub rehashes everything regardless of the journal, to
+// catch damage that leaves metadata alone (bit rot, writers that restore
+// mtime). RUNGAME_SCRUB_HOURS overrides the weekly default; 0 scrubs after
+// every launch.
+chrono::seconds scrubInterval() {
+    const char* hours = getenv("RUNGAME_SCRUB_HOURS");
+    if (hours && *hours) return chrono::hours(strtoull(hours, nullptr, 10));
+    return chrono::hours(24 * 7);
+}
+
+// Reads only the journal's first line, so asking costs next to nothing
+bool scrubDue(const string& gameID) {
+    ifstream in(journalPath(gameID));
+    string tag;
+    int version = 0;
+    int64_t scrubbedAt = 0;
+    in >> tag >> version >> scrubbedAt;
+    int64_t now = chrono::duration_cast<chrono::seconds>(chrono::system_clock::now().time_since_epoch()).count();
+    return now - scrubbedAt >= scrubInterval().count();
+}
+
+// Identifies a whole manifest: equal ids mean the same files with the same
+// chunks
+uint64_t manifestId(const Manifest& manifest) {
+    uint64_t id = 0;
+    for (const ManifestFile& file : manifest.files) {
+        uint64_t expected = entryHash(file);
+        id = xxHash64(&expected, sizeof(expected), id);
+    }
+    return id;
+}
+
+struct InstallRecord {
+    string root;
+    string version;
+    uint64_t manifestId = 0;
+    uint64_t size = 0; // bytes listed by the manifest
+    bool modified = false; // written to outside the client since it was registered
+};
+
+enum class InstallState { NotInstalled, Installed, Modified, Unavailable };
+
+// Which games are installed, where, and at what version, held in memory so
+// asking costs a hash lookup. Every install root is watched with inotify,
+// directories included recursively: removing or moving a root away drops
+// its game, and any other change marks it modified until it is registered
+// again. Lookups first apply whatever events the kernel has queued, so an
+// answer is never older than the call; a watcher thread applies them in
+// between so the file on disk keeps up too. Installs that cannot be fully
+// watched (fs.inotify.max_user_watches) have their roots checked on lookup
+// instead, which still catches a missing root but not edits.
+// A root that is missing without the registry seeing it go (a drive not
+// mounted, a removal while nothing was running) only makes its game
+// unavailable: the record is kept, and once the root is back it is watched
+// again and counts as modified, since nothing saw what happened meanwhile.
+//   registry 1
+//   <gameID> <root> <version> <manifest id in hex> <size> <modified 0/1>   (tab separated)
+class InstallRegistry {
+    private:
+        string path;
+        unordered_map<string, InstallRecord> installs;
+        unordered_map<int, pair<string, string>> watches; // watch -> (gameID, directory)
+        unordered_set<string> unwatched; // games with directories inotify would not take
+        unordered_set<string> offline; // games whose root was missing when last looked at
+        bool warnedLimit = false;
+        mutex lock;
+        int inotifyFd = -1;
+        int wakeFd = -1;
+        thread watcher;
+        bool dirty = false; // installs differ from the file
+
+        static constexpr uint32_t WatchMask = IN_MODIFY | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+            IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR | IN_EXCL_UNLINK;
+
+        static bool isDirectory(const string& path) {
+            struct stat info;
+            return ::stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+        }
+
+        static bool parseNumber(const string& text, int base, uint64_t& value) {
+            auto parsed = from_chars(text.data(), text.data() + text.size(), value, base);
+            return parsed.ec == errc() && parsed.ptr == text.data() + text.size();
+        }
+
+        // A foreign file or a malformed entry is dropped with a warning and
+        // the file rewritten without it, like a torn journal: those games
+        // just read as not installed until they are registered again
+        void load() {
+            ifstream in(path);
+            string line;
+            if (!getline(in, line)) return; // nothing installed yet
+            if (line != "registry 1") {
+                cerr << "Ignoring " << path << ": not an install registry" << endl;
+                dirty = true;
+                return;
+            }
+            while (getline(in, line)) {
+                vector<string> fields;
+                for (size_t start = 0;;) {
+                    size_t tab = line.find('\t', start);
+                    fields.push_back(line.substr(start, tab - start));
+                    if (tab == string::npos) break;
+                    start = tab + 1;
+                }
+                InstallRecord record;
+                if (fields.size() != 6 || fields[0].empty() || fields[1].empty() ||
+                    !parseNumber(fields[3], 16, record.manifestId) || !parseNumber(fields[4], 10, record.size) ||
+                    (fields[5] != "0" && fields[5] != "1")) {
+                    cerr << "Dropping malformed install registry entry in " << path << ": " << line << endl;
+                    dirty = true;
+                    continue;
+                }
+                record.root = fields[1];
+                record.version = fields[2];
+                record.modified = fields[5] == "1";
+                installs[fields[0]] = record;
+            }
+        }
+
+        void save() {
+            string temp = path + ".tmp" + to_string(::getpid());
+            {
+                ofstream out(temp, ios::trunc);
+                out << "registry 1\n";
+                for (const auto& [gameID, record] : installs) {
+                    out << gameID << "\t" << record.root << "\t" << record.version << "\t" << hex << record.manifestId
+                        << dec << "\t" << record.size << "\t" << (record.modified ? 1 : 0) << "\n";
+                }
+                if (!out.flush()) throw runtime_error("Cannot write install registry " + temp);
+            }
+            if (rename(temp.c_str(), path.c_str()) != 0) throw runtime_error("Cannot replace install registry " + path);
+            dirty = false;
+        }
+
+        // Saving from the watcher or a lookup must not throw at the caller;
+        // the registry stays right in memory and tries again on the next change
+        void saveIfDirty() {
+            if (!dirty) return;
+            try {
+                save();
+            } catch (const exception& e) {
+                cerr << e.what() << endl;
+            }
+        }
+
+        void watchTree(const string& gameID, const string& directory) {
+            int wd = inotifyFd < 0 ? -1 : ::inotify_add_watch(inotifyFd, directory.c_str(), WatchMask);
+            if (wd < 0) {
+                if (!warnedLimit) {
+                    cerr << "Cannot watch " << directory << ": " << strerror(errno)
+                         << "; installs not fully watched are checked on lookup" << endl;
+                    warnedLimit = true;
+                }
+                unwatched.insert(gameID);
+                return;
+            }
+            watches[wd] = {gameID, directory};
+            error_code ignored;
+            for (const auto& entry : fs::directory_iterator(directory, ignored)) {
+                if (entry.is_directory(ignored) && !entry.is_symlink(ignored)) watchTree(gameID, entry.path().string());
+            }
+        }
+
+        void forget(const string& gameID) {
+            unwatch(gameID);
+            unwatched.erase(gameID);
+            offline.erase(gameID);
+            installs.erase(gameID);
+            dirty = true;
+        }
+
+        // Stops watching a game whose root is missing, keeping its record
+        void setOffline(const string& gameID, InstallRecord& record) {
+            unwatch(gameID);
+            unwatched.erase(gameID);
+            offline.insert(gameID);
+            if (!record.modified) {
+                record.modified = true;
+                dirty = true;
+            }
+        }
+
+        // The state of gameID. Roots not fully watched are checked here; an
+        // offline root that is back is watched again.
+        InstallState stateOf(const string& gameID) {
+            auto found = installs.find(gameID);
+            if (found == installs.end()) return InstallState::NotInstalled;
+            InstallRecord& record = found->second;
+            if (!offline.empty() && offline.count(gameID)) {
+                if (!isDirectory(record.root)) return InstallState::Unavailable;
+                offline.erase(gameID);
+                watchTree(gameID, record.root);
+                record.modified = true;
+                dirty = true;
+            } else if (!unwatched.empty() && unwatched.count(gameID) && !isDirectory(record.root)) {
+                return InstallState::Unavailable;
+            }
+            return record.modified ? InstallState::Modified : InstallState::Installed;
+        }
+
+        // Stops watching directory and everything under it, or every
+        // directory of gameID when directory is empty
+        void unwatch(const string& gameID, const string& directory = "") {
+            for (auto w = watches.begin(); w != watches.end();) {
+                const string& watched = w->second.second;
+                bool under = directory.empty() ? w->second.first == gameID :
+                    watched == directory || watched.compare(0, directory.size() + 1, directory + "/") == 0;
+                if (under) {
+                    ::inotify_rm_watch(inotifyFd, w->first);
+                    w = watches.erase(w);
+                } else {
+                    ++w;
+                }
+            }
+        }
+
+        // After lost events nothing can be assumed: every install counts as
+        // modified, and roots that are missing go offline
+        void rescan() {
+            for (auto& [gameID, record] : installs) {
+                record.modified = true;
+                if (!isDirectory(record.root)) setOffline(gameID, record);
+            }
+            dirty = true;
+        }
+
+        void apply(const inotify_event& event) {
+            if (event.mask & IN_Q_OVERFLOW) {
+                rescan();
+                return;
+            }
+            auto watched = watches.find(event.wd);
+            if (watched == watches.end()) return;
+            if (event.mask & IN_IGNORED) {
+                watches.erase(watched);
+                return;
+            }
+            string gameID = watched->second.first, directory = watched->second.second;
+            auto record = installs.find(gameID);
+            if (record == installs.end()) return;
+            if (directory == record->second.root && (event.mask & (IN_DELETE_SELF | IN_MOVE_SELF))) {
+                forget(gameID);
+                return;
+            }
+            if (event.mask & IN_UNMOUNT) {
+                setOffline(gameID, record->second); // back when the root is
+                return;
+            }
+            if (event.len > 0 && (event.mask & IN_ISDIR)) {
+                string child = directory + "/" + event.name;
+                if (event.mask & (IN_CREATE | IN_MOVED_TO)) watchTree(gameID, child);
+                if (event.mask & IN_MOVED_FROM) unwatch(gameID, child);
+            }
+            if (!record->second.modified) {
+                record->second.modified = true;
+                dirty = true;
+            }
+        }
+
+        // Applies every event queued so far; lock must be held
+        void drain() {
+            if (inotifyFd < 0) return;
+            alignas(inotify_event) char buffer[64 * 1024];
+            for (;;) {
+                ssize_t count = ::read(inotifyFd, buffer, sizeof(buffer));
+                if (count <= 0) break; // EAGAIN: caught up
+                for (char* p = buffer; p < buffer + count;) {
+                    const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+                    apply(*event);
+                    p += sizeof(inotify_event) + event->len;
+                }
+            }
+            saveIfDirty();
+        }
+
+        void watch() {
+            pollfd fds[2] = {{inotifyFd, POLLIN, 0}, {wakeFd, POLLIN, 0}};
+            for (;;) {
+                if (::poll(fds, 2, -1) < 0) {
+                    if (errno == EINTR) continue;
+                    break;
+                }
+                if (fds[1].revents) break; // shutting down
+                if (fds[0].revents & POLLIN) {
+                    lock_guard<mutex> guard(lock);
+                    drain();
+                }
+            }
+        }
+
+    public:
+        // Loads the registry at path and starts watching every root there;
+        // games whose roots are missing stay registered but unavailable
+        explicit InstallRegistry(string registryPath) : path(move(registryPath)) {
+            load();
+            inotifyFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            wakeFd = ::eventfd(0, EFD_CLOEXEC);
+            if (inotifyFd < 0 || wakeFd < 0) {
+                cerr << "Cannot watch installs: " << strerror(errno) << endl;
+            }
+            for (auto& [gameID, record] : installs) {
+                if (isDirectory(record.root)) watchTree(gameID, record.root);
+                else offline.insert(gameID);
+            }
+            saveIfDirty();
+            if (inotifyFd >= 0 && wakeFd >= 0) watcher = thread(&InstallRegistry::watch, this);
+        }
+        InstallRegistry(const InstallRegistry&) = delete;
+        InstallRegistry& operator=(const InstallRegistry&) = delete;
+
+        ~InstallRegistry() {
+            if (watcher.joinable()) {
+                uint64_t one = 1;
+                if (::write(wakeFd, &one, sizeof(one)) == sizeof(one)) watcher.join();
+                else watcher.detach();
+            }
+            if (inotifyFd >= 0) ::close(inotifyFd);
+            if (wakeFd >= 0) ::close(wakeFd);
+        }
+
+        // Records a finished install or update. Its root is watched from
+        // here on and any earlier modified mark is cleared.
+        void registerInstall(const string& gameID, InstallRecord record) {
+            checkGameID(gameID);
+            for (const string& field : {gameID, record.root, record.version}) {
+                if (field.find_first_of("\t\n") != string::npos) {
+                    throw invalid_argument("Tabs and newlines cannot be registered: " + field);
+                }
+            }
+            if (!isDirectory(record.root)) throw invalid_argument("No install at " + record.root);
+            record.modified = false;
+            lock_guard<mutex> guard(lock);
+            drain(); // events from writing the install belong to the old record
+            if (installs.count(gameID)) forget(gameID);
+            installs[gameID] = record;
+            watchTree(gameID, record.root);
+            save();
+        }
+
+        bool unregister(const string& gameID) {
+            lock_guard<mutex> guard(lock);
+            drain();
+            if (installs.count(gameID) == 0) return false;
+            forget(gameID);
+            save();
+            return true;
+        }
+
+        // An unavailable game is not installed as far as launching goes
+        bool isInstalled(const string& gameID) {
+            lock_guard<mutex> guard(lock);
+            drain();
+            InstallState state = stateOf(gameID);
+            saveIfDirty();
+            return state == InstallState::Installed || state == InstallState::Modified;
+        }
+
+        // The record of gameID, available or not
+        bool lookup(const string& gameID, InstallRecord& record) {
+            lock_guard<mutex> guard(lock);
+            drain();
+            auto found = installs.find(gameID);
+            if (found == installs.end()) return false;
+            record = found->second;
+            return true;
+        }
+
+        // Install state for a whole library view in one pass, touching the
+        // filesystem only for roots that are not being watched
+        vector<InstallState> states(const vector<string>& gameIDs) {
+            lock_guard<mutex> guard(lock);
+            drain();
+            vector<InstallState> result;
+            result.reserve(gameIDs.size());
+            for (const string& gameID : gameIDs) result.push_back(stateOf(gameID));
+            saveIfDirty();
+            return result;
+        }
+
+        size_t size() {
+            lock_guard<mutex> guard(lock);
+            drain();
+            return installs.size();
+        }
+};
+
+string registryPath() {
+    return libraryRoot() + "/installs.registry";
+}
+
+// The registry for the current library, loaded on first use
+InstallRegistry& installRegistry() {
+    static InstallRegistry registry(registryPath());
+    return registry;
+}
 
-// Placeholder function to check if a game is installed.
 bool isGameInstalled(const string& gameID) {
-    // Implementation goes here
-    return true; // Example: return true if the game is installed
+    return installRegistry().isInstalled(gameID);
 }
 
-// Placeholder function to check if game files are corrupted.
-bool filesAreCorrupted(const string& gameID) {
-    // Implementation goes here
-    return false; // Example: return false if the files are not corrupted
+// Checks the install against the game's manifest, rehashing only files
+// whose metadata changed since they last verified clean. report, when
+// given, receives the chunks that failed. Without a manifest nothing can be
+// trusted, so that counts as corrupted too.
+bool filesAreCorrupted(const string& gameID, VerifyReport* report = nullptr) {
+    Manifest manifest;
+    try {
+        manifest = loadManifest(manifestPath(gameID));
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return true;
+    }
+    VerificationJournal journal = VerificationJournal::load(journalPath(gameID));
+    VerifyReport result = verifyIncremental(installPath(gameID), manifest, journal);
+    try {
+        journal.save(journalPath(gameID));
+    } catch (const exception& e) {
+        cerr << e.what() << endl; // the next launch just hashes more
+    }
+    bool corrupted = !result.clean();
+    if (report) *report = move(result);
+    return corrupted;
+}
+
+// Full scrubs RunGame leaves running behind a launched game; main joins
+// them before exiting
+vector<thread> backgroundScrubs;
+
+// Rehashes the whole install on one thread, so the game keeps the rest of
+// the machine. Damaged files drop out of the journal, so the next launch
+// rehashes them and refuses to start.
+void scrubInBackground(const string& gameID) {
+    backgroundScrubs.emplace_back([gameID]() {
+        try {
+            Manifest manifest = loadManifest(manifestPath(gameID));
+            VerificationJournal journal = VerificationJournal::load(journalPath(gameID));
+            VerifyReport report = verifyIncremental(installPath(gameID), manifest, journal, true, 1);
+            journal.save(journalPath(gameID));
+            if (!report.clean()) {
+                cerr << "Scrub of " << gameID << " found " << report.badChunks.size() << " bad chunks, "
+                     << report.oversizedFiles.size() << " oversized files, " << report.missingFiles.size()
+                     << " missing files" << endl;
+            }
+        } catch (const exception& e) {
+            cerr << "Scrub of " << gameID << " failed: " << e.what() << endl;
+        }
+    });
+}
+
+// Content-defined chunking (FastCDC). A gear hash rolls over the bytes and
+// a chunk ends where its top bits are all zero, so cut points follow the
+// content rather than offsets: an insertion only disturbs the chunks around
+// it, and everything after still cuts the same way and dedupes.
+const uint64_t MinChunkSize = 256 << 10;
+const uint64_t AverageChunkSize = 1 << 20;
+const uint64_t MaxChunkSize = DefaultChunkSize;
+
+const uint64_t* gearTable() {
+    static const vector<uint64_t> table = []() {
+        vector<uint64_t> values(256);
+        uint64_t state = 0x6A09E667F3BCC908ULL; // fixed: cut points must agree everywhere
+        for (uint64_t& value : values) {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            value = z ^ (z >> 31);
+        }
+        return values;
+    }();
+    return table.data();
+}
+
+// Length of the chunk that starts at data, out of length bytes left. Before
+// the average size a stricter mask makes a cut less likely and after it a
+// looser one makes it more likely, which keeps chunks near the average.
+uint64_t nextCut(const unsigned char* data, uint64_t length) {
+    if (length <= MinChunkSize) return length;
+    const uint64_t* gear = gearTable();
+    const uint64_t strict = ~0ULL << (64 - 22), loose = ~0ULL << (64 - 18);
+    uint64_t end = min(length, MaxChunkSize), normal = min(end, AverageChunkSize);
+    uint64_t hash = 0, i = MinChunkSize;
+    for (; i < normal; ++i) {
+        hash = (hash << 1) + gear[data[i]];
+        if (!(hash & strict)) return i + 1;
+    }
+    for (; i < end; ++i) {
+        hash = (hash << 1) + gear[data[i]];
+        if (!(hash & loose)) return i + 1;
+    }
+    return end;
+}
+
+// An open file descriptor, closed when it goes out of scope
+class OpenFile {
+    private:
+        int fd;
+
+    public:
+        OpenFile(const string& path, int flags, mode_t mode = 0644) : fd(::open(path.c_str(), flags | O_CLOEXEC, mode)) {
+            if (fd < 0) throw runtime_error("Cannot open " + path + ": " + strerror(errno));
+        }
+        OpenFile(const OpenFile&) = delete;
+        OpenFile& operator=(const OpenFile&) = delete;
+        ~OpenFile() { ::close(fd); }
+
+        int get() const { return fd; }
+};
+
+// Copies count bytes between files inside the kernel, which on filesystems
+// with reflinks shares the extents instead of writing them. Falls back to
+// plain reads and writes where copy_file_range is unavailable.
+void copyRange(int from, uint64_t fromOffset, int to, uint64_t toOffset, uint64_t count) {
+    loff_t in = static_cast<loff_t>(fromOffset), out = static_cast<loff_t>(toOffset);
+    while (count > 0) {
+        ssize_t copied = ::copy_file_range(from, &in, to, &out, count, 0);
+        if (copied > 0) {
+            count -= static_cast<uint64_t>(copied);
+            continue;
+        }
+        if (copied == 0) throw runtime_error("Source ended early while copying a chunk");
+        if (errno == EINTR) continue;
+        if (errno != EXDEV && errno != ENOSYS && errno != EINVAL && errno != EOPNOTSUPP) {
+            throw runtime_error(string("Cannot copy a chunk: ") + strerror(errno));
+        }
+        vector<char> buffer(min<uint64_t>(count, 1 << 20));
+        while (count > 0) {
+            ssize_t got = ::pread(from, buffer.data(), min<uint64_t>(count, buffer.size()), in);
+            if (got <= 0) throw runtime_error("Source ended early while copying a chunk");
+            for (ssize_t put = 0; put < got;) {
+                ssize_t written = ::pwrite(to, buffer.data() + put, static_cast<size_t>(got - put), out + put);
+                if (written < 0) throw runtime_error(string("Cannot write a chunk: ") + strerror(errno));
+                put += written;
+            }
+            in += got;
+            out += got;
+            count -= static_cast<uint64_t>(got);
+        }
+    }
+}
+
+// Chunks stored by content, one file each under <root>/<aa>/<hash>-<length>,
+// so a chunk shared by several games or versions is kept and fetched once.
+// Every chunk is checked against its hash on the way in, and again before
+// an update copies it out: has() only looks at the size.
+class ChunkStore {
+    private:
+        string root;
+
+    public:
+        explicit ChunkStore(string storeRoot) : root(move(storeRoot)) {}
+
+        const string& path() const { return root; }
+
+        string chunkPath(const ChunkRef& chunk) const {
+            char name[48];
+            snprintf(name, sizeof(name), "%02x/%016llx-%llu", static_cast<unsigned>(chunk.hash >> 56),
+                     static_cast<unsigned long long>(chunk.hash), static_cast<unsigned long long>(chunk.length));
+            return root + "/" + name;
+        }
+
+        bool has(const ChunkRef& chunk) const {
+            struct stat info;
+            return ::stat(chunkPath(chunk).c_str(), &info) == 0 && static_cast<uint64_t>(info.st_size) == chunk.length;
+        }
+
+        // Rehashes a stored chunk. One that no longer matches is deleted so
+        // the next put stores a good copy.
+        bool verify(const ChunkRef& chunk) {
+            {
+                MappedFile stored(chunkPath(chunk));
+                if (stored.size() == chunk.length && stored.hashRange(0, chunk.length) == chunk.hash) return true;
+            }
+            ::unlink(chunkPath(chunk).c_str());
+            return false;
+        }
+
+        // Adds a chunk unless it is already stored. Concurrent puts of the same
+        // chunk each write their own temp file and the renames agree.
+        void put(const ChunkRef& chunk, const unsigned char* data) {
+            if (xxHash64(data, chunk.length) != chunk.hash) {
+                throw runtime_error("Chunk content does not match " + chunkPath(chunk));
+            }
+            if (has(chunk)) return;
+            static atomic<uint64_t> serial(0);
+            string target = chunkPath(chunk);
+            string temp = target + ".tmp" + to_string(::getpid()) + "-" + to_string(serial.fetch_add(1));
+            fs::create_directories(fs::path(target).parent_path());
+            {
+                OpenFile out(temp, O_WRONLY | O_CREAT | O_TRUNC);
+                for (uint64_t written = 0; written < chunk.length;) {
+                    ssize_t count = ::write(out.get(), data + written, chunk.length - written);
+                    if (count < 0) throw runtime_error("Cannot write chunk " + temp + ": " + strerror(errno));
+                    written += static_cast<uint64_t>(count);
+                }
+            }
+            if (rename(temp.c_str(), target.c_str()) != 0) throw runtime_error("Cannot store chunk " + target);
+        }
+};
+
+// Where chunks the store lacks come from. A client would fetch them from a
+// CDN; DirectoryChunkSource reads a mirror laid out as a ChunkStore, which
+// is also how updates are exercised without a network.
+class ChunkSource {
+    public:
+        virtual ~ChunkSource() = default;
+
+        // The chunk's bytes; throws when the source does not have it
+        virtual vector<unsigned char> fetch(const ChunkRef& chunk) = 0;
+};
+
+class DirectoryChunkSource : public ChunkSource {
+    private:
+        ChunkStore mirror;
+        atomic<uint64_t> fetched{0};
+
+    public:
+        explicit DirectoryChunkSource(string root) : mirror(move(root)) {}
+
+        vector<unsigned char> fetch(const ChunkRef& chunk) override {
+            ifstream in(mirror.chunkPath(chunk), ios::binary);
+            vector<unsigned char> data(chunk.length);
+            if (!in.read(reinterpret_cast<char*>(data.data()), static_cast<streamsize>(chunk.length))) {
+                throw runtime_error("Mirror has no chunk " + mirror.chunkPath(chunk));
+            }
+            fetched.fetch_add(chunk.length, memory_order_relaxed);
+            return data;
+        }
+
+        uint64_t bytesFetched() const { return fetched.load(); }
+};
+
+// parallelFor for work that may throw: the remaining items still run and
+// the first exception is rethrown once all threads are done
+template <typename Work>
+void parallelForEach(size_t count, unsigned threads, Work work) {
+    mutex failing;
+    exception_ptr failure;
+    parallelFor(count, threads, [&](size_t i) {
+        try {
+            work(i);
+        } catch (...) {
+            lock_guard<mutex> guard(failing);
+            if (!failure) failure = current_exception();
+        }
+    });
+    if (failure) rethrow_exception(failure);
+}
+
+// Chunks every regular file under root by content, stores the chunks the
+// store lacks and returns the manifest for the directory. This is the
+// publisher's half of an update; clients only read the manifest.
+Manifest publishInstall(const string& root, ChunkStore& store, unsigned threads = defaultThreads()) {
+    Manifest manifest = listFiles(root);
+    parallelForEach(manifest.files.size(), threads, [&](size_t f) {
+        ManifestFile& file = manifest.files[f];
+        MappedFile mapped(root + "/" + file.path);
+        file.size = mapped.size();
+        for (uint64_t offset = 0; offset < file.size;) {
+            uint64_t length = nextCut(mapped.data() + offset, file.size - offset);
+            ChunkRef chunk{offset, length, mapped.hashRange(offset, length)};
+            store.put(chunk, mapped.data() + offset);
+            file.chunks.push_back(chunk);
+            offset += length;
+        }
+    });
+    return manifest;
+}
+
+// What it takes to turn the current install into the target. Files whose
+// manifest entry is unchanged and that verified clean are left alone; every
+// other target file is rebuilt from pieces, each reused from the install or
+// the store, or fetched. Chunks that failed verification are never reused,
+// so updating to the same manifest repairs an install.
+struct UpdatePlan {
+    struct Piece {
+        bool fromStore;
+        size_t file; // in the current manifest, when not from the store
+        uint64_t offset;
+    };
+    vector<size_t> changedFiles; // in the target manifest
+    vector<vector<Piece>> pieces; // per changed file, per chunk
+    vector<ChunkRef> missing; // distinct chunks to fetch into the store
+    vector<string> removedFiles;
+    uint64_t fetchBytes = 0;
+    uint64_t reuseBytes = 0;
+};
+
+UpdatePlan planUpdate(const string& root, const Manifest& current, const VerifyReport& currentState,
+                      const Manifest& target, const ChunkStore& store) {
+    vector<uint8_t> damaged(current.files.size(), 0);
+    vector<vector<uint8_t>> badChunks(current.files.size());
+    for (const BadChunk& bad : currentState.badChunks) {
+        damaged[bad.file] = 1;
+        badChunks[bad.file].resize(current.files[bad.file].chunks.size(), 0);
+        badChunks[bad.file][bad.chunk] = 1;
+    }
+    for (size_t f : currentState.oversizedFiles) damaged[f] = 1;
+    for (size_t f : currentState.missingFiles) damaged[f] = 1;
+
+    unordered_map<string, size_t> currentByPath;
+    unordered_map<uint64_t, UpdatePlan::Piece> reusable; // chunk hash -> where the install has it
+    unordered_map<uint64_t, uint64_t> reusableLength;
+    for (size_t f = 0; f < current.files.size(); ++f) {
+        currentByPath[current.files[f].path] = f;
+        for (size_t c = 0; c < current.files[f].chunks.size(); ++c) {
+            if (!badChunks[f].empty() && badChunks[f][c]) continue;
+            const ChunkRef& chunk = current.files[f].chunks[c];
+            if (reusable.emplace(chunk.hash, UpdatePlan::Piece{false, f, chunk.offset}).second) {
+                reusableLength[chunk.hash] = chunk.length;
+            }
+        }
+    }
+
+    UpdatePlan plan;
+    unordered_set<uint64_t> planned;
+    for (size_t t = 0; t < target.files.size(); ++t) {
+        const ManifestFile& file = target.files[t];
+        auto old = currentByPath.find(file.path);
+        FileStamp stamp;
+        if (old != currentByPath.end() && !damaged[old->second] && entryHash(current.files[old->second]) == entryHash(file) &&
+            statFile(root + "/" + file.path, stamp)) {
+            continue;
+        }
+        plan.changedFiles.push_back(t);
+        plan.pieces.emplace_back();
+        for (const ChunkRef& chunk : file.chunks) {
+            auto local = reusable.find(chunk.hash);
+            if (local != reusable.end() && reusableLength[chunk.hash] == chunk.length) {
+                plan.pieces.back().push_back(local->second);
+                plan.reuseBytes += chunk.length;
+                continue;
+            }
+            plan.pieces.back().push_back({true, 0, 0});
+            if (store.has(chunk)) {
+                plan.reuseBytes += chunk.length;
+            } else if (planned.insert(chunk.hash).second) {
+                plan.missing.push_back(chunk);
+                plan.fetchBytes += chunk.length;
+            } else {
+                plan.reuseBytes += chunk.length; // fetched once for an earlier piece
+            }
+        }
+    }
+    unordered_set<string> targetPaths;
+    for (const ManifestFile& file : target.files) targetPaths.insert(file.path);
+    for (const ManifestFile& file : current.files) {
+        if (!targetPaths.count(file.path)) plan.removedFiles.push_back(file.path);
+    }
+    return plan;
+}
+
+struct UpdateReport {
+    uint64_t fetchedBytes = 0; // from the source
+    uint64_t reusedBytes = 0; // copied from the install or the store
+    size_t filesWritten = 0;
+    size_t filesRemoved = 0;
+    VerifyReport verify; // the install against the target afterwards
+};
+
+// Brings gameID's install to target: fetches the missing chunks into the
+// store, writes every changed file beside its old copy and syncs it, then
+// renames them all into place, removes dropped files, syncs the directories
+// and saves the target manifest. A crash before the manifest is saved
+// leaves the old manifest, which no longer verifies, and running the update
+// again finishes the job; the manifest never names content that is not on
+// disk. The install is registered under version once it verifies clean.
+UpdateReport updateGame(const string& gameID, const Manifest& target, const string& version, ChunkStore& store,
+                        ChunkSource& source, unsigned threads = defaultThreads()) {
+    const string root = installPath(gameID);
+    fs::create_directories(root);
+    fs::create_directories(libraryRoot() + "/manifests");
+    Manifest current;
+    if (fs::exists(manifestPath(gameID))) current = loadManifest(manifestPath(gameID));
+
+    // Every file the update writes, reads or removes has to stay inside the
+    // install, also through symlinked directories; target may not have come
+    // from loadManifest, so its paths are checked here too
+    const fs::path resolvedRoot = fs::weakly_canonical(root);
+    for (const Manifest* manifest : {&as_const(current), &target}) {
+        for (const ManifestFile& file : manifest->files) {
+            fs::path resolved = fs::weakly_canonical(fs::path(root) / file.path);
+            auto [rootEnd, pathEnd] = std::mismatch(resolvedRoot.begin(), resolvedRoot.end(), resolved.begin(), resolved.end());
+            if (!safeRelativePath(file.path) || rootEnd != resolvedRoot.end() || pathEnd == resolved.end()) {
+                throw runtime_error("Refusing to update " + gameID + ": " + file.path + " is outside the install");
+            }
+        }
+    }
+    VerificationJournal journal = VerificationJournal::load(journalPath(gameID));
+    VerifyReport currentState = verifyIncremental(root, current, journal, false, threads);
+    UpdatePlan plan = planUpdate(root, current, currentState, target, store);
+
+    // Chunks the plan takes from the store are rehashed first; a damaged one
+    // is fetched again like a missing one
+    vector<ChunkRef> stored;
+    unordered_set<uint64_t> listed;
+    for (const ChunkRef& chunk : plan.missing) listed.insert(chunk.hash);
+    for (size_t i = 0; i < plan.changedFiles.size(); ++i) {
+        const ManifestFile& file = target.files[plan.changedFiles[i]];
+        for (size_t c = 0; c < file.chunks.size(); ++c) {
+            if (plan.pieces[i][c].fromStore && listed.insert(file.chunks[c].hash).second) stored.push_back(file.chunks[c]);
+        }
+    }
+    vector<uint8_t> damaged(stored.size(), 0);
+    parallelFor(stored.size(), threads, [&](size_t i) { damaged[i] = !store.verify(stored[i]); });
+    for (size_t i = 0; i < stored.size(); ++i) {
+        if (!damaged[i]) continue;
+        cerr << "Fetching " << store.chunkPath(stored[i]) << " again: the stored copy is damaged" << endl;
+        plan.missing.push_back(stored[i]);
+        plan.fetchBytes += stored[i].length;
+        plan.reuseBytes -= stored[i].length;
+    }
+
+    parallelForEach(plan.missing.size(), threads, [&](size_t i) {
+        vector<unsigned char> data = source.fetch(plan.missing[i]);
+        if (data.size() != plan.missing[i].length) throw runtime_error("Fetched chunk has the wrong length");
+        store.put(plan.missing[i], data.data());
+    });
+
+    // Staged files read the old ones, so nothing is renamed until all are
+    // written
+    auto staged = [&](size_t i) { return root + "/" + target.files[plan.changedFiles[i]].path + ".rungame-update"; };
+    parallelForEach(plan.changedFiles.size(), threads, [&](size_t i) {
+        const ManifestFile& file = target.files[plan.changedFiles[i]];
+        fs::create_directories(fs::path(root + "/" + file.path).parent_path());
+        OpenFile out(staged(i), O_WRONLY | O_CREAT | O_TRUNC);
+        if (::ftruncate(out.get(), static_cast<off_t>(file.size)) != 0) {
+            throw runtime_error("Cannot size " + staged(i) + ": " + strerror(errno));
+        }
+        unordered_map<size_t, unique_ptr<OpenFile>> sources; // current file -> descriptor
+        for (size_t c = 0; c < file.chunks.size(); ++c) {
+            const ChunkRef& chunk = file.chunks[c];
+            const UpdatePlan::Piece& piece = plan.pieces[i][c];
+            if (piece.fromStore) {
+                OpenFile in(store.chunkPath(chunk), O_RDONLY);
+                copyRange(in.get(), 0, out.get(), chunk.offset, chunk.length);
+            } else {
+                unique_ptr<OpenFile>& in = sources[piece.file];
+                if (!in) in = make_unique<OpenFile>(root + "/" + current.files[piece.file].path, O_RDONLY);
+                copyRange(in->get(), piece.offset, out.get(), chunk.offset, chunk.length);
+            }
+        }
+        if (::fdatasync(out.get()) != 0) throw runtime_error("Cannot sync " + staged(i) + ": " + strerror(errno));
+    });
+    // Every directory whose entries the renames and removals change, up to
+    // the library that holds the install and manifests directories
+    unordered_set<string> touched{libraryRoot(), root, libraryRoot() + "/manifests"};
+    auto touch = [&](const string& path) {
+        for (fs::path directory = fs::path(path).parent_path(); !directory.empty(); directory = directory.parent_path()) {
+            if (!touched.insert(root + "/" + directory.string()).second) break;
+        }
+    };
+    for (size_t i = 0; i < plan.changedFiles.size(); ++i) {
+        string final = root + "/" + target.files[plan.changedFiles[i]].path;
+        if (rename(staged(i).c_str(), final.c_str()) != 0) throw runtime_error("Cannot replace " + final);
+        touch(target.files[plan.changedFiles[i]].path);
+    }
+    UpdateReport report;
+    for (const string& path : plan.removedFiles) {
+        error_code ignored;
+        report.filesRemoved += fs::remove(root + "/" + path, ignored);
+        touch(path);
+    }
+    for (const string& directory : touched) {
+        if (fs::is_directory(directory)) syncToDisk(directory);
+    }
+    saveManifest(target, manifestPath(gameID));
+
+    report.fetchedBytes = plan.fetchBytes;
+    report.reusedBytes = plan.reuseBytes;
+    report.filesWritten = plan.changedFiles.size();
+    report.verify = verifyIncremental(root, target, journal, false, threads);
+    try {
+        journal.save(journalPath(gameID));
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+    }
+    if (report.verify.clean()) {
+        InstallRecord record;
+        record.root = root;
+        record.version = version;
+        record.manifestId = manifestId(target);
+        for (const ManifestFile& file : target.files) record.size += file.size;
+        installRegistry().registerInstall(gameID, record);
+    }
+    return report;
 }
 
 // Placeholder function to start the game.
@@ -27,19 +1449,536 @@ string RunGame(const string& gameID) {
         return "Game not installed";
     }
 
-    if (filesAreCorrupted(gameID)) {
-        return "Corrupted files";
+    VerifyReport report;
+    if (filesAreCorrupted(gameID, &report)) {
+        if (report.clean()) return "Corrupted files";
+        return "Corrupted files: " + to_string(report.badChunks.size()) + " bad chunks, " +
+            to_string(report.oversizedFiles.size()) + " oversized files, " +
+            to_string(report.missingFiles.size()) + " missing files";
     }
 
     startGame(gameID);
+    if (scrubDue(gameID)) scrubInBackground(gameID);
     return "Game started successfully";
 }
 
-int main() {
-    string gameID = "example_game_id";
+// Writes n pseudo-random bytes to path
+void writeNoise(const string& path, uint64_t n, uint64_t seed) {
+    vector<uint64_t> block(1 << 17);
+    ofstream out(path, ios::binary | ios::trunc);
+    for (uint64_t written = 0; written < n;) {
+        for (uint64_t& word : block) {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            word = seed;
+        }
+        uint64_t count = min<uint64_t>(n - written, block.size() * sizeof(uint64_t));
+        out.write(reinterpret_cast<const char*>(block.data()), static_cast<streamsize>(count));
+        written += count;
+    }
+}
+
+// Drops a file's pages from the page cache so the next read comes from disk
+void evictFromCache(const string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    ::fdatasync(fd);
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+}
+
+// Verification of a generated install of totalMiB across 1 thread and all
+// cores, warm and cold, then launches through the journal, plus a single
+// flipped byte to show the report. False when any result is not the one
+// expected.
+bool benchmarkVerify(uint64_t totalMiB) {
+    const string library = (fs::temp_directory_path() / "rungame-bench").string();
+    ::setenv("RUNGAME_LIBRARY", library.c_str(), 1);
+    const string root = installPath("bench");
+    fs::remove_all(library);
+    fs::create_directories(root + "/data");
+    fs::create_directories(library + "/manifests");
+    const uint64_t fileBytes = 256ull << 20;
+    uint64_t remaining = totalMiB << 20;
+    vector<string> paths;
+    for (int i = 0; remaining > 0; ++i) {
+        paths.push_back(root + "/data/pak" + to_string(i) + ".bin");
+        writeNoise(paths.back(), min(fileBytes, remaining), 88172645463325252ull + i);
+        remaining -= min(fileBytes, remaining);
+    }
+
+    auto seconds = [](auto start) {
+        return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    };
+    auto start = chrono::steady_clock::now();
+    Manifest manifest = buildManifest(root);
+    double built = seconds(start);
+    saveManifest(manifest, manifestPath("bench"));
+    double gib = static_cast<double>(totalMiB) / 1024;
+    cout << totalMiB << " MiB in " << paths.size() << " files: manifest built in " << built << " s\n";
+
+    bool expected = true;
+    vector<unsigned> threadCounts = {1};
+    if (defaultThreads() > 1) threadCounts.push_back(defaultThreads());
+    for (unsigned threads : threadCounts) {
+        start = chrono::steady_clock::now();
+        VerifyReport warm = verifyInstall(root, manifest, threads);
+        double warmSeconds = seconds(start);
+        for (const string& path : paths) evictFromCache(path);
+        start = chrono::steady_clock::now();
+        VerifyReport cold = verifyInstall(root, manifest, threads);
+        double coldSeconds = seconds(start);
+        cout << threads << " threads: warm " << gib / warmSeconds << " GiB/s, cold " << gib / coldSeconds
+             << " GiB/s (" << (warm.clean() && cold.clean() ? "clean" : "NOT CLEAN") << ")\n";
+        expected = expected && warm.clean() && cold.clean();
+    }
+
+    // Launch checks as RunGame makes them: manifest and journal from disk,
+    // once the files are old enough to be journaled
+    this_thread::sleep_for(chrono::nanoseconds(RacyWindowNs));
+    for (const char* launch : {"first launch", "next launch"}) {
+        VerifyReport report;
+        start = chrono::steady_clock::now();
+        bool corrupted = filesAreCorrupted("bench", &report);
+        cout << launch << ": " << seconds(start) * 1000 << " ms, " << report.filesSkipped << " files skipped, "
+             << (report.bytesHashed >> 20) << " MiB hashed (" << (corrupted ? "corrupted" : "clean") << ")\n";
+        expected = expected && !corrupted;
+    }
+
+    {
+        fstream file(paths.back(), ios::binary | ios::in | ios::out);
+        file.seekp(12345);
+        file.put('\x7f');
+    }
+    VerifyReport damaged;
+    start = chrono::steady_clock::now();
+    filesAreCorrupted("bench", &damaged);
+    cout << "after one write: " << seconds(start) * 1000 << " ms, " << damaged.filesSkipped << " files skipped, "
+         << (damaged.bytesHashed >> 20) << " MiB hashed\n";
+    for (const BadChunk& bad : damaged.badChunks) {
+        const ChunkRef& chunk = manifest.files[bad.file].chunks[bad.chunk];
+        cout << "Bad chunk: " << manifest.files[bad.file].path << " bytes " << chunk.offset << "-"
+             << chunk.offset + chunk.length << "\n";
+    }
+    fs::remove_all(library);
+    return expected && damaged.badChunks.size() == 1;
+}
+
+// Registry of games installs, each a small tree: registration, startup,
+// lookups and a library view, then an install removed and another written
+// to behind the client's back. False when the registry misreads either.
+bool benchmarkRegistry(size_t games) {
+    const string library = (fs::temp_directory_path() / "rungame-registry").string();
+    ::setenv("RUNGAME_LIBRARY", library.c_str(), 1);
+    fs::remove_all(library);
+    vector<string> owned;
+    for (size_t i = 0; i < games; ++i) {
+        string gameID = "game" + to_string(i);
+        owned.push_back(gameID);
+        owned.push_back("notinstalled" + to_string(i));
+        for (const char* directory : {"/bin", "/data/maps", "/data/audio"}) {
+            fs::create_directories(installPath(gameID) + directory);
+            ofstream(installPath(gameID) + directory + "/file") << gameID;
+        }
+    }
+
+    auto seconds = [](auto start) {
+        return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    };
+    auto start = chrono::steady_clock::now();
+    {
+        InstallRegistry registry(registryPath());
+        for (size_t i = 0; i < games; ++i) {
+            InstallRecord record;
+            record.root = installPath("game" + to_string(i));
+            record.version = "1.0";
+            record.size = 3 * 16;
+            registry.registerInstall("game" + to_string(i), record);
+        }
+    }
+    cout << games << " installs registered in " << seconds(start) << " s\n";
+
+    start = chrono::steady_clock::now();
+    auto registry = make_unique<InstallRegistry>(registryPath());
+    cout << "startup (load and watch " << registry->size() << " installs): " << seconds(start) * 1000 << " ms\n";
+
+    const size_t lookups = 1000000;
+    size_t found = 0;
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < lookups; ++i) found += registry->isInstalled(owned[i % owned.size()]);
+    cout << "isInstalled: " << seconds(start) / lookups * 1e9 << " ns per lookup (" << found << " installed)\n";
+
+    start = chrono::steady_clock::now();
+    vector<InstallState> view = registry->states(owned);
+    cout << "library view of " << owned.size() << " owned games: " << seconds(start) * 1000 << " ms\n";
+
+    fs::remove_all(installPath("game0"));
+    ofstream(installPath("game1") + "/data/maps/extra") << "mod";
+    view = registry->states({"game0", "game1", "game2"});
+    cout << "after removing game0 and writing into game1: " << (registry->isInstalled("game0") ? "installed" : "not installed")
+         << ", " << (view[1] == InstallState::Modified ? "modified" : "NOT MODIFIED") << ", "
+         << (view[2] == InstallState::Installed ? "installed" : "NOT INSTALLED") << "\n";
+    bool expected = !registry->isInstalled("game0") && view[1] == InstallState::Modified &&
+        view[2] == InstallState::Installed;
+    registry.reset(); // stop watching before the library goes
+    fs::remove_all(library);
+    return expected;
+}
+
+// Publishes a generated game of totalMiB to a mirror and installs it, then
+// publishes a patch (an insertion that shifts a file's tail, an overwrite,
+// a new file and a removed one) and updates to it, then installs a second
+// game built from the same content. False when any install does not verify.
+bool benchmarkUpdate(uint64_t totalMiB) {
+    const string temp = fs::temp_directory_path().string();
+    const string library = temp + "/rungame-update", publisher = temp + "/rungame-publish", mirrorRoot = temp + "/rungame-mirror";
+    ::setenv("RUNGAME_LIBRARY", library.c_str(), 1);
+    for (const string& directory : {library, publisher, mirrorRoot}) fs::remove_all(directory);
+    fs::create_directories(publisher + "/data");
+    const uint64_t fileBytes = max<uint64_t>((totalMiB << 20) / 4, 1 << 20);
+    for (int i = 0; i < 4; ++i) writeNoise(publisher + "/data/pak" + to_string(i) + ".bin", fileBytes, 2463534242ull + i);
+
+    auto seconds = [](auto start) {
+        return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    };
+    auto mib = [](uint64_t bytes) { return static_cast<double>(bytes) / (1 << 20); };
+    ChunkStore mirror(mirrorRoot), store(libraryRoot() + "/chunks");
+    DirectoryChunkSource cdn(mirrorRoot);
+    auto start = chrono::steady_clock::now();
+    Manifest v1 = publishInstall(publisher, mirror);
+    size_t chunks = 0;
+    for (const ManifestFile& file : v1.files) chunks += file.chunks.size();
+    cout << "published " << mib(4 * fileBytes) << " MiB as " << chunks << " chunks (average "
+         << mib(4 * fileBytes) / chunks << " MiB) in " << seconds(start) << " s\n";
+
+    bool expected = true;
+    auto update = [&](const string& gameID, const Manifest& target, const string& label) {
+        auto began = chrono::steady_clock::now();
+        UpdateReport report = updateGame(gameID, target, label, store, cdn);
+        cout << label << ": fetched " << mib(report.fetchedBytes) << " MiB, reused " << mib(report.reusedBytes)
+             << " MiB, " << report.filesWritten << " files written, " << report.filesRemoved << " removed in "
+             << seconds(began) << " s (" << (report.verify.clean() ? "clean" : "NOT CLEAN") << ")\n";
+        expected = expected && report.verify.clean();
+    };
+    update("bench", v1, "install 1.0");
+
+    {
+        const string path = publisher + "/data/pak0.bin";
+        ifstream in(path, ios::binary);
+        string content((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        in.close();
+        writeNoise(temp + "/rungame-insert", 3 << 20, 99);
+        ifstream insert(temp + "/rungame-insert", ios::binary);
+        string inserted((istreambuf_iterator<char>(insert)), istreambuf_iterator<char>());
+        fs::remove(temp + "/rungame-insert");
+        content.insert(content.size() / 2, inserted);
+        ofstream(path, ios::binary | ios::trunc) << content;
+    }
+    {
+        writeNoise(temp + "/rungame-overwrite", 2 << 20, 7);
+        ifstream in(temp + "/rungame-overwrite", ios::binary);
+        string patch((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        fs::remove(temp + "/rungame-overwrite");
+        fstream file(publisher + "/data/pak1.bin", ios::binary | ios::in | ios::out);
+        file.seekp(static_cast<streamoff>(fileBytes / 3));
+        file.write(patch.data(), static_cast<streamsize>(patch.size()));
+    }
+    writeNoise(publisher + "/data/new.bin", 1 << 20, 5);
+    fs::remove(publisher + "/data/pak3.bin");
+    Manifest v2 = publishInstall(publisher, mirror);
+    update("bench", v2, "update to 1.1 (6 MiB changed)");
+    update("bench-goty", v2, "second game from the same content");
+
+    VerifyReport verify;
+    bool corrupted = filesAreCorrupted("bench", &verify);
+    cout << "launch check after update: " << (corrupted ? "corrupted" : "clean") << "\n";
+    for (const char* gameID : {"bench", "bench-goty"}) installRegistry().unregister(gameID);
+    for (const string& directory : {library, publisher, mirrorRoot}) fs::remove_all(directory);
+    return expected && !corrupted;
+}
+
+// Tests, run with --test [name] against directories under the temp
+// directory: each prints what failed and returns false, and main exits
+// nonzero if any did.
+bool expect(bool ok, const string& what) {
+    if (!ok) cout << "  FAILED: " << what << "\n";
+    return ok;
+}
+
+size_t fileIndex(const Manifest& manifest, const string& path) {
+    for (size_t f = 0; f < manifest.files.size(); ++f) {
+        if (manifest.files[f].path == path) return f;
+    }
+    throw runtime_error("No " + path + " in the manifest");
+}
+
+// A flipped byte is reported as exactly its chunk, and a deleted file with
+// no chunks as missing
+bool testVerify(const string& directory) {
+    const string root = directory + "/install";
+    fs::create_directories(root + "/data");
+    writeNoise(root + "/data/pak.bin", 10 * 4096, 1);
+    writeNoise(root + "/data/other.bin", 3 * 4096 + 5, 2);
+    ofstream(root + "/empty.cfg").close();
+    Manifest manifest = buildManifest(root, 4096);
+    bool passed = expect(verifyInstall(root, manifest).clean(), "fresh install verifies");
+
+    {
+        fstream file(root + "/data/pak.bin", ios::binary | ios::in | ios::out);
+        file.seekg(3 * 4096 + 17);
+        char byte = static_cast<char>(file.get());
+        file.seekp(3 * 4096 + 17);
+        file.put(static_cast<char>(byte ^ 1));
+    }
+    VerifyReport flipped = verifyInstall(root, manifest);
+    size_t pak = fileIndex(manifest, "data/pak.bin");
+    passed &= expect(flipped.badChunks.size() == 1 && flipped.badChunks[0].file == pak &&
+                     flipped.badChunks[0].chunk == 3 && flipped.missingFiles.empty() && flipped.oversizedFiles.empty(),
+                     "flipped byte reported as chunk 3 of data/pak.bin only");
+
+    writeNoise(root + "/data/pak.bin", 10 * 4096, 1);
+    fs::remove(root + "/empty.cfg");
+    VerifyReport deleted = verifyInstall(root, manifest);
+    passed &= expect(deleted.badChunks.empty() && deleted.missingFiles.size() == 1 &&
+                     deleted.missingFiles[0] == fileIndex(manifest, "empty.cfg"), "deleted empty file reported missing");
+    passed &= expect(!deleted.clean(), "install without the empty file is not clean");
+    return passed;
+}
+
+// The journal skips files it verified, and rehashes one whose mtime moved
+// even though its content did not
+bool testJournal(const string& directory) {
+    const string root = directory + "/install";
+    fs::create_directories(root);
+    for (int i = 0; i < 4; ++i) writeNoise(root + "/file" + to_string(i), 20000, 10 + i);
+    Manifest manifest = buildManifest(root, 4096);
+    this_thread::sleep_for(chrono::nanoseconds(RacyWindowNs)); // old enough to journal
+
+    VerificationJournal journal;
+    VerifyReport first = verifyIncremental(root, manifest, journal);
+    bool passed = expect(first.clean() && first.filesSkipped == 0 && journal.size() == 4, "first pass hashes and journals everything");
+    VerifyReport second = verifyIncremental(root, manifest, journal);
+    passed &= expect(second.clean() && second.filesSkipped == 4 && second.bytesHashed == 0, "second pass skips every file");
+
+    struct timespec times[2] = {{0, UTIME_OMIT}, {1000000000, 0}};
+    passed &= expect(::utimensat(AT_FDCWD, (root + "/file2").c_str(), times, 0) == 0, "mtime of file2 changed");
+    VerifyReport third = verifyIncremental(root, manifest, journal);
+    passed &= expect(third.clean() && third.filesSkipped == 3 && third.bytesHashed == 20000, "file2 alone rehashed after its mtime moved");
+    return passed;
+}
+
+// The registry drops a malformed line, keeps a game whose root is missing
+// as unavailable, forgets a root it sees removed and marks one written to
+// as modified
+bool testRegistry(const string& directory) {
+    const string path = directory + "/installs.registry";
+    for (const char* game : {"kept", "removed"}) fs::create_directories(directory + "/" + game + "/data");
+    {
+        ofstream out(path);
+        out << "registry 1\n"
+            << "kept\t" << directory << "/kept\t1.0\t1f\t10\t0\n"
+            << "broken\t" << directory << "/kept\t1.0\tnot-hex\t10\t0\n"
+            << "away\t" << directory << "/unmounted\t1.0\t2f\t10\t0\n";
+    }
+    bool passed = true;
+    {
+        InstallRegistry registry(path);
+        passed &= expect(registry.size() == 2, "malformed line dropped, the other two kept");
+        InstallRecord record;
+        passed &= expect(registry.lookup("away", record) && !registry.isInstalled("away") &&
+                         registry.states({"away"})[0] == InstallState::Unavailable, "game with a missing root unavailable");
+
+        record.root = directory + "/removed";
+        record.version = "1.0";
+        registry.registerInstall("removed", record);
+        fs::remove_all(directory + "/removed");
+        passed &= expect(!registry.isInstalled("removed") && !registry.lookup("removed", record), "removed root forgotten");
+
+        ofstream(directory + "/kept/data/mod.pak") << "mod";
+        passed &= expect(registry.states({"kept"})[0] == InstallState::Modified, "root written to marked modified");
+
+        fs::create_directories(directory + "/unmounted");
+        passed &= expect(registry.states({"away"})[0] == InstallState::Modified, "returning root available again, as modified");
+    }
+    InstallRegistry reloaded(path);
+    InstallRecord record;
+    passed &= expect(reloaded.size() == 2 && reloaded.lookup("kept", record) && record.modified &&
+                     reloaded.lookup("away", record) && !reloaded.lookup("removed", record), "registry file matches on reload");
+    return passed;
+}
+
+// An update fetches exactly the chunks the new version does not share with
+// the old one, and updating again repairs a damaged install and store
+bool testUpdate(const string& directory) {
+    const string publisher = directory + "/publisher", mirrorRoot = directory + "/mirror";
+    fs::create_directories(publisher + "/data");
+    for (int i = 0; i < 4; ++i) writeNoise(publisher + "/data/pak" + to_string(i) + ".bin", 2 << 20, 20 + i);
+    ChunkStore mirror(mirrorRoot), store(libraryRoot() + "/chunks");
+    DirectoryChunkSource cdn(mirrorRoot);
+    Manifest v1 = publishInstall(publisher, mirror);
+    UpdateReport install = updateGame("delta", v1, "1.0", store, cdn);
+    bool passed = expect(install.verify.clean() && install.fetchedBytes == 4 * (2 << 20), "first install fetches everything");
+
+    writeNoise(directory + "/patch", 64 << 10, 7);
+    {
+        ifstream in(directory + "/patch", ios::binary);
+        string patch((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        fstream file(publisher + "/data/pak1.bin", ios::binary | ios::in | ios::out);
+        file.seekp(1 << 20);
+        file.write(patch.data(), static_cast<streamsize>(patch.size()));
+    }
+    Manifest v2 = publishInstall(publisher, mirror);
+    unordered_set<uint64_t> old, fresh;
+    for (const ManifestFile& file : v1.files) {
+        for (const ChunkRef& chunk : file.chunks) old.insert(chunk.hash);
+    }
+    uint64_t changed = 0;
+    for (const ManifestFile& file : v2.files) {
+        for (const ChunkRef& chunk : file.chunks) {
+            if (!old.count(chunk.hash) && fresh.insert(chunk.hash).second) changed += chunk.length;
+        }
+    }
+    uint64_t before = cdn.bytesFetched();
+    UpdateReport update = updateGame("delta", v2, "1.1", store, cdn);
+    passed &= expect(update.verify.clean() && update.filesWritten == 1, "update rewrites only data/pak1.bin");
+    passed &= expect(changed > 0 && changed < (2 << 20) && update.fetchedBytes == changed &&
+                     cdn.bytesFetched() - before == changed, "update fetches only the changed chunks");
+
+    const ChunkRef& chunk = v2.files[fileIndex(v2, "data/pak2.bin")].chunks[0];
+    for (const string& damaged : {installPath("delta") + "/data/pak2.bin", store.chunkPath(chunk)}) {
+        fstream file(damaged, ios::binary | ios::in | ios::out);
+        file.put('\0');
+        file.put('\0');
+    }
+    UpdateReport repair = updateGame("delta", v2, "1.1", store, cdn);
+    passed &= expect(repair.verify.clean() && repair.fetchedBytes == chunk.length && !filesAreCorrupted("delta"),
+                     "updating to the same manifest refetches the damaged chunk and repairs the install");
+    installRegistry().unregister("delta");
+    return passed;
+}
+
+// Manifest paths that climb out of the install are refused before anything
+// is written
+bool testPaths(const string& directory) {
+    const string path = directory + "/escape.manifest";
+    ofstream(path) << "manifest 1\nfile 3 1 ../escape\n0 3 " << hex << xxHash64("abc", 3) << dec << "\n";
+    bool refused = false;
+    try {
+        loadManifest(path);
+    } catch (const runtime_error&) {
+        refused = true;
+    }
+    bool passed = expect(refused, "loadManifest refuses ../escape");
+
+    Manifest target;
+    target.files.push_back({"../outside", 3, {{0, 3, xxHash64("abc", 3)}}});
+    ChunkStore store(directory + "/chunks");
+    store.put(target.files[0].chunks[0], reinterpret_cast<const unsigned char*>("abc"));
+    DirectoryChunkSource source(directory + "/chunks");
+    refused = false;
+    try {
+        updateGame("escape", target, "1.0", store, source);
+    } catch (const runtime_error&) {
+        refused = true;
+    }
+    passed &= expect(refused && !fs::exists(libraryRoot() + "/outside"), "updateGame refuses ../outside and writes nothing there");
+    return passed;
+}
+
+// Runs the named test, or every one; false if any failed
+bool runTests(const string& only) {
+    const string library = (fs::temp_directory_path() / "rungame-test").string();
+    ::setenv("RUNGAME_LIBRARY", library.c_str(), 1);
+    fs::remove_all(library);
+    const pair<const char*, bool (*)(const string&)> tests[] = {
+        {"verify", testVerify}, {"journal", testJournal}, {"registry", testRegistry},
+        {"update", testUpdate}, {"paths", testPaths},
+    };
+    bool passed = true, ran = false;
+    for (const auto& [name, test] : tests) {
+        if (!only.empty() && only != name) continue;
+        ran = true;
+        const string directory = library + "/" + name;
+        fs::create_directories(directory);
+        bool ok = false;
+        try {
+            ok = test(directory);
+        } catch (const exception& e) {
+            cout << "  FAILED: " << e.what() << "\n";
+        }
+        cout << name << ": " << (ok ? "passed" : "FAILED") << "\n";
+        passed = passed && ok;
+    }
+    fs::remove_all(library);
+    if (!ran) cout << "No test named " << only << "\n";
+    return passed && ran;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc >= 3 && string(argv[1]) == "--bench" && string(argv[2]) == "verify") {
+        // --bench verify [MiB], 2 GiB by default
+        return benchmarkVerify(argc >= 4 ? stoull(argv[3]) : 2048) ? 0 : 1;
+    }
+    if (argc >= 3 && string(argv[1]) == "--bench" && string(argv[2]) == "registry") {
+        // --bench registry [games], 2000 installs by default
+        return benchmarkRegistry(argc >= 4 ? stoull(argv[3]) : 2000) ? 0 : 1;
+    }
+    if (argc >= 3 && string(argv[1]) == "--bench" && string(argv[2]) == "update") {
+        // --bench update [MiB], 1 GiB by default
+        return benchmarkUpdate(argc >= 4 ? stoull(argv[3]) : 1024) ? 0 : 1;
+    }
+    if (argc >= 2 && string(argv[1]) == "--test") {
+        // --test [verify|journal|registry|update|paths], all by default
+        return runTests(argc >= 3 ? argv[2] : "") ? 0 : 1;
+    }
+    if (argc >= 5 && string(argv[1]) == "--publish") {
+        // --publish <directory> <mirror> <manifest> chunks a build into a
+        // mirror and writes the manifest clients update to
+        ChunkStore mirror(argv[3]);
+        Manifest manifest = publishInstall(argv[2], mirror);
+        saveManifest(manifest, argv[4]);
+        cout << "Published " << manifest.files.size() << " files to " << argv[3] << endl;
+        return 0;
+    }
+    if (argc >= 5 && string(argv[1]) == "--update") {
+        // --update <gameID> <manifest> <mirror> [version] installs or updates
+        // a game, fetching only the chunks the library's store lacks
+        ChunkStore store(libraryRoot() + "/chunks");
+        DirectoryChunkSource mirror(argv[4]);
+        UpdateReport report = updateGame(argv[2], loadManifest(argv[3]), argc >= 6 ? argv[5] : "local", store, mirror);
+        cout << "Fetched " << report.fetchedBytes << " bytes, reused " << report.reusedBytes << " bytes, wrote "
+             << report.filesWritten << " files, removed " << report.filesRemoved << endl;
+        if (!report.verify.clean()) {
+            cout << "Install does not verify: " << report.verify.badChunks.size() << " bad chunks, "
+                 << report.verify.missingFiles.size() << " missing files, "
+                 << report.verify.oversizedFiles.size() << " oversized files" << endl;
+            return 1;
+        }
+        return 0;
+    }
+    if (argc >= 3 && string(argv[1]) == "--manifest") {
+        // --manifest <gameID> [version] hashes the current install as the
+        // trusted copy and registers it as installed
+        string gameID = argv[2];
+        fs::create_directories(libraryRoot() + "/manifests");
+        Manifest manifest = buildManifest(installPath(gameID));
+        saveManifest(manifest, manifestPath(gameID));
+        InstallRecord record;
+        record.root = installPath(gameID);
+        record.version = argc >= 4 ? argv[3] : "local";
+        record.manifestId = manifestId(manifest);
+        for (const ManifestFile& file : manifest.files) record.size += file.size;
+        installRegistry().registerInstall(gameID, record);
+        cout << "Wrote " << manifest.files.size() << " files to " << manifestPath(gameID) << endl;
+        return 0;
+    }
+
+    string gameID = argc >= 2 ? argv[1] : "example_game_id";
     string result = RunGame(gameID);
 
     cout << result << endl;
+    for (thread& scrub : backgroundScrubs) scrub.join();
 
     return 0;
 }
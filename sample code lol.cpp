@@ -1,5 +1,6 @@
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 #include <algorithm>
@@ -7,6 +8,48 @@
 #include <ctime>
 #include <limits>
 #include <random> // Required for random number generation
+#include <cstdint>
+#include <array>
+#include <memory>
+#include <new>
+#include <cstddef>
+#include <iterator>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <shared_mutex>
+#include <tuple>
+#include <atomic>
+#include <set>
+#include <map>
+#include <cmath>
+#include <queue>
+#include <deque>
+#include <functional>
+#include <future>
+#include <numeric>
+#include <cctype>
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MARKETPLACE_X86_KERNELS 1
+#endif
 
 // Forward declarations
 class Game;
@@ -30,1453 +73,8419 @@ enum class GameRating {
   AO // Adults Only
 };
 
-// Game Class
-class Game {
+// Slab allocator that owns every object of one entity type. Objects never
+// move once created, so the returned pointers stay valid as handles until
+// destroy() or until the pool itself goes away, which frees everything in bulk.
+template < typename T, size_t SlabSize = 1024 >
+class ObjectPool {
   private:
-    std::string gameId;
-    std::string title;
-    std::string description;
-    double price;
-    std::string genre;
-    GameRating rating;
-    std::time_t releaseDate;
-    std::string developerName;
-    double averageUserRating;
-    int totalReviews;
-    std::vector < std::pair < std::string,
-    int >> reviews;
+    struct Slot {
+      alignas(T) unsigned char storage[sizeof(T)];
+      bool live;
+    };
+
+    std::vector < std::unique_ptr < Slot[] >> slabs;
+    std::vector < Slot * > freeSlots;
+    size_t usedInLastSlab = SlabSize;
+    size_t liveCount = 0;
+    size_t peakCount = 0;
+    size_t createdCount = 0;
+
+    static Slot * slotOf(T * object) {
+      return reinterpret_cast < Slot * > (reinterpret_cast < unsigned char * > (object) - offsetof(Slot, storage));
+    }
 
   public:
-    Game(const std::string & id,
-    const std::string & title,
-    const std::string & description, double price,
-    const std::string & genre, GameRating rating,
-    const std::string & developer)
-    : gameId(id),
-    title(title),
-    description(description),
-    price(price),
-    genre(genre),
-    rating(rating),
-    developerName(developer),
-    averageUserRating(0.0),
-    totalReviews(0) {
-    releaseDate = std::time(nullptr);
-  }
-
-  // Getters
-  std::string getGameId() const {
-    return gameId;
-  }
-  std::string getTitle() const {
-    return title;
-  }
-  double getPrice() const {
-    return price;
-  }
-  GameRating getRating() const {
-    return rating;
-  }
-  std::string getGenre() const {
-    return genre;
-  }
-  double getAverageRating() const {
-    return averageUserRating;
-  }
-  std::string getDescription() const {
-    return description;
-  }
-  std::string getDeveloperName() const {
-    return developerName;
-  }
-  const std::vector < std::pair < std::string, int >> & getReviews() const {
-    return reviews;
-  }
-  std::time_t getReleaseDate() const {
-    return releaseDate;
+    struct Stats {
+      size_t live;
+      size_t peak;
+      size_t created;
+      size_t slabs;
+      size_t bytesReserved;
+    };
+
+    ObjectPool() = default;
+    ObjectPool(const ObjectPool & ) = delete;
+    ObjectPool & operator = (const ObjectPool & ) = delete;
+
+    ~ObjectPool() {
+      clear();
     }
 
-  // Method to add review
-  void addReview(const std::string & reviewText, int starRating) {
-    if (starRating < 1 || starRating > 5) {
-      throw std::invalid_argument("Rating must be between 1 and 5");
+    template < typename...Args >
+    T * create(Args && ...args) {
+      Slot * slot;
+      if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+      } else {
+        if (usedInLastSlab == SlabSize) {
+          slabs.emplace_back(new Slot[SlabSize]);
+          for (size_t i = 0; i < SlabSize; ++i) slabs.back()[i].live = false;
+          usedInLastSlab = 0;
+        }
+        slot = & slabs.back()[usedInLastSlab++];
+      }
+      T * object = new(slot -> storage) T(std::forward < Args > (args)...);
+      slot -> live = true;
+      liveCount++;
+      createdCount++;
+      peakCount = std::max(peakCount, liveCount);
+      return object;
     }
-    reviews.push_back(std::make_pair(reviewText, starRating));
 
-    // Recalculate average rating
-    totalReviews++;
-    double totalStars = 0;
-    for (const auto & review: reviews) {
-      totalStars += review.second;
+    void destroy(T * object) {
+      Slot * slot = slotOf(object);
+      object -> ~T();
+      slot -> live = false;
+      freeSlots.push_back(slot);
+      liveCount--;
     }
-    averageUserRating = totalStars / totalReviews;
-  }
 
-  // Method to update price
-  void updatePrice(double newPrice) {
-    if (newPrice < 0) {
-      throw std::invalid_argument("Price cannot be negative");
+    // Destroys every live object and releases all slabs at once
+    void clear() {
+      for (auto & slab: slabs) {
+        for (size_t i = 0; i < SlabSize; ++i) {
+          if (slab[i].live) {
+            reinterpret_cast < T * > (slab[i].storage) -> ~T();
+            slab[i].live = false;
+          }
+        }
+      }
+      slabs.clear();
+      freeSlots.clear();
+      usedInLastSlab = SlabSize;
+      liveCount = 0;
     }
-    price = newPrice;
-  }
 
+    Stats stats() const {
+      return {
+        liveCount, peakCount, createdCount, slabs.size(), slabs.size() * SlabSize * sizeof(Slot)
+      };
+    }
 };
 
-// User Class
-class User {
+// Monotonic storage for strings that never change once written, such as a
+// game's title or description. Strings are packed into large blocks and only
+// released together when the arena is destroyed.
+class StringArena {
   private:
-    std::string userId;
-    std::string username;
-    std::string email;
-    std::string password;
-    UserRole role;  
-    std::vector < Game * > library;
-    std::vector < Game * > wishlist;
+    static constexpr size_t BlockSize = 64 * 1024;
 
-  public:
-    User(const std::string & id,
-    const std::string & username,
-    const std::string & email,
-    const std::string & password,
-    UserRole role)
-    : userId(id),
-    username(username),
-    email(email),
-    password(password),
-    role(role) {}
-    
-    bool login(const std::string & enteredPassword) {
-    return password == enteredPassword;
-    }
+    std::vector < std::unique_ptr < char[] >> blocks;
+    size_t usedInLastBlock = BlockSize;
+    size_t lastBlockSize = BlockSize;
+    size_t bytesStored = 0;
+    size_t bytesReserved = 0;
+    mutable std::mutex mutex; // reviews on different games store text concurrently
 
-    //Getters
-    std::string getUsername() const {
-        return username;
-    }
-    std::string getUserId() const {
-        return userId;
-    }
-    UserRole getRole() const {
-        return role;
-    }
-    std::vector < Game * > & getLibrary() {
-        return library;
-    }
-    std::vector < Game * > & getWishlist() {
-        return wishlist;
+  public:
+    struct Stats {
+      size_t bytesStored;
+      size_t bytesReserved;
+      size_t blocks;
+    };
+
+    StringArena() = default;
+    StringArena(const StringArena & ) = delete;
+    StringArena & operator = (const StringArena & ) = delete;
+
+    // Copies text into the arena; the returned view lives as long as the arena
+    std::string_view store(std::string_view text) {
+      if (text.empty()) return std::string_view();
+      std::lock_guard < std::mutex > lock(mutex);
+      if (lastBlockSize - usedInLastBlock < text.size()) {
+        // Oversized strings get a block of their own
+        lastBlockSize = std::max(BlockSize, text.size());
+        blocks.emplace_back(new char[lastBlockSize]);
+        bytesReserved += lastBlockSize;
+        usedInLastBlock = 0;
+      }
+      char * destination = blocks.back().get() + usedInLastBlock;
+      std::memcpy(destination, text.data(), text.size());
+      usedInLastBlock += text.size();
+      bytesStored += text.size();
+      return std::string_view(destination, text.size());
     }
 
-    void addToLibrary(Game * game) {
-        library.push_back(game);
+    Stats stats() const {
+      std::lock_guard < std::mutex > lock(mutex);
+      return {
+        bytesStored, bytesReserved, blocks.size()
+      };
     }
+};
 
-  void addToWishlist(Game * game) {
-    wishlist.push_back(game);
-    }
+// One bit per catalog slot, set when the slot passed a filter
+struct SelectionBitmap {
+  std::vector < std::uint64_t > words;
 
+  bool test(std::uint32_t slot) const {
+    return (words[slot >> 6] >> (slot & 63)) & 1;
+  }
+};
 
-  // Method to review a game
+// Raw column pointers and query constants handed to the filter kernels
+struct FilterColumns {
+  const double * prices;
+  const std::uint8_t * ratings;
+  const std::time_t * releaseDates;
+  const std::uint32_t * genreIds;
+  const std::uint8_t * live;
+  std::uint32_t count;
+};
 
-  void reviewGame(Game * game,
-    const std::string & reviewText, int rating) {
+struct FilterQuery {
+  double minPrice;
+  double maxPrice;
+  std::uint8_t anyRating;
+  std::uint8_t wantedRating;
+  std::time_t minReleaseDate;
+  std::time_t maxReleaseDate;
+  const std::uint8_t * genreAllowed; // one flag per genre id
+  const std::int32_t * genreAllowedWide; // same flags widened for gathers
+  std::uint8_t anyGenre; // every flag is set, so genre lookups can be skipped
+};
 
-    // Check if the game is in the user's library
+using FilterKernel = void ( * )(const FilterColumns & , const FilterQuery & , std::uint64_t * );
+
+// Reference kernel. Also finishes the tail block for the SIMD kernels, so
+// begin must be a multiple of 64.
+inline void filterRangeScalar(const FilterColumns & cols, const FilterQuery & q,
+  std::uint32_t begin, std::uint64_t * words) {
+  for (std::uint32_t base = begin; base < cols.count; base += 64) {
+    const std::uint32_t end = std::min(cols.count, base + 64);
+    std::uint64_t bits = 0;
+    for (std::uint32_t i = base; i < end; ++i) {
+      std::uint64_t keep = cols.live[i] &
+        (cols.prices[i] >= q.minPrice) & (cols.prices[i] <= q.maxPrice) &
+        (q.anyRating | (cols.ratings[i] == q.wantedRating)) &
+        (cols.releaseDates[i] >= q.minReleaseDate) & (cols.releaseDates[i] <= q.maxReleaseDate) &
+        q.genreAllowed[cols.genreIds[i]];
+      bits |= keep << (i - base);
+    }
+    words[base >> 6] = bits;
+  }
+}
+
+inline void filterKernelScalar(const FilterColumns & cols, const FilterQuery & q, std::uint64_t * words) {
+  filterRangeScalar(cols, q, 0, words);
+}
+
+#ifdef MARKETPLACE_X86_KERNELS
+static_assert(sizeof(std::time_t) == 8, "SIMD filter kernels expect a 64-bit time_t");
+
+// 8 games per step: two 4-wide double compares for price, two 4-wide int64
+// compares for release date, a gather for the genre flags and byte compares
+// for rating and liveness.
+__attribute__((target("avx2")))
+inline void filterKernelAvx2(const FilterColumns & cols, const FilterQuery & q, std::uint64_t * words) {
+  const __m256d minPrice = _mm256_set1_pd(q.minPrice);
+  const __m256d maxPrice = _mm256_set1_pd(q.maxPrice);
+  const __m256i minDate = _mm256_set1_epi64x(q.minReleaseDate);
+  const __m256i maxDate = _mm256_set1_epi64x(q.maxReleaseDate);
+  const __m128i wanted = _mm_set1_epi8(static_cast < char > (q.wantedRating));
+  const __m128i zeroBytes = _mm_setzero_si128();
+  const __m256i zero = _mm256_setzero_si256();
+  const std::uint32_t ratingOverride = q.anyRating ? 0xFF : 0;
+
+  const std::uint32_t fullBlocks = cols.count / 64;
+  for (std::uint32_t block = 0; block < fullBlocks; ++block) {
+    const std::uint32_t base = block * 64;
+    std::uint64_t bits = 0;
+    for (std::uint32_t i = 0; i < 64; i += 8) {
+      const std::uint32_t at = base + i;
+      __m256d p0 = _mm256_loadu_pd(cols.prices + at);
+      __m256d p1 = _mm256_loadu_pd(cols.prices + at + 4);
+      std::uint32_t priceBits =
+        static_cast < std::uint32_t > (_mm256_movemask_pd(_mm256_and_pd(
+          _mm256_cmp_pd(p0, minPrice, _CMP_GE_OQ), _mm256_cmp_pd(p0, maxPrice, _CMP_LE_OQ)))) |
+        static_cast < std::uint32_t > (_mm256_movemask_pd(_mm256_and_pd(
+          _mm256_cmp_pd(p1, minPrice, _CMP_GE_OQ), _mm256_cmp_pd(p1, maxPrice, _CMP_LE_OQ)))) << 4;
+
+      __m256i d0 = _mm256_loadu_si256(reinterpret_cast < const __m256i * > (cols.releaseDates + at));
+      __m256i d1 = _mm256_loadu_si256(reinterpret_cast < const __m256i * > (cols.releaseDates + at + 4));
+      __m256i out0 = _mm256_or_si256(_mm256_cmpgt_epi64(minDate, d0), _mm256_cmpgt_epi64(d0, maxDate));
+      __m256i out1 = _mm256_or_si256(_mm256_cmpgt_epi64(minDate, d1), _mm256_cmpgt_epi64(d1, maxDate));
+      std::uint32_t dateBits = ~(static_cast < std::uint32_t > (_mm256_movemask_pd(_mm256_castsi256_pd(out0))) |
+        static_cast < std::uint32_t > (_mm256_movemask_pd(_mm256_castsi256_pd(out1))) << 4) & 0xFF;
+
+      std::uint32_t genreBits = 0xFF;
+      if (!q.anyGenre) {
+        __m256i genre = _mm256_loadu_si256(reinterpret_cast < const __m256i * > (cols.genreIds + at));
+        __m256i allowed = _mm256_i32gather_epi32(q.genreAllowedWide, genre, 4);
+        genreBits = static_cast < std::uint32_t > (
+          _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(allowed, zero))));
+      }
 
-    auto it = std::find(library.begin(), library.end(), game);
+      __m128i rated = _mm_loadl_epi64(reinterpret_cast < const __m128i * > (cols.ratings + at));
+      std::uint32_t ratingBits = (static_cast < std::uint32_t > (
+        _mm_movemask_epi8(_mm_cmpeq_epi8(rated, wanted))) | ratingOverride) & 0xFF;
 
-    if (it != library.end()) {
+      __m128i alive = _mm_loadl_epi64(reinterpret_cast < const __m128i * > (cols.live + at));
+      std::uint32_t liveBits = ~static_cast < std::uint32_t > (
+        _mm_movemask_epi8(_mm_cmpeq_epi8(alive, zeroBytes))) & 0xFF;
 
-      game -> addReview(reviewText, rating);
+      bits |= static_cast < std::uint64_t > (priceBits & dateBits & genreBits & ratingBits & liveBits) << i;
+    }
+    words[block] = bits;
+  }
+  filterRangeScalar(cols, q, fullBlocks * 64, words);
+}
+
+// 4 games per step with 2-wide compares; SSE4.2 is the first level with a
+// 64-bit integer compare. Genre flags have no gather here and are read directly.
+__attribute__((target("sse4.2")))
+inline void filterKernelSse42(const FilterColumns & cols, const FilterQuery & q, std::uint64_t * words) {
+  const __m128d minPrice = _mm_set1_pd(q.minPrice);
+  const __m128d maxPrice = _mm_set1_pd(q.maxPrice);
+  const __m128i minDate = _mm_set1_epi64x(q.minReleaseDate);
+  const __m128i maxDate = _mm_set1_epi64x(q.maxReleaseDate);
+  const __m128i wanted = _mm_set1_epi8(static_cast < char > (q.wantedRating));
+  const __m128i zeroBytes = _mm_setzero_si128();
+  const std::uint32_t ratingOverride = q.anyRating ? 0xF : 0;
+
+  const std::uint32_t fullBlocks = cols.count / 64;
+  for (std::uint32_t block = 0; block < fullBlocks; ++block) {
+    const std::uint32_t base = block * 64;
+    std::uint64_t bits = 0;
+    for (std::uint32_t i = 0; i < 64; i += 4) {
+      const std::uint32_t at = base + i;
+      __m128d p0 = _mm_loadu_pd(cols.prices + at);
+      __m128d p1 = _mm_loadu_pd(cols.prices + at + 2);
+      std::uint32_t priceBits =
+        static_cast < std::uint32_t > (_mm_movemask_pd(_mm_and_pd(_mm_cmpge_pd(p0, minPrice), _mm_cmple_pd(p0, maxPrice)))) |
+        static_cast < std::uint32_t > (_mm_movemask_pd(_mm_and_pd(_mm_cmpge_pd(p1, minPrice), _mm_cmple_pd(p1, maxPrice)))) << 2;
+
+      __m128i d0 = _mm_loadu_si128(reinterpret_cast < const __m128i * > (cols.releaseDates + at));
+      __m128i d1 = _mm_loadu_si128(reinterpret_cast < const __m128i * > (cols.releaseDates + at + 2));
+      __m128i out0 = _mm_or_si128(_mm_cmpgt_epi64(minDate, d0), _mm_cmpgt_epi64(d0, maxDate));
+      __m128i out1 = _mm_or_si128(_mm_cmpgt_epi64(minDate, d1), _mm_cmpgt_epi64(d1, maxDate));
+      std::uint32_t dateBits = ~(static_cast < std::uint32_t > (_mm_movemask_pd(_mm_castsi128_pd(out0))) |
+        static_cast < std::uint32_t > (_mm_movemask_pd(_mm_castsi128_pd(out1))) << 2) & 0xF;
+
+      std::uint32_t genreBits = 0xF;
+      if (!q.anyGenre) {
+        genreBits =
+          static_cast < std::uint32_t > (q.genreAllowed[cols.genreIds[at]]) |
+          static_cast < std::uint32_t > (q.genreAllowed[cols.genreIds[at + 1]]) << 1 |
+          static_cast < std::uint32_t > (q.genreAllowed[cols.genreIds[at + 2]]) << 2 |
+          static_cast < std::uint32_t > (q.genreAllowed[cols.genreIds[at + 3]]) << 3;
+      }
 
-    } else {
+      std::int32_t packed;
+      std::memcpy( & packed, cols.ratings + at, sizeof(packed));
+      std::uint32_t ratingBits = (static_cast < std::uint32_t > (
+        _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_cvtsi32_si128(packed), wanted))) | ratingOverride) & 0xF;
 
-      throw std::runtime_error("You can only review games in your library");
+      std::memcpy( & packed, cols.live + at, sizeof(packed));
+      std::uint32_t liveBits = ~static_cast < std::uint32_t > (
+        _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_cvtsi32_si128(packed), zeroBytes))) & 0xF;
 
+      bits |= static_cast < std::uint64_t > (priceBits & dateBits & genreBits & ratingBits & liveBits) << i;
     }
-
+    words[block] = bits;
+  }
+  filterRangeScalar(cols, q, fullBlocks * 64, words);
+}
+#endif
+
+// Picks the widest kernel the running CPU supports
+inline FilterKernel selectFilterKernel() {
+#ifdef MARKETPLACE_X86_KERNELS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return filterKernelAvx2;
+  if (__builtin_cpu_supports("sse4.2")) return filterKernelSse42;
+#endif
+  return filterKernelScalar;
+}
+
+// Names a game for as long as it exists: its catalog slot plus that slot's
+// generation. Removing a game bumps the generation before the slot is handed
+// to another game, so a handle kept after the removal no longer resolves.
+struct GameHandle {
+  static constexpr std::uint32_t NoSlot = std::numeric_limits < std::uint32_t > ::max();
+
+  std::uint32_t slot = NoSlot;
+  std::uint32_t generation = 0;
+
+  bool empty() const {
+    return slot == NoSlot;
   }
+  std::uint64_t key() const {
+    return static_cast < std::uint64_t > (generation) << 32 | slot;
+  }
+  bool operator == (const GameHandle & other) const {
+    return slot == other.slot && generation == other.generation;
+  }
+};
 
+// Columns a CatalogStore can keep slots sorted by
+enum class SortColumn {
+  PRICE,
+  AVERAGE_RATING,
+  RELEASE_DATE
 };
 
-// Administrator Class
-class Administrator {
+// Columnar (struct-of-arrays) storage for the fields searchGames filters on.
+// Each Game is a handle holding its slot in these arrays, so a filter pass
+// walks a few dense columns instead of chasing one pointer per game.
+// It is also the one registry of games: a GameHandle resolves through it, and
+// a retired slot's generation is bumped so old handles stop resolving.
+// Slots are never reused, so slot order is creation order; the slots of
+// removed games are reclaimed when the catalog is next loaded from a snapshot.
+class CatalogStore {
+  public:
+    // (value, slot) pairs in ascending order
+    using SortIndex = std::set < std::pair < double, std::uint32_t >> ;
 
   private:
-    std::string adminId;
-    std::string username;
+    std::vector < double > prices;
+    std::vector < std::uint8_t > ratings;
+    std::vector < std::time_t > releaseDates;
+    std::vector < double > averageRatings;
+    std::vector < std::uint32_t > genreIds;
+    std::vector < std::uint8_t > live;
+    std::vector < Game * > owners; // nullptr once a game is removed
+    std::vector < std::uint32_t > generations; // bumped when a slot's game is removed
+    std::vector < std::uint64_t > sequences; // creation order, kept across snapshots
+    std::uint64_t nextSequence = 0;
+
+    // Genres are interned so each game only stores a small id
+    std::vector < std::string > genreNames;
+    std::unordered_map < std::string, std::uint32_t > genreLookup;
+
+    // Sorted views of the sort columns, built the first time a ranked search
+    // needs one and kept current by the setters from then on. Setters for
+    // different slots may run concurrently, hence the mutex; ranked searches
+    // only read an index while no setter can run (see GameMarketplace).
+    mutable std::array < SortIndex, 3 > sortIndexes;
+    mutable std::array < std::atomic < bool > , 3 > sortIndexBuilt {};
+    mutable std::mutex sortIndexMutex;
+
+    double sortValue(SortColumn column, std::uint32_t slot) const {
+      switch (column) {
+      case SortColumn::PRICE:
+        return prices[slot];
+      case SortColumn::AVERAGE_RATING:
+        return averageRatings[slot];
+      default:
+        return static_cast < double > (releaseDates[slot]);
+      }
+    }
 
-  std::unordered_map < std::string,
-  Game * > gameCatalog;
+    void moveSortKey(SortColumn column, std::uint32_t slot, double newValue) {
+      const size_t index = static_cast < size_t > (column);
+      if (!sortIndexBuilt[index].load(std::memory_order_acquire)) return;
+      std::lock_guard < std::mutex > lock(sortIndexMutex);
+      sortIndexes[index].erase({sortValue(column, slot), slot});
+      sortIndexes[index].insert({newValue, slot});
+    }
 
   public:
-    Administrator(const std::string & id,
-      const std::string & username)
-    : adminId(id),
-  username(username) {}
-
-  std::string getAdminUsername() const {
-        return username;
+    void reserve(size_t count) {
+      prices.reserve(count);
+      ratings.reserve(count);
+      releaseDates.reserve(count);
+      averageRatings.reserve(count);
+      genreIds.reserve(count);
+      live.reserve(count);
+      owners.reserve(count);
+      generations.reserve(count);
+      sequences.reserve(count);
     }
 
-  void addGameToCatalog(Game * game) {
-    gameCatalog[game -> getGameId()] = game;
-  }
-  
-  void removeGameFromCatalog(const std::string & gameId) {
-    auto it = gameCatalog.find(gameId);
-    if (it != gameCatalog.end()) {
-      gameCatalog.erase(it);
+    std::uint32_t append(Game * owner, double price,
+      std::string_view genre, GameRating rating, std::time_t releaseDate) {
+      std::uint32_t slot = static_cast < std::uint32_t > (owners.size());
+      prices.push_back(price);
+      ratings.push_back(static_cast < std::uint8_t > (rating));
+      releaseDates.push_back(releaseDate);
+      averageRatings.push_back(0.0);
+      genreIds.push_back(internGenre(genre));
+      live.push_back(1);
+      owners.push_back(owner);
+      generations.push_back(0);
+      sequences.push_back(nextSequence++);
+      for (SortColumn column: {SortColumn::PRICE, SortColumn::AVERAGE_RATING, SortColumn::RELEASE_DATE}) {
+        if (sortIndexBuilt[static_cast < size_t > (column)]) {
+          sortIndexes[static_cast < size_t > (column)].insert({sortValue(column, slot), slot});
+        }
+      }
+      return slot;
     }
-  }
 
-    void setWeeklySale(const std::string & gameId, double discountPercentage) {
-        auto it = gameCatalog.find(gameId);
-        if (it != gameCatalog.end()) {
-        double currentPrice = it->second->getPrice();
-        double discountedPrice = currentPrice * (1 - discountPercentage / 100);
-        it->second->updatePrice(discountedPrice); // Update the price in the gameCatalog
+    void retire(std::uint32_t slot) {
+      for (SortColumn column: {SortColumn::PRICE, SortColumn::AVERAGE_RATING, SortColumn::RELEASE_DATE}) {
+        if (sortIndexBuilt[static_cast < size_t > (column)]) {
+          sortIndexes[static_cast < size_t > (column)].erase({sortValue(column, slot), slot});
         }
+      }
+      live[slot] = 0;
+      owners[slot] = nullptr;
+      generations[slot]++;
     }
 
-};
-
-// Class for Community Posts
-class Post {
-  public:
-    std::string postId;
-    std::string userId; // User who created the post
-    std::string content;
-    std::time_t timestamp;
+    GameHandle handle(std::uint32_t slot) const {
+      return {slot, generations[slot]};
+    }
 
-    Post(const std::string & id,
-    const std::string & userId,
-    const std::string & content)
-    : postId(id),
-    userId(userId),
-    content(content) {
-    timestamp = std::time(nullptr);
-  }
-};
+    // nullptr once the handle's game has been removed
+    Game * resolve(GameHandle handle) const {
+      if (handle.slot >= owners.size() || generations[handle.slot] != handle.generation) return nullptr;
+      return owners[handle.slot];
+    }
 
-// GameMarketplace Class to manage overall system
-class GameMarketplace{
-  private:
-    std::vector < User * > users;
-    std::vector < Game * > games;
-    std::vector < Administrator * > administrators;
-    std::vector < Post * > communityPosts;
-    std::vector<Game*> gamesOnSale;
+    std::uint32_t internGenre(std::string_view genre) {
+      std::string name(genre);
+      auto found = genreLookup.find(name);
+      if (found != genreLookup.end()) {
+        return found -> second;
+      }
+      std::uint32_t id = static_cast < std::uint32_t > (genreNames.size());
+      genreNames.push_back(name);
+      genreLookup.emplace(name, id);
+      return id;
+    }
 
-  public:
-    // Methods to register users, add games, etc.
-    User * registerUser(const std::string & username,
-    const std::string & email,
-    const std::string & password, UserRole role) {
-      User * newUser = new User(std::to_string(users.size() + 1),
-        username, email, password, role);
-      users.push_back(newUser);
-      return newUser;
+    std::uint32_t size() const {
+      return static_cast < std::uint32_t > (owners.size());
+    }
+    Game * owner(std::uint32_t slot) const {
+      return owners[slot];
     }
 
-  Game * createGame(const std::string & title,
-    const std::string & description,
-      double price,
-      const std::string & genre,
-        GameRating rating,
-        const std::string & developer) {
-    Game * newGame = new Game(std::to_string(games.size() + 1),
-      title, description, price,
-      genre, rating, developer);
-    games.push_back(newGame);
-    return newGame;
-  }
+    // Creation sequence of the slot's game, unique for the catalog's lifetime
+    std::uint64_t sequence(std::uint32_t slot) const {
+      return sequences[slot];
+    }
+    std::uint64_t sequencesIssued() const {
+      return nextSequence;
+    }
+    // For games restored from a snapshot, which keep their original sequence
+    void restoreSequence(std::uint32_t slot, std::uint64_t sequence) {
+      sequences[slot] = sequence;
+      nextSequence = std::max(nextSequence, sequence + 1);
+    }
+    void reserveSequencesThrough(std::uint64_t next) {
+      nextSequence = std::max(nextSequence, next);
+    }
+    double price(std::uint32_t slot) const {
+      return prices[slot];
+    }
+    void setPrice(std::uint32_t slot, double newPrice) {
+      moveSortKey(SortColumn::PRICE, slot, newPrice);
+      prices[slot] = newPrice;
+    }
+    GameRating rating(std::uint32_t slot) const {
+      return static_cast < GameRating > (ratings[slot]);
+    }
+    std::time_t releaseDate(std::uint32_t slot) const {
+      return releaseDates[slot];
+    }
+    double averageRating(std::uint32_t slot) const {
+      return averageRatings[slot];
+    }
+    void setAverageRating(std::uint32_t slot, double rating) {
+      moveSortKey(SortColumn::AVERAGE_RATING, slot, rating);
+      averageRatings[slot] = rating;
+    }
+    std::uint32_t genreId(std::uint32_t slot) const {
+      return genreIds[slot];
+    }
+    const std::string & genreName(std::uint32_t genreId) const {
+      return genreNames[genreId];
+    }
+    std::uint32_t genreCount() const {
+      return static_cast < std::uint32_t > (genreNames.size());
+    }
 
-  // Search functionality
-    std::vector<Game*> searchGames(const std::string& title = "", 
-                                    double minPrice = 0.0, 
-                                    double maxPrice = std::numeric_limits<double>::max(),
-                                    const std::string& category = "",
-                                    GameRating rating = GameRating::E,
-                                    std::time_t minReleaseDate = 0, 
-                                    std::time_t maxReleaseDate = std::numeric_limits<std::time_t>::max()) 
-    {
-        std::vector<Game*> results;
+    // Live slots ordered by column value, then slot
+    const SortIndex & sortIndex(SortColumn column) const {
+      const size_t index = static_cast < size_t > (column);
+      if (!sortIndexBuilt[index].load(std::memory_order_acquire)) {
+        std::lock_guard < std::mutex > lock(sortIndexMutex);
+        if (!sortIndexBuilt[index].load(std::memory_order_relaxed)) {
+          std::vector < std::pair < double, std::uint32_t >> sorted;
+          sorted.reserve(size());
+          for (std::uint32_t slot = 0; slot < size(); ++slot) {
+            if (live[slot]) sorted.emplace_back(sortValue(column, slot), slot);
+          }
+          std::sort(sorted.begin(), sorted.end());
+          sortIndexes[index].insert(sorted.begin(), sorted.end()); // linear for sorted input
+          sortIndexBuilt[index].store(true, std::memory_order_release);
+        }
+      }
+      return sortIndexes[index];
+    }
 
-        for (auto* game : games) 
-        {
-            // Check title (case-insensitive partial match)
-            bool titleMatch = title.empty() || 
-                game->getTitle().find(title) != std::string::npos;
+    // The scalar equivalent of filter() for a single slot
+    bool passes(std::uint32_t slot, double minPrice, double maxPrice, GameRating rating,
+      std::time_t minReleaseDate, std::time_t maxReleaseDate,
+      const std::vector < std::uint8_t > & genreAllowed) const {
+      return live[slot] && prices[slot] >= minPrice && prices[slot] <= maxPrice &&
+        (rating == GameRating::E || ratings[slot] == static_cast < std::uint8_t > (rating)) &&
+        releaseDates[slot] >= minReleaseDate && releaseDates[slot] <= maxReleaseDate &&
+        genreAllowed[genreIds[slot]];
+    }
 
-            // Check price range
-            bool priceMatch = game->getPrice() >= minPrice && game->getPrice() <= maxPrice;
+    // Evaluates the price, rating, release date and genre predicates for every
+    // slot into a bitmap. genreAllowed holds one flag per interned genre id.
+    // The kernel is chosen once per process from the CPU's features; pass one
+    // explicitly to compare kernels against each other.
+    SelectionBitmap filter(double minPrice, double maxPrice, GameRating rating,
+      std::time_t minReleaseDate, std::time_t maxReleaseDate,
+      const std::vector < std::uint8_t > & genreAllowed,
+      FilterKernel kernel = nullptr) const {
+      SelectionBitmap selection;
+      std::vector < std::int32_t > genreAllowedWide;
+      filterInto(minPrice, maxPrice, rating, minReleaseDate, maxReleaseDate,
+        genreAllowed, selection, genreAllowedWide, kernel);
+      return selection;
+    }
 
-            // Check category (genre)
-            bool categoryMatch = category.empty() || 
-                game->getGenre().find(category) != std::string::npos;
+    // Same as filter(), writing into caller-owned buffers so repeated
+    // searches reuse their memory
+    void filterInto(double minPrice, double maxPrice, GameRating rating,
+      std::time_t minReleaseDate, std::time_t maxReleaseDate,
+      const std::vector < std::uint8_t > & genreAllowed,
+      SelectionBitmap & selection, std::vector < std::int32_t > & genreAllowedWide,
+      FilterKernel kernel = nullptr) const {
+      static const FilterKernel bestKernel = selectFilterKernel();
+
+      selection.words.assign((size() + 63) / 64, 0);
+      if (size() == 0) return;
+
+      genreAllowedWide.assign(genreAllowed.begin(), genreAllowed.end());
+      FilterColumns cols {
+        prices.data(), ratings.data(), releaseDates.data(), genreIds.data(), live.data(), size()
+      };
+      FilterQuery q {
+        minPrice, maxPrice,
+        static_cast < std::uint8_t > (rating == GameRating::E), static_cast < std::uint8_t > (rating),
+        minReleaseDate, maxReleaseDate,
+        genreAllowed.data(), genreAllowedWide.data(),
+        static_cast < std::uint8_t > (std::all_of(genreAllowed.begin(), genreAllowed.end(),
+          [](std::uint8_t flag) { return flag != 0; }))
+      };
+      (kernel ? kernel : bestKernel)(cols, q, selection.words.data());
+    }
+};
 
-            // Check rating (exact match)
-            bool ratingMatch = (rating == GameRating::E) || game->getRating() == rating;
+// Prices. A base price only changes when the developer changes it; discounts
+// come from sale rules, each a percentage off for a window [start, end). A
+// game sells at its base price less the best rule in effect, never several
+// compounded. That effective price is what the CatalogStore price column
+// holds, so browsing, filtering and sorting still read one value per game; it
+// is rewritten only when a base price changes or a window opens or closes.
+// Pending window boundaries are kept in time order and the rules in effect
+// are indexed by game, which is where the sale list comes from.
+class PricingEngine {
+  public:
+    static constexpr std::uint16_t FullDiscount = 10000; // basis points
 
-            // Check release date range
-            bool releaseDateMatch = game->getReleaseDate() >= minReleaseDate && 
-                                    game->getReleaseDate() <= maxReleaseDate;
+    struct Rule {
+      std::uint64_t id;
+      std::uint32_t slot;
+      std::uint16_t discountBasisPoints;
+      std::time_t start;
+      std::time_t end; // exclusive
+    };
 
-            // If all selected criteria match, add to results
-            if (titleMatch && priceMatch && categoryMatch && ratingMatch && releaseDateMatch) 
-            {
-                results.push_back(game);
-            }
-        }
+  private:
+    CatalogStore & store;
+    std::vector < double > basePrices; // by slot
+    std::vector < std::uint16_t > discounts; // best rule in effect, by slot
+    std::unordered_map < std::uint64_t, Rule > rules; // scheduled or in effect
+    std::set < std::pair < std::time_t, std::uint64_t >> boundaries; // pending starts and ends
+    std::set < std::tuple < std::uint32_t, std::uint16_t, std::uint64_t >> active; // (slot, discount, rule) in effect
+    std::uint64_t nextRuleId = 1;
+    std::time_t clock = std::numeric_limits < std::time_t > ::min(); // boundaries up to here are applied
+
+    static std::tuple < std::uint32_t, std::uint16_t, std::uint64_t > activeKey(const Rule & rule) {
+      return std::make_tuple(rule.slot, rule.discountBasisPoints, rule.id);
+    }
 
-        return results;
+    void reprice(std::uint32_t slot) {
+      // The slot's best rule sorts last among its entries
+      auto after = active.lower_bound(std::make_tuple(slot + 1, std::uint16_t(0), std::uint64_t(0)));
+      std::uint16_t best = 0;
+      if (after != active.begin() && std::get < 0 > ( * std::prev(after)) == slot) best = std::get < 1 > ( * std::prev(after));
+      discounts[slot] = best;
+      double price = basePrices[slot];
+      if (best != 0) price = std::round(price * (FullDiscount - best) / FullDiscount * 100) / 100;
+      store.setPrice(slot, price);
     }
 
-  // Destructor to clean up dynamically allocated memory
-  ~GameMarketplace() {
+  public:
+    explicit PricingEngine(CatalogStore & store): store(store) {}
 
-    for (auto * user: users) delete user;
-    for (auto * game: games) delete game;
-    for (auto * admin: administrators) delete admin;
-  }
+    PricingEngine(const PricingEngine & ) = delete;
+    PricingEngine & operator = (const PricingEngine & ) = delete;
 
-  void populateWithDefaults() {
-    // Create 2 default customer users
-    for (int i = 1; i <= 2; ++i) {
-      std::string userId = "customer" + std::to_string(i);
-      users.push_back(new User(userId, userId, userId + "@example.com", "password", UserRole::CUSTOMER));
+    // Takes the slot's catalog price as its base price
+    void track(std::uint32_t slot) {
+      if (basePrices.size() <= slot) {
+        basePrices.resize(slot + 1);
+        discounts.resize(slot + 1);
+      }
+      basePrices[slot] = store.price(slot);
+      discounts[slot] = 0;
     }
 
-    // Create 2 default developer users
-    for (int i = 1; i <= 2; ++i) {
-      std::string userId = "developer" + std::to_string(i);
-      users.push_back(new User(userId, userId, userId + "@example.com", "password", UserRole::DEVELOPER));
+    // Drops the rules of a removed game
+    void untrack(std::uint32_t slot) {
+      for (auto it = rules.begin(); it != rules.end();) {
+        if (it -> second.slot != slot) {
+          ++it;
+          continue;
+        }
+        boundaries.erase({it -> second.start, it -> first});
+        boundaries.erase({it -> second.end, it -> first});
+        active.erase(activeKey(it -> second));
+        it = rules.erase(it);
+      }
     }
 
-    // Create 2 default manager users
-    for (int i = 1; i <= 2; ++i) {
-      std::string userId = "manager" + std::to_string(i);
-      users.push_back(new User(userId, userId, userId + "@example.com", "password", UserRole::MANAGER));
+    double basePrice(std::uint32_t slot) const {
+      return basePrices[slot];
     }
 
-    //Added 2 default admin users
-    for (int i = 1; i <= 2; ++i) {
-      std::string adminId = "admin" + std::to_string(i);
-      administrators.push_back(new Administrator(adminId, adminId));
+    std::uint16_t discount(std::uint32_t slot) const {
+      return discounts[slot];
     }
 
-    // Create 10 default games with ratings and reviews, randomly assigned to developers
-        std::random_device rd; 
-        std::mt19937 gen(rd()); 
-        std::uniform_int_distribution<> devDistrib(1, 2); // Distribution for developer index (1 or 2)
-
-        GameRating ratings[] = {GameRating::E, GameRating::E10, GameRating::T, GameRating::M, GameRating::AO};
-        for (int i = 1; i <= 10; ++i) {
-        std::string gameId = "game" + std::to_string(i);
-        GameRating selectedRating = ratings[(i-1) % 5];
-
-        // Randomly select a developer
-        int devIndex = devDistrib(gen);
-        std::string developerName = "developer" + std::to_string(devIndex); 
-
-        Game* newGame = new Game(
-            gameId, 
-            "Game " + std::to_string(i), 
-            "Description " + std::to_string(i),
-            19.99 + i, 
-            "Genre " + std::to_string(i),
-            selectedRating, 
-            developerName 
-        );
+    void setBasePrice(std::uint32_t slot, double price) {
+      if (!std::isfinite(price) || price < 0) {
+        throw std::invalid_argument("Price must be a non-negative amount");
+      }
+      basePrices[slot] = price;
+      reprice(slot);
+    }
 
-        games.push_back(newGame);
+    // The rule takes effect once advance reaches its start. Ids are handed
+    // out in order, so repeating the same calls reproduces them.
+    std::uint64_t addRule(std::uint32_t slot, std::uint16_t discountBasisPoints, std::time_t start, std::time_t end) {
+      if (discountBasisPoints == 0 || discountBasisPoints > FullDiscount) {
+        throw std::invalid_argument("Discount must be above 0% and at most 100%");
+      }
+      if (end <= start) {
+        throw std::invalid_argument("A sale must end after it starts");
+      }
+      return restoreRule({nextRuleId, slot, discountBasisPoints, start, end});
+    }
 
-        // Add reviews to some games
-        if (i % 2 == 0) {
-            for (int j = 1; j <= i / 2; ++j) {
-                newGame->addReview("Review " + std::to_string(j), j % 5 + 1); // Ratings from 1 to 5
-            }
-        }
+    // Adds a rule under the id it was first given
+    std::uint64_t restoreRule(const Rule & rule) {
+      nextRuleId = std::max(nextRuleId, rule.id + 1);
+      if (rule.end <= clock) return rule.id; // already over
+      rules.emplace(rule.id, rule);
+      boundaries.insert({rule.end, rule.id});
+      if (rule.start > clock) {
+        boundaries.insert({rule.start, rule.id});
+      } else {
+        active.insert(activeKey(rule));
+        reprice(rule.slot);
+      }
+      return rule.id;
+    }
 
-        if (i <= 3) {
-            gamesOnSale.push_back(newGame);
+    // Opens and closes every window whose boundary is at or before now
+    void advance(std::time_t now) {
+      std::vector < std::uint32_t > changed;
+      while (!boundaries.empty() && boundaries.begin() -> first <= now) {
+        auto boundary = * boundaries.begin();
+        boundaries.erase(boundaries.begin());
+        auto found = rules.find(boundary.second);
+        const Rule & rule = found -> second;
+        changed.push_back(rule.slot);
+        if (boundary.first == rule.start) {
+          active.insert(activeKey(rule));
+        } else {
+          active.erase(activeKey(rule));
+          rules.erase(found);
         }
+      }
+      clock = std::max(clock, now);
+      std::sort(changed.begin(), changed.end());
+      changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+      for (std::uint32_t slot: changed) reprice(slot);
     }
 
-    // Add 3 default posts to the community tab
-    communityPosts.push_back(new Post("post1", "customer1", "This game is awesome!"));
-    communityPosts.push_back(new Post("post2", "customer2", "Anyone want to play?"));
-    communityPosts.push_back(new Post("post3", "user3", "sigma"));
+    // When advance next has something to do
+    std::time_t nextChange() const {
+      return boundaries.empty() ? std::numeric_limits < std::time_t > ::max() : boundaries.begin() -> first;
+    }
 
-  }
+    // Slots with a rule in effect, ascending
+    std::vector < std::uint32_t > saleSlots() const {
+      std::vector < std::uint32_t > slots;
+      for (const auto & entry: active) {
+        if (slots.empty() || slots.back() != std::get < 0 > (entry)) slots.push_back(std::get < 0 > (entry));
+      }
+      return slots;
+    }
 
-  void runTextUI() {
-    std::string input;
-    User * currentUser = nullptr;
-    Administrator * currentAdmin = nullptr;
-    bool loggedIn = false;
+    template < typename Fn >
+    void forEachRule(Fn && fn) const {
+      for (const auto & entry: rules) fn(entry.second);
+    }
 
-    while (true) {
-      std::cout << "\nWelcome to the Game Store!\n";
+    size_t ruleCount() const {
+      return rules.size();
+    }
 
-      if (loggedIn) {
-        std::cout << "Logged in as: " << currentUser -> getUsername() << " (";
+    std::uint64_t nextId() const {
+      return nextRuleId;
+    }
 
-        switch (currentUser -> getRole()) {
-
-        case UserRole::CUSTOMER:
-
-          std::cout << "Customer";
-
-          break;
+    void reserveThrough(std::uint64_t nextId) {
+      nextRuleId = std::max(nextRuleId, nextId);
+    }
+};
 
-        case UserRole::DEVELOPER:
+// Game Class
+// Scalar, filterable fields live in the CatalogStore; the Game object itself
+// is the handle to its slot there plus the text fields and reviews.
+class Game {
+  private:
+    std::string gameId;
+    // Immutable text, stored in the marketplace's StringArena
+    std::string_view title;
+    std::string_view description;
+    std::string_view developerName;
+    int totalReviews;
+    std::vector < std::pair < std::string_view,
+    int >> reviews; // review text is kept in the arena too
+    StringArena * text;
+    // Running aggregates so the average never needs a pass over reviews
+    long long totalStars;
+    std::array < int, 5 > starCounts; // starCounts[n - 1] = reviews with n stars
+    CatalogStore * store;
+    std::uint32_t catalogSlot;
 
-          std::cout << "Developer";
+  public:
+    Game(CatalogStore & store, StringArena & text,
+    const std::string & id,
+    const std::string & title,
+    const std::string & description, double price,
+    const std::string & genre, GameRating rating,
+    const std::string & developer)
+    : gameId(id),
+    title(text.store(title)),
+    description(text.store(description)),
+    developerName(text.store(developer)),
+    totalReviews(0),
+    text( & text),
+    totalStars(0),
+    starCounts {},
+    store( & store) {
+    catalogSlot = store.append(this, price, genre, rating, std::time(nullptr));
+  }
 
-          break;
+  // Restores a game whose text already lives in storage that outlives it,
+  // such as a mapped snapshot, so nothing is copied
+  Game(CatalogStore & store, StringArena & text,
+    const std::string & id,
+    std::string_view title,
+    std::string_view description, double price,
+    std::string_view genre, GameRating rating,
+    std::string_view developer, std::time_t releaseDate)
+    : gameId(id),
+    title(title),
+    description(description),
+    developerName(developer),
+    totalReviews(0),
+    text( & text),
+    totalStars(0),
+    starCounts {},
+    store( & store) {
+    catalogSlot = store.append(this, price, genre, rating, releaseDate);
+  }
 
-        case UserRole::MANAGER:
+  Game(const Game & ) = delete;
+  Game & operator = (const Game & ) = delete;
 
-          std::cout << "Manager";
+  // Getters
+  std::string_view getGameId() const {
+    return gameId;
+  }
+  std::string_view getTitle() const {
+    return title;
+  }
+  double getPrice() const {
+    return store -> price(catalogSlot);
+  }
+  GameRating getRating() const {
+    return store -> rating(catalogSlot);
+  }
+  std::string_view getGenre() const {
+    return store -> genreName(store -> genreId(catalogSlot));
+  }
+  double getAverageRating() const {
+    return store -> averageRating(catalogSlot);
+  }
+  std::string_view getDescription() const {
+    return description;
+  }
+  std::string_view getDeveloperName() const {
+    return developerName;
+  }
+  GameHandle getHandle() const {
+    return store -> handle(catalogSlot);
+  }
+  std::uint64_t getSequence() const {
+    return store -> sequence(catalogSlot);
+  }
+  const std::vector < std::pair < std::string_view, int >> & getReviews() const {
+    return reviews;
+  }
+  std::time_t getReleaseDate() const {
+    return store -> releaseDate(catalogSlot);
+    }
+  std::uint32_t getCatalogSlot() const {
+    return catalogSlot;
+  }
+  int getReviewCount() const {
+    return totalReviews;
+  }
+  // Number of reviews per star rating, index 0 is 1 star
+  const std::array < int, 5 > & getRatingHistogram() const {
+    return starCounts;
+  }
 
-          break;
+  // Method to add review
+  void addReview(const std::string & reviewText, int starRating) {
+    checkStarRating(starRating);
+    reviews.push_back(std::make_pair(text -> store(reviewText), starRating));
+    countStars(starRating, 1);
+    refreshAverage();
+  }
 
-        }
+  // Adds a batch of reviews, updating the aggregates once for the whole batch.
+  // Nothing is added if any rating in the batch is out of range.
+  void addReviews(const std::vector < std::pair < std::string, int >> & batch) {
+    for (const auto & review: batch) {
+      checkStarRating(review.second);
+    }
+    reviews.reserve(reviews.size() + batch.size());
+    for (const auto & review: batch) {
+      reviews.push_back(std::make_pair(text -> store(review.first), review.second));
+      countStars(review.second, 1);
+    }
+    refreshAverage();
+  }
 
-        std::cout << ")\n";
+  // Like addReviews, for review text that already lives in stable storage
+  void adoptReviews(const std::vector < std::pair < std::string_view, int >> & batch) {
+    for (const auto & review: batch) {
+      checkStarRating(review.second);
+    }
+    reviews.insert(reviews.end(), batch.begin(), batch.end());
+    for (const auto & review: batch) {
+      countStars(review.second, 1);
+    }
+    refreshAverage();
+  }
 
-      }
+  // Removes the review at index in O(1) by moving the last review into its place
+  void removeReview(size_t index) {
+    if (index >= reviews.size()) {
+      throw std::out_of_range("No review at that position");
+    }
+    countStars(reviews[index].second, -1);
+    if (index + 1 != reviews.size()) {
+      reviews[index] = std::move(reviews.back());
+    }
+    reviews.pop_back();
+    refreshAverage();
+  }
 
-      std::cout << "Navigation:\n";
-      std::cout << "1. Community\n";
-      std::cout << "2. Browse Games\n";
-      std::cout << "3. Search Games\n";
-      std::cout << "4. Library\n";
-      std::cout << (loggedIn ? "5. Logout\n" : "5. Login\n");
-      std::cout << "0. Exit\n";
+  void editReview(size_t index, const std::string & reviewText, int starRating) {
+    if (index >= reviews.size()) {
+      throw std::out_of_range("No review at that position");
+    }
+    checkStarRating(starRating);
+    countStars(reviews[index].second, -1);
+    reviews[index] = std::make_pair(text -> store(reviewText), starRating);
+    countStars(starRating, 1);
+    refreshAverage();
+  }
 
-      std::cout << "Enter your choice: ";
-      std::cin >> input;
+  // Titles live in the arena, so a rename stores the new text alongside the old
+  void rename(const std::string & newTitle) {
+    title = text -> store(newTitle);
+  }
 
-      if (input == "1") { // Community
-        while (true) {
-          std::cout << "\nCommunity Tab:\n";
-          for (const auto & post: communityPosts) {
-            std::cout << post -> userId << ": " << post -> content << std::endl;
-          }
 
-          std::cout << "\nOptions:\n";
-          std::cout << "1. Write a post\n";
-          std::cout << "2. navbar\n";
-          std::cout << "Enter your choice: ";
+  private:
+    static void checkStarRating(int starRating) {
+      if (starRating < 1 || starRating > 5) {
+        throw std::invalid_argument("Rating must be between 1 and 5");
+      }
+    }
 
-          std::cin >> input;
+    void countStars(int starRating, int delta) {
+      totalReviews += delta;
+      totalStars += static_cast < long long > (starRating) * delta;
+      starCounts[starRating - 1] += delta;
+    }
 
-          if (input == "1") {
-            if (loggedIn) {
-              std::cout << "Post: ";
-              std::cin.ignore(); // Ignore the newline in buffer
-              std::string content;
-              std::getline(std::cin, content);
-              communityPosts.push_back(new Post("post" + std::to_string(communityPosts.size() + 1),
-                currentUser -> getUsername(), content));
+    void refreshAverage() {
+      store -> setAverageRating(catalogSlot,
+        totalReviews > 0 ? static_cast < double > (totalStars) / totalReviews : 0.0);
+    }
 
-            } else {
+};
 
-              std::cout << "You need to be logged in to write a post.\n";
+// Set of game handles that still iterates in insertion order. Membership is
+// a hash lookup. Erasing leaves a hole in the order vector instead of
+// shifting it, and the holes are squeezed out once they make up half of the
+// vector, so removal stays O(1) amortized. Small sets skip the hash map and
+// scan their few entries instead, which is both faster and far lighter for
+// the typical user's library. Handles of removed games stay in the set until
+// the owner erases them; readers skip them when they no longer resolve.
+class GameSet {
+  private:
+    static constexpr size_t IndexThreshold = 16;
 
-            }
+    std::vector < GameHandle > order; // empty handles mark erased entries
+    std::unordered_map < std::uint64_t, size_t > positions; // handle key -> index in order, once indexed
+    size_t holes = 0;
 
-          } else if (input == "2") {
+    bool indexed() const {
+      return order.size() > IndexThreshold;
+    }
 
-            break; // Go back to navbar
+    size_t scanFor(GameHandle game) const {
+      return static_cast < size_t > (std::find(order.begin(), order.end(), game) - order.begin());
+    }
 
-          } else {
+    void compact() {
+      size_t next = 0;
+      for (GameHandle game: order) {
+        if (game.empty()) continue;
+        order[next++] = game;
+      }
+      order.resize(next);
+      holes = 0;
+      reindex();
+    }
 
-            std::cout << "Invalid choice!\n";
+    void reindex() {
+      positions.clear();
+      if (!indexed()) return;
+      for (size_t i = 0; i < order.size(); ++i) {
+        if (!order[i].empty()) positions[order[i].key()] = i;
+      }
+    }
 
-          }
+  public:
+    class const_iterator {
+      private:
+        const std::vector < GameHandle > * items;
+        size_t index;
 
+        void skipHoles() {
+          while (index < items -> size() && ( * items)[index].empty()) ++index;
         }
 
-      } else if (input == "2") { // Browse Games
-
-        while (true) {
-
-          std::cout << "\nBrowse Games:\n";
+      public:
+        const_iterator(const std::vector < GameHandle > * items, size_t index): items(items), index(index) {
+          skipHoles();
+        }
+        GameHandle operator * () const {
+          return ( * items)[index];
+        }
+        const_iterator & operator++() {
+          ++index;
+          skipHoles();
+          return *this;
+        }
+        bool operator != (const const_iterator & other) const {
+          return index != other.index;
+        }
+    };
 
-          // --- Changed: Added Games on Sale as the first option ---
+    const_iterator begin() const {
+      return const_iterator( & order, 0);
+    }
+    const_iterator end() const {
+      return const_iterator( & order, order.size());
+    }
 
-          std::cout << "1. Games on Sale\n";
+    size_t size() const {
+      return order.size() - holes;
+    }
 
-          std::cout << "2. View All Games\n";
+    bool contains(GameHandle game) const {
+      if (indexed()) {
+        return positions.count(game.key()) != 0;
+      }
+      return scanFor(game) != order.size();
+    }
 
-          std::cout << "3. navbar\n";
+    // Returns false if the game was already in the set
+    bool insert(GameHandle game) {
+      if (indexed()) {
+        if (!positions.emplace(game.key(), order.size()).second) return false;
+        order.push_back(game);
+        return true;
+      }
+      if (scanFor(game) != order.size()) return false;
+      order.push_back(game);
+      if (indexed()) reindex();
+      return true;
+    }
 
-          std::cout << "Enter your choice: ";
+    bool erase(GameHandle game) {
+      size_t index;
+      if (indexed()) {
+        auto found = positions.find(game.key());
+        if (found == positions.end()) return false;
+        index = found -> second;
+        positions.erase(found);
+      } else {
+        index = scanFor(game);
+        if (index == order.size()) return false;
+      }
+      order[index] = GameHandle();
+      if (++holes * 2 > order.size()) {
+        compact();
+      }
+      return true;
+    }
+};
 
-          std::cin >> input;
+// SHA-256 (FIPS 180-4). Only PasswordHash uses it, through HMAC, so a copy of
+// a partly fed hasher is how a precomputed HMAC key state is reused.
+class Sha256 {
+  public:
+    static constexpr size_t DigestSize = 32;
+    static constexpr size_t BlockSize = 64;
+    using Digest = std::array < unsigned char, DigestSize > ;
 
-          if (input == "1") { // Games on Sale
+  private:
+    std::array < std::uint32_t, 8 > state = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+      0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    std::array < unsigned char, BlockSize > buffer;
+    size_t buffered = 0;
+    std::uint64_t totalBytes = 0;
+
+    static std::uint32_t rotate(std::uint32_t x, int n) {
+      return (x >> n) | (x << (32 - n));
+    }
 
-            std::cout << "\nGames on Sale:\n";
-                        for (int i = 0; i < gamesOnSale.size(); ++i) {
-                            std::cout << i + 1 << ". " << gamesOnSale[i]->getTitle() << " - $" << gamesOnSale[i]->getPrice() << std::endl;
-                        }
+    void compress(const unsigned char * block) {
+      static constexpr std::uint32_t k[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+      };
+      std::uint32_t w[64];
+      for (int i = 0; i < 16; ++i) {
+        w[i] = static_cast < std::uint32_t > (block[4 * i]) << 24 | static_cast < std::uint32_t > (block[4 * i + 1]) << 16 |
+          static_cast < std::uint32_t > (block[4 * i + 2]) << 8 | block[4 * i + 3];
+      }
+      for (int i = 16; i < 64; ++i) {
+        std::uint32_t s0 = rotate(w[i - 15], 7) ^ rotate(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        std::uint32_t s1 = rotate(w[i - 2], 17) ^ rotate(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+      }
+      std::uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+      std::uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+      for (int i = 0; i < 64; ++i) {
+        std::uint32_t t1 = h + (rotate(e, 6) ^ rotate(e, 11) ^ rotate(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+        std::uint32_t t2 = (rotate(a, 2) ^ rotate(a, 13) ^ rotate(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+      }
+      state[0] += a;
+      state[1] += b;
+      state[2] += c;
+      state[3] += d;
+      state[4] += e;
+      state[5] += f;
+      state[6] += g;
+      state[7] += h;
+    }
 
-          } else if (input == "2") { // View all Games
+  public:
+    void update(const void * data, size_t length) {
+      const unsigned char * p = static_cast < const unsigned char * > (data);
+      totalBytes += length;
+      if (buffered > 0) {
+        size_t take = std::min(length, BlockSize - buffered);
+        std::memcpy(buffer.data() + buffered, p, take);
+        buffered += take;
+        p += take;
+        length -= take;
+        if (buffered < BlockSize) return;
+        compress(buffer.data());
+        buffered = 0;
+      }
+      for (; length >= BlockSize; p += BlockSize, length -= BlockSize) compress(p);
+      std::memcpy(buffer.data(), p, length);
+      buffered = length;
+    }
 
-            for (int i = 0; i < games.size(); ++i) {
+    Digest finish() {
+      std::uint64_t bits = totalBytes * 8;
+      unsigned char padding[BlockSize + 8] = {0x80};
+      size_t padLength = (buffered < 56 ? 56 : 120) - buffered;
+      for (int i = 0; i < 8; ++i) padding[padLength + i] = static_cast < unsigned char > (bits >> (56 - 8 * i));
+      update(padding, padLength + 8);
+      Digest digest;
+      for (int i = 0; i < 8; ++i) {
+        for (int j = 0; j < 4; ++j) digest[4 * i + j] = static_cast < unsigned char > (state[i] >> (24 - 8 * j));
+      }
+      return digest;
+    }
+};
 
-              std::cout << i + 1 << ". " << games[i] -> getTitle() << std::endl;
+// A salted PBKDF2-HMAC-SHA256 password hash. The cost is the iteration
+// count; it is stored with each hash, so raising it for new passwords
+// leaves existing ones valid.
+struct PasswordHash {
+  static constexpr std::uint32_t DefaultCost = 100000;
+  static constexpr size_t SaltSize = 16;
+  static constexpr size_t SerializedSize = 4 + SaltSize + Sha256::DigestSize;
+
+  std::uint32_t cost = 0;
+  std::array < unsigned char, SaltSize > salt {};
+  Sha256::Digest digest {};
+
+  static Sha256::Digest derive(std::string_view password, const unsigned char * salt, size_t saltLength,
+    std::uint32_t cost) {
+    // HMAC key state, hashed once: the inner and outer pads fill one block each
+    unsigned char key[Sha256::BlockSize] = {};
+    if (password.size() > Sha256::BlockSize) {
+      Sha256 shortened;
+      shortened.update(password.data(), password.size());
+      Sha256::Digest digest = shortened.finish();
+      std::memcpy(key, digest.data(), digest.size());
+    } else {
+      std::memcpy(key, password.data(), password.size());
+    }
+    Sha256 inner, outer;
+    unsigned char pad[Sha256::BlockSize];
+    for (size_t i = 0; i < Sha256::BlockSize; ++i) pad[i] = key[i] ^ 0x36;
+    inner.update(pad, sizeof(pad));
+    for (size_t i = 0; i < Sha256::BlockSize; ++i) pad[i] = key[i] ^ 0x5c;
+    outer.update(pad, sizeof(pad));
+
+    auto hmac = [ & ](const unsigned char * message, size_t length, const unsigned char * suffix, size_t suffixLength) {
+      Sha256 first = inner;
+      first.update(message, length);
+      if (suffixLength != 0) first.update(suffix, suffixLength);
+      Sha256::Digest innerDigest = first.finish();
+      Sha256 second = outer;
+      second.update(innerDigest.data(), innerDigest.size());
+      return second.finish();
+    };
+    // One output block is all a 32-byte key needs, so the block index is 1
+    const unsigned char blockIndex[4] = {0, 0, 0, 1};
+    Sha256::Digest u = hmac(salt, saltLength, blockIndex, sizeof(blockIndex));
+    Sha256::Digest result = u;
+    for (std::uint32_t i = 1; i < cost; ++i) {
+      u = hmac(u.data(), u.size(), nullptr, 0);
+      for (size_t j = 0; j < result.size(); ++j) result[j] ^= u[j];
+    }
+    return result;
+  }
 
-            }
+  static PasswordHash create(std::string_view password, std::uint32_t cost,
+    const std::array < unsigned char, SaltSize > & salt) {
+    if (cost == 0) throw std::invalid_argument("Password cost must be at least 1");
+    PasswordHash hash;
+    hash.cost = cost;
+    hash.salt = salt;
+    hash.digest = derive(password, hash.salt.data(), hash.salt.size(), cost);
+    return hash;
+  }
 
-            std::cout << "\nOptions:\n";
+  // Hashes password under a fresh random salt
+  static PasswordHash create(std::string_view password, std::uint32_t cost) {
+    std::array < unsigned char, SaltSize > salt;
+    std::random_device source;
+    for (size_t i = 0; i < SaltSize; i += 4) {
+      std::uint32_t bits = source();
+      std::memcpy(salt.data() + i, & bits, 4);
+    }
+    return create(password, cost, salt);
+  }
 
-            std::cout << "1. View Game\n";
+  // Takes the full cost whether or not the password is right, and compares
+  // every byte, so timing does not reveal how close a guess was
+  bool matches(std::string_view password) const {
+    Sha256::Digest candidate = derive(password, salt.data(), salt.size(), std::max < std::uint32_t > (cost, 1));
+    unsigned char difference = 0;
+    for (size_t i = 0; i < digest.size(); ++i) difference |= static_cast < unsigned char > (candidate[i] ^ digest[i]);
+    volatile unsigned char settled = difference; // keeps the loop from exiting early
+    return cost != 0 && settled == 0;
+  }
 
-            std::cout << "2. back\n";
+  // Fixed-size binary form, for snapshots and the log
+  std::string serialize() const {
+    std::string bytes(SerializedSize, '\0');
+    std::memcpy( & bytes[0], & cost, 4);
+    std::memcpy( & bytes[4], salt.data(), SaltSize);
+    std::memcpy( & bytes[4 + SaltSize], digest.data(), digest.size());
+    return bytes;
+  }
 
-            std::cout << "Enter your choice: ";
+  static PasswordHash deserialize(std::string_view bytes) {
+    if (bytes.size() != SerializedSize) throw std::runtime_error("Malformed password hash");
+    PasswordHash hash;
+    std::memcpy( & hash.cost, bytes.data(), 4);
+    std::memcpy(hash.salt.data(), bytes.data() + 4, SaltSize);
+    std::memcpy(hash.digest.data(), bytes.data() + 4 + SaltSize, hash.digest.size());
+    return hash;
+  }
+};
 
-            std::cin >> input;
+// User Class
+class User {
+  private:
+    std::string userId;
+    std::string username;
+    std::string email;
+    PasswordHash credential;
+    UserRole role;  
+    GameSet library;
+    GameSet wishlist;
 
-            if (input == "1") {
+  public:
+    User(const std::string & id,
+    const std::string & username,
+    const std::string & email,
+    const PasswordHash & credential,
+    UserRole role)
+    : userId(id),
+    username(username),
+    email(email),
+    credential(credential),
+    role(role) {}
+    
+    // Deliberately slow; GameMarketplace::authenticate runs it on its hashing pool
+    bool login(std::string_view enteredPassword) const {
+    return credential.matches(enteredPassword);
+    }
 
-              std::string gameTitle;
+    // Snapshots persist the stored credential as-is
+    friend class GameMarketplace;
 
-              std::cout << "Enter the title of the game to view: ";
+    //Getters
+    std::string_view getUsername() const {
+        return username;
+    }
+    std::string_view getUserId() const {
+        return userId;
+    }
+    std::string_view getEmail() const {
+        return email;
+    }
+    UserRole getRole() const {
+        return role;
+    }
+    const GameSet & getLibrary() const {
+        return library;
+    }
+    const GameSet & getWishlist() const {
+        return wishlist;
+    }
 
-              std::cin.ignore(); // Ignore the newline character in buffer
+    bool owns(GameHandle game) const {
+        return library.contains(game);
+    }
+    bool wishlisted(GameHandle game) const {
+        return wishlist.contains(game);
+    }
 
-              std::getline(std::cin, gameTitle);
+    // Each returns false if nothing changed
+    bool addToLibrary(Game * game) {
+        return library.insert(game -> getHandle());
+    }
+    bool removeFromLibrary(Game * game) {
+        return library.erase(game -> getHandle());
+    }
 
-              Game * selectedGame = nullptr;
+  bool addToWishlist(Game * game) {
+    return wishlist.insert(game -> getHandle());
+    }
+  bool removeFromWishlist(Game * game) {
+    return wishlist.erase(game -> getHandle());
+    }
 
-              for (const auto & game: games) {
 
-                if (game -> getTitle() == gameTitle) {
+  // Method to review a game
 
-                  selectedGame = game;
+  void reviewGame(Game * game,
+    const std::string & reviewText, int rating) {
 
-                  break;
+    // Check if the game is in the user's library
 
-                }
+    if (owns(game -> getHandle())) {
 
-              }
-
-              if (selectedGame) {
-
-                while (true) {
-                    //GAME DETAILS
-                    std::cout << "\nGame Details:\n";
-                    std::cout << "Title: " << selectedGame -> getTitle() << std::endl;
-                    std::cout << "Genre: " << selectedGame -> getGenre() << std::endl;
-                    std::cout << "Description: " << selectedGame -> getDescription() << std::endl;
-                    std::cout << "Price: $" << selectedGame -> getPrice() << std::endl;
-
-                    std::string ratingString;
-                    switch(selectedGame->getRating()) {
-                        case GameRating::E: ratingString = "Everyone"; break;
-                        case GameRating::E10: ratingString = "Everyone 10+"; break;
-                        case GameRating::T: ratingString = "Teen"; break;
-                        case GameRating::M: ratingString = "Mature"; break;
-                        case GameRating::AO: ratingString = "Adults Only"; break;
-                        default: ratingString = "Unknown"; break;
-                    }
-                    std::cout << "Maturity Rating: " << ratingString << std::endl;
+      game -> addReview(reviewText, rating);
 
-                    std::cout << "Release Date: " << selectedGame -> getReleaseDate() << std::endl;
-                    //End of details
+    } else {
 
-                  // ... (Display other details)
+      throw std::runtime_error("You can only review games in your library");
 
-                  std::cout << "\nOptions:\n";
+    }
 
-                  std::cout << "1. Buy Game\n";
+  }
 
-                  std::cout << "2. Add to Wishlist\n";
+};
 
-                  std::cout << "3. Review Game\n";
+// Administrator Class
+class Administrator {
 
-                  std::cout << "4. See Reviews\n";
+  private:
+    std::string adminId;
+    std::string username;
+    PasswordHash credential;
 
-                  std::cout << "5. back\n";
+  public:
+    Administrator(const std::string & id,
+      const std::string & username,
+      const PasswordHash & credential)
+    : adminId(id),
+  username(username),
+  credential(credential) {}
 
-                  std::cout << "Enter your choice: ";
+  // Deliberately slow, like User::login
+  bool login(std::string_view enteredPassword) const {
+    return credential.matches(enteredPassword);
+  }
+  const PasswordHash & getCredential() const {
+    return credential;
+  }
 
-                  std::cin >> input;
+  std::string_view getAdminUsername() const {
+        return username;
+    }
+  std::string_view getAdminId() const {
+        return adminId;
+    }
 
-                  if (input == "1") { //buy game
+};
 
-                    if (loggedIn) 
-                    {
+// Class for Community Posts
+class Post {
+  public:
+    std::uint64_t postId = 0; // assigned by CommunityFeed, increasing and never reused
+    std::string userId; // User who created the post
+    std::string content;
+    std::time_t timestamp = 0;
 
-                        // Check if the game is already in the library
-                        bool gameInLibrary = false;
-                        for (const auto& libraryGame : currentUser->getLibrary()) 
-                        {
-                            if (libraryGame->getTitle() == selectedGame->getTitle()) 
-                            {
-                                gameInLibrary = true;
-                                break;
-                            }
-                        }
+    Post() = default;
+    Post(std::uint64_t id,
+    std::string userId,
+    std::string content, std::time_t timestamp)
+    : postId(id),
+    userId(std::move(userId)),
+    content(std::move(content)),
+    timestamp(timestamp) {}
+};
 
-                        if (!gameInLibrary) 
-                            {
-                                // Simulate basic purchase logic
-                                // In a real system, you'd integrate payment processing here
-                                currentUser->addToLibrary(selectedGame);
-                                std::cout << "Game '" << selectedGame->getTitle() << "' purchased and added to your library.\n";
-                            } 
-                        else 
-                            {
-                                    std::cout << "You already own this game in your library.\n";
-                            }
+// Trigram inverted index used by searchGames for substring matching.
+// Every 3-byte window of an indexed string maps to a posting list of catalog
+// slots. Posting lists are kept sorted by slot; catalog slots are never
+// reused, so adding a new game's title only ever appends to them.
+class TrigramIndex {
+  private:
+    std::unordered_map < std::uint32_t, std::vector < std::uint32_t >> postings;
 
-                    } else {
+    static std::uint32_t trigramAt(std::string_view text, size_t pos) {
+      return (static_cast < std::uint32_t > (static_cast < unsigned char > (text[pos])) << 16) |
+        (static_cast < std::uint32_t > (static_cast < unsigned char > (text[pos + 1])) << 8) |
+        static_cast < std::uint32_t > (static_cast < unsigned char > (text[pos + 2]));
+    }
 
-                      std::cout << "You need to be logged in to buy a game.\n";
+    static void trigramsOf(std::string_view text, std::vector < std::uint32_t > & grams) {
+      grams.clear();
+      if (text.size() < 3) return;
+      for (size_t i = 0; i + 3 <= text.size(); ++i) {
+        grams.push_back(trigramAt(text, i));
+      }
+      std::sort(grams.begin(), grams.end());
+      grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+    }
 
-                    }
+  public:
+    // Buffers reused across queries so a warm search does not allocate
+    struct Scratch {
+      std::vector < std::uint32_t > grams;
+      std::vector < const std::vector < std::uint32_t > * > lists;
+      std::vector < std::uint32_t > merged;
+    };
+
+    // Queries shorter than a trigram cannot be answered from the index
+    static bool canAnswer(std::string_view query) {
+      return query.size() >= 3;
+    }
 
-                  } else if (input == "2") { //add to wishlist
-                    if (loggedIn) 
-                    {
-
-                        // Check if the game is already in the wishlist
-                        bool gameInWishlist = false;
-                        for (const auto& WlGame : currentUser->getWishlist()) 
-                        {
-                            if (WlGame->getTitle() == selectedGame->getTitle()) 
-                            {
-                                gameInWishlist = true;
-                                break;
-                            }
-                        }
-
-                        if (!gameInWishlist) 
-                            {
-                                // Simulate basic purchase logic
-                                // In a real system, you'd integrate payment processing here
-                                currentUser->addToWishlist(selectedGame);
-                                std::cout << "Game '" << selectedGame->getTitle() << "' added to your wish list.\n";
-                            } 
-                        else 
-                            {
-                                    std::cout << "You already have this game in your wish list.\n";
-                            }
-
-                    } else {
-
-                      std::cout << "You need to be logged to add a game to the wishlist.\n";
+    void add(std::uint32_t slot, std::string_view text) {
+      std::vector < std::uint32_t > grams;
+      trigramsOf(text, grams);
+      for (std::uint32_t gram: grams) {
+        std::vector < std::uint32_t > & list = postings[gram];
+        if (list.empty() || list.back() < slot) {
+          list.push_back(slot);
+        } else {
+          list.insert(std::lower_bound(list.begin(), list.end(), slot), slot);
+        }
+      }
+    }
 
-                    }
+    void remove(std::uint32_t slot, std::string_view text) {
+      std::vector < std::uint32_t > grams;
+      trigramsOf(text, grams);
+      for (std::uint32_t gram: grams) {
+        auto found = postings.find(gram);
+        if (found == postings.end()) continue;
+        std::vector < std::uint32_t > & list = found -> second;
+        auto it = std::lower_bound(list.begin(), list.end(), slot);
+        if (it != list.end() && * it == slot) list.erase(it);
+        if (list.empty()) postings.erase(found);
+      }
+    }
 
-                  } else if (input == "3") { //review game
-                    if (loggedIn) 
-                    {
-                        // Check if the game is in the user's library
-                        bool gameInLibrary = false;
-                        for (const auto& libraryGame : currentUser->getLibrary()) 
-                        {
-                            if (libraryGame->getTitle() == selectedGame->getTitle()) 
-                            {
-                                gameInLibrary = true;
-                                break;
-                            }
-                        }
-
-                        if (gameInLibrary) 
-                        {
-                            int rating;
-                            std::string reviewText;
-
-                            std::cout << "Enter your review (text): ";
-                            std::cin.ignore();
-                            std::getline(std::cin, reviewText);
-
-                            while (true) 
-                            {
-                                std::cout << "Enter rating (1-5 stars): ";
-                                std::cin >> rating;
-
-                                // Validate rating
-                                if (rating >= 1 && rating <= 5) 
-                                {
-                                    try 
-                                    {
-                                        currentUser->reviewGame(selectedGame, reviewText, rating);
-                                        std::cout << "Review submitted successfully!\n";
-                                        break;
-                                    } catch (const std::exception& e) 
-                                    {
-                                        std::cout << "Error: " << e.what() << std::endl;
-                                    }
-                                } 
-                                else 
-                                {
-                                    std::cout << "Invalid rating. Please enter a rating between 1 and 5.\n";
-                                }
-                            }
-                        } 
-                        else 
-                        {
-                            std::cout << "You can only review games in your library.\n";
-                        }
-                    } 
-                    else 
-                    {
-
-                      std::cout << "You need to be logged in to review a game.\n";
+    // Fills result with the sorted slots whose text contains every trigram of
+    // the query. Callers still have to re-check the candidates, since sharing
+    // all trigrams does not guarantee the query appears as one contiguous substring.
+    void candidates(std::string_view query, std::vector < std::uint32_t > & result, Scratch & scratch) const {
+      result.clear();
+      scratch.lists.clear();
+      trigramsOf(query, scratch.grams);
+      for (std::uint32_t gram: scratch.grams) {
+        auto found = postings.find(gram);
+        if (found == postings.end()) return;
+        scratch.lists.push_back( & found -> second);
+      }
+      if (scratch.lists.empty()) return;
+
+      // Intersect starting from the shortest list to keep the work small
+      std::sort(scratch.lists.begin(), scratch.lists.end(), [](const auto * a, const auto * b) {
+        return a -> size() < b -> size();
+      });
+      result.assign(scratch.lists[0] -> begin(), scratch.lists[0] -> end());
+      for (size_t i = 1; i < scratch.lists.size() && !result.empty(); ++i) {
+        scratch.merged.clear();
+        std::set_intersection(result.begin(), result.end(),
+          scratch.lists[i] -> begin(), scratch.lists[i] -> end(), std::back_inserter(scratch.merged));
+        result.swap(scratch.merged);
+      }
+    }
 
-                    }
+    std::vector < std::uint32_t > candidates(std::string_view query) const {
+      std::vector < std::uint32_t > result;
+      Scratch scratch;
+      candidates(query, result, scratch);
+      return result;
+    }
+};
 
-                  } else if (input == "4") { //see reviews
+// Folds text for search: ASCII, Latin-1, Latin Extended-A, Greek and
+// Cyrillic letters are lowercased with their accents stripped ("Pokémon" ->
+// "pokemon", "Straße" -> "strasse") and combining marks are dropped.
+// Anything else is copied through unchanged, so the result is still UTF-8
+// and folding twice gives the same text.
+inline void foldForSearch(std::string_view text, std::string & out) {
+  // Base letters for U+00C0..U+00FF and U+0100..U+017F; '*' marks the
+  // entries that expand to two letters or are not letters at all
+  static const char latin1[] = "aaaaaa*ceeeeiiiidnooooo*ouuuuy**aaaaaa*ceeeeiiiidnooooo*ouuuuy*y";
+  static const char latinExtendedA[] =
+    "aaaaaacccccccc" "dddd" "eeeeeeeeee" "gggggggg" "hhhh" "iiiiiiiiii" "**" "jj" "kkk" "llllllllll"
+    "nnnnnnnnn" "oooooo" "**" "rrrrrr" "ssssssss" "tttttt" "uuuuuuuuuuuu" "ww" "yyy" "zzzzzz" "s";
+  static_assert(sizeof(latin1) == 65 && sizeof(latinExtendedA) == 129, "one entry per code point");
+
+  auto putCodePoint = [ & ](std::uint32_t cp) {
+    if (cp < 0x80) {
+      out.push_back(static_cast < char > (cp));
+    } else {
+      out.push_back(static_cast < char > (0xC0 | (cp >> 6)));
+      out.push_back(static_cast < char > (0x80 | (cp & 0x3F)));
+    }
+  };
+
+  out.clear();
+  out.reserve(text.size());
+  for (size_t i = 0; i < text.size(); ++i) {
+    unsigned char lead = static_cast < unsigned char > (text[i]);
+    if (lead < 0x80) {
+      out.push_back(static_cast < char > (lead >= 'A' && lead <= 'Z' ? lead + ('a' - 'A') : lead));
+      continue;
+    }
+    // Only two-byte sequences are folded; longer ones and stray bytes pass through
+    unsigned char next = i + 1 < text.size() ? static_cast < unsigned char > (text[i + 1]) : 0;
+    if ((lead & 0xE0) != 0xC0 || (next & 0xC0) != 0x80) {
+      out.push_back(static_cast < char > (lead));
+      continue;
+    }
+    ++i;
+    std::uint32_t cp = ((lead & 0x1Fu) << 6) | (next & 0x3Fu);
+    if (cp >= 0x300 && cp <= 0x36F) continue; // combining diacritics
+    if (cp >= 0xC0 && cp <= 0xFF && latin1[cp - 0xC0] != '*') {
+      out.push_back(latin1[cp - 0xC0]);
+    } else if (cp >= 0x100 && cp <= 0x17F && latinExtendedA[cp - 0x100] != '*') {
+      out.push_back(latinExtendedA[cp - 0x100]);
+    } else if (cp == 0xC6 || cp == 0xE6) {
+      out += "ae";
+    } else if (cp == 0xDF) {
+      out += "ss";
+    } else if (cp == 0xDE || cp == 0xFE) {
+      out += "th";
+    } else if (cp == 0x132 || cp == 0x133) {
+      out += "ij";
+    } else if (cp == 0x152 || cp == 0x153) {
+      out += "oe";
+    } else if (cp >= 0x391 && cp <= 0x3A9) {
+      putCodePoint(cp + 0x20); // Greek capitals
+    } else if (cp >= 0x386 && cp <= 0x38F) {
+      // Greek capitals with tonos
+      static const std::uint16_t tonos[] = {0x3B1, 0x387, 0x3B5, 0x3B7, 0x3B9, 0x38B, 0x3BF, 0x38D, 0x3C5, 0x3C9};
+      putCodePoint(tonos[cp - 0x386]);
+    } else if (cp >= 0x3AC && cp <= 0x3AF) {
+      static const std::uint16_t tonos[] = {0x3B1, 0x3B5, 0x3B7, 0x3B9};
+      putCodePoint(tonos[cp - 0x3AC]);
+    } else if (cp >= 0x3CC && cp <= 0x3CE) {
+      static const std::uint16_t tonos[] = {0x3BF, 0x3C5, 0x3C9};
+      putCodePoint(tonos[cp - 0x3CC]);
+    } else if (cp == 0x3C2) {
+      putCodePoint(0x3C3); // final sigma
+    } else if (cp == 0x401 || cp == 0x451) {
+      putCodePoint(0x435); // Cyrillic yo searches as ye
+    } else if (cp >= 0x410 && cp <= 0x42F) {
+      putCodePoint(cp + 0x20); // Cyrillic capitals
+    } else if (cp >= 0x400 && cp <= 0x40F) {
+      putCodePoint(cp + 0x50);
+    } else {
+      putCodePoint(cp);
+    }
+  }
+}
+
+inline std::string foldForSearch(std::string_view text) {
+  std::string folded;
+  foldForSearch(text, folded);
+  return folded;
+}
+
+// Calls fn on each word of folded text. Words are runs of ASCII letters and
+// digits or of non-ASCII bytes, so folded accented letters stay inside words.
+template < typename Fn >
+void forEachSearchWord(std::string_view folded, Fn && fn) {
+  auto isWordByte = [](unsigned char c) {
+    return c >= 0x80 || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9');
+  };
+  size_t i = 0;
+  while (i < folded.size()) {
+    while (i < folded.size() && !isWordByte(static_cast < unsigned char > (folded[i]))) ++i;
+    size_t start = i;
+    while (i < folded.size() && isWordByte(static_cast < unsigned char > (folded[i]))) ++i;
+    if (i > start) fn(folded.substr(start, i - start));
+  }
+}
+
+// Typo-tolerant lookup of title words. Every distinct folded word is a path
+// in a trie of first-child/next-sibling nodes. A query word walks the trie
+// carrying one row of the edit-distance table per level and abandons any
+// branch whose row has no cell left within the allowed distance, which is
+// what keeps a lookup over a million words to a small fraction of the trie.
+// Distances are counted in bytes and an adjacent transposition is one edit
+// (optimal string alignment), so "gmae" is one edit away from "game".
+class FuzzyWordIndex {
+  private:
+    static constexpr std::uint32_t NoWord = std::numeric_limits < std::uint32_t > ::max();
 
-                    std::cout << "\nReviews for " << selectedGame -> getTitle() << ":\n";
+    struct Node {
+      std::uint32_t firstChild = 0; // 0 = none; the root is never a child
+      std::uint32_t nextSibling = 0;
+      std::uint32_t word = NoWord;
+      char label = 0;
+    };
 
-                    if (selectedGame -> getAverageRating() > 0) {
+    std::vector < Node > nodes = std::vector < Node > (1);
+    std::vector < std::vector < std::uint32_t >> postings; // sorted slots per word id
 
-                      for (const auto & review: selectedGame -> getReviews()) {
+    std::uint32_t childOf(std::uint32_t node, char label) const {
+      for (std::uint32_t child = nodes[node].firstChild; child != 0; child = nodes[child].nextSibling) {
+        if (nodes[child].label == label) return child;
+      }
+      return 0;
+    }
 
-                        std::cout << review.first << " - " << review.second << " stars\n";
+    std::uint32_t wordId(std::string_view word, bool create) {
+      std::uint32_t node = 0;
+      for (char label: word) {
+        std::uint32_t child = childOf(node, label);
+        if (child == 0) {
+          if (!create) return NoWord;
+          child = static_cast < std::uint32_t > (nodes.size());
+          nodes.push_back(Node());
+          nodes[child].label = label;
+          nodes[child].nextSibling = nodes[node].firstChild;
+          nodes[node].firstChild = child;
+        }
+        node = child;
+      }
+      if (nodes[node].word == NoWord && create) {
+        nodes[node].word = static_cast < std::uint32_t > (postings.size());
+        postings.emplace_back();
+      }
+      return nodes[node].word;
+    }
 
-                      }
+    static void distinctWords(std::string_view folded, std::vector < std::string_view > & words) {
+      words.clear();
+      forEachSearchWord(folded, [ & ](std::string_view word) {
+        words.push_back(word);
+      });
+      std::sort(words.begin(), words.end());
+      words.erase(std::unique(words.begin(), words.end()), words.end());
+    }
 
-                      std::cout << "Average rating: " << selectedGame -> getAverageRating() << " stars\n";
+  public:
+    struct Match {
+      std::uint32_t word;
+      int distance;
+    };
+
+    // Buffers reused across lookups
+    struct Scratch {
+      std::vector < int > rows; // one row of query.size() + 1 cells per trie level
+      std::string path;
+      std::vector < std::string_view > words;
+    };
+
+    // Typos allowed for a query word: none for short words, which would
+    // otherwise match half the catalog, then one, then two from 8 bytes up
+    static int allowedTypos(size_t length) {
+      return length < 4 ? 0 : length < 8 ? 1 : 2;
+    }
 
-                    } else {
+    // Edit distance between a and b if it is at most maxDistance, otherwise maxDistance + 1
+    static int boundedDistance(std::string_view a, std::string_view b, int maxDistance) {
+      size_t gap = a.size() > b.size() ? a.size() - b.size() : b.size() - a.size();
+      if (gap > static_cast < size_t > (maxDistance)) return maxDistance + 1;
+      thread_local std::vector < int > rows;
+      const size_t width = b.size() + 1;
+      rows.assign(3 * width, 0);
+      int * older = rows.data(), * previous = older + width, * current = previous + width;
+      for (size_t j = 0; j < width; ++j) previous[j] = static_cast < int > (j);
+      for (size_t i = 1; i <= a.size(); ++i) {
+        current[0] = static_cast < int > (i);
+        int rowMinimum = current[0];
+        for (size_t j = 1; j < width; ++j) {
+          int cost = a[i - 1] == b[j - 1] ? 0 : 1;
+          int best = std::min({previous[j] + 1, current[j - 1] + 1, previous[j - 1] + cost});
+          if (i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1]) best = std::min(best, older[j - 2] + 1);
+          current[j] = best;
+          rowMinimum = std::min(rowMinimum, best);
+        }
+        if (rowMinimum > maxDistance) return maxDistance + 1;
+        std::swap(older, previous);
+        std::swap(previous, current);
+      }
+      return std::min(previous[b.size()], maxDistance + 1);
+    }
 
-                      std::cout << "There are no reviews for this game yet.\n";
+    void add(std::uint32_t slot, std::string_view folded) {
+      std::vector < std::string_view > words;
+      distinctWords(folded, words);
+      for (std::string_view word: words) {
+        std::vector < std::uint32_t > & list = postings[wordId(word, true)];
+        if (list.empty() || list.back() < slot) {
+          list.push_back(slot);
+        } else {
+          list.insert(std::lower_bound(list.begin(), list.end(), slot), slot);
+        }
+      }
+    }
 
-                    }
+    // Words stay in the trie once seen; only their posting lists shrink
+    void remove(std::uint32_t slot, std::string_view folded) {
+      std::vector < std::string_view > words;
+      distinctWords(folded, words);
+      for (std::string_view word: words) {
+        std::uint32_t id = wordId(word, false);
+        if (id == NoWord) continue;
+        std::vector < std::uint32_t > & list = postings[id];
+        auto it = std::lower_bound(list.begin(), list.end(), slot);
+        if (it != list.end() && * it == slot) list.erase(it);
+      }
+    }
 
-                  } else if (input == "5") { //back
+    const std::vector < std::uint32_t > & slotsOf(std::uint32_t word) const {
+      return postings[word];
+    }
 
-                    break; // Go back to browse games
-
-                  } else {
-                    std::cout << "Invalid choice!\n";
-                  }
-
-                }
-
-              } else {
-
-                std::cout << "Game not found!\n";
-
-              }
-
-            } else if (input == "2") {
-
-              break; // Go back to browse games menu
+    // Fills result with every indexed word within maxDistance edits of query
+    void lookup(std::string_view query, int maxDistance, std::vector < Match > & result, Scratch & scratch) const {
+      result.clear();
+      const size_t width = query.size() + 1;
+      const size_t maxDepth = query.size() + static_cast < size_t > (maxDistance);
+      scratch.rows.resize((maxDepth + 1) * width);
+      scratch.path.resize(maxDepth + 1);
+      for (size_t j = 0; j < width; ++j) scratch.rows[j] = static_cast < int > (j);
+
+      // Depth-first, one table row per level; a row is only valid while its
+      // node is on the current path, which is all the transposition step reads
+      auto walk = [ & ](auto & self, std::uint32_t node, size_t depth) -> void {
+        if (depth == maxDepth) return;
+        const int * previous = & scratch.rows[depth * width];
+        const int * older = depth > 0 ? previous - width : nullptr;
+        int * current = & scratch.rows[(depth + 1) * width];
+        for (std::uint32_t child = nodes[node].firstChild; child != 0; child = nodes[child].nextSibling) {
+          const char label = nodes[child].label;
+          current[0] = static_cast < int > (depth + 1);
+          int rowMinimum = current[0];
+          for (size_t j = 1; j < width; ++j) {
+            int cost = query[j - 1] == label ? 0 : 1;
+            int best = std::min({previous[j] + 1, current[j - 1] + 1, previous[j - 1] + cost});
+            if (older && j > 1 && query[j - 1] == scratch.path[depth - 1] && query[j - 2] == label) {
+              best = std::min(best, older[j - 2] + 1);
+            }
+            current[j] = best;
+            rowMinimum = std::min(rowMinimum, best);
+          }
+          if (nodes[child].word != NoWord && current[query.size()] <= maxDistance) {
+            result.push_back({nodes[child].word, current[query.size()]});
+          }
+          if (rowMinimum <= maxDistance) {
+            scratch.path[depth] = label;
+            self(self, child, depth + 1);
+          }
+        }
+      };
+      walk(walk, 0, 0);
+    }
+};
 
-            } else {
+// Open-addressing hash index from a string key to the games carrying it.
+// Entries store the key's hash and the Game; the key itself is read back from
+// the Game through KeyOf, so the table never copies strings. Several games may
+// share a key; find() returns the one created first (lowest creation sequence).
+template < typename KeyOf >
+class GameHashIndex {
+  private:
+    struct Entry {
+      size_t hash;
+      Game * game; // nullptr = empty, tombstone() = erased
+    };
 
-              std::cout << "Invalid choice!\n";
+    std::vector < Entry > table;
+    size_t liveEntries = 0;
+    size_t usedEntries = 0; // live entries plus tombstones
 
-            }
+    static Game * tombstone() {
+      return reinterpret_cast < Game * > (static_cast < std::uintptr_t > (1));
+    }
 
-          } else if (input == "3") { //navbar
+    static size_t hashOf(std::string_view key) {
+      return std::hash < std::string_view > {}(key);
+    }
 
-            break; // Go back to navbar
+    void rehash(size_t capacity) {
+      std::vector < Entry > old;
+      old.swap(table);
+      table.assign(capacity, Entry {0, nullptr});
+      liveEntries = usedEntries = 0;
+      for (const Entry & entry: old) {
+        if (entry.game && entry.game != tombstone()) place(entry.hash, entry.game);
+      }
+    }
 
-          } else {
+    void place(size_t hash, Game * game) {
+      size_t mask = table.size() - 1;
+      size_t i = hash & mask;
+      while (table[i].game && table[i].game != tombstone()) i = (i + 1) & mask;
+      if (!table[i].game) usedEntries++;
+      table[i] = Entry {hash, game};
+      liveEntries++;
+    }
 
-            std::cout << "Invalid choice!\n";
+  public:
+    void reserve(size_t count) {
+      size_t capacity = std::max < size_t > (16, table.size());
+      while (count * 10 > capacity * 5) capacity *= 2;
+      if (capacity > table.size()) rehash(capacity);
+    }
 
-          }
+    void insert(Game * game) {
+      // Keep the probe chains short: at most 70% of the slots in use
+      if ((usedEntries + 1) * 10 > table.size() * 7) {
+        // Grow if live entries need the room, otherwise just drop the tombstones
+        size_t capacity = table.empty() ? 16 : table.size();
+        while ((liveEntries + 1) * 10 > capacity * 5) capacity *= 2;
+        rehash(capacity);
+      }
+      place(hashOf(KeyOf::get(game)), game);
+    }
 
+    // The key is passed in so games can be erased under a key they no longer carry
+    bool erase(Game * game, std::string_view key) {
+      if (table.empty()) return false;
+      size_t hash = hashOf(key);
+      size_t mask = table.size() - 1;
+      for (size_t i = hash & mask; table[i].game; i = (i + 1) & mask) {
+        if (table[i].game == game) {
+          table[i].game = tombstone();
+          liveEntries--;
+          return true;
         }
+      }
+      return false;
+    }
 
-    } else if (input == "3") { // Search Games
-    std::cout << "Advanced Search Options:\n";
-    
-    // Initialize search parameters with default values
-    std::string titleQuery = "";
-    double minPrice = 0.0;
-    double maxPrice = std::numeric_limits<double>::max();
-    std::string categoryQuery = "";
-    GameRating rating = GameRating::E;
-    std::time_t minReleaseDate = 0;
-    std::time_t maxReleaseDate = std::numeric_limits<std::time_t>::max();
-
-    // Title search
-    std::cout << "Enter game title (or press Enter to skip): ";
-    std::cin.ignore();
-    std::getline(std::cin, titleQuery);
-
-    // Price range
-    std::cout << "Enter minimum price (0 to skip): ";
-    std::cin >> minPrice;
-    std::cout << "Enter maximum price (enter a large number to skip): ";
-    std::cin >> maxPrice;
-
-    // Category/Genre
-    std::cout << "Enter game category/genre (or press Enter to skip): ";
-    std::cin.ignore();
-    std::getline(std::cin, categoryQuery);
-
-    // Rating
-    std::cout << "Select game rating:\n";
-    std::cout << "1. E (Everyone)\n";
-    std::cout << "2. E10 (Everyone 10+)\n";
-    std::cout << "3. T (Teen)\n";
-    std::cout << "4. M (Mature)\n";
-    std::cout << "5. AO (Adults Only)\n";
-    std::cout << "0. Skip rating filter\n";
-    std::cout << "Enter your choice: ";
-    int ratingChoice;
-    std::cin >> ratingChoice;
-
-    switch(ratingChoice) {
-        case 1: rating = GameRating::E; break;
-        case 2: rating = GameRating::E10; break;
-        case 3: rating = GameRating::T; break;
-        case 4: rating = GameRating::M; break;
-        case 5: rating = GameRating::AO; break;
-        default: rating = GameRating::E; break;
-    }
-
-    // Release date range
-    std::cout << "Enter earliest release date (Unix timestamp, 0 to skip): ";
-    std::cin >> minReleaseDate;
-    std::cout << "Enter latest release date (Unix timestamp, a large number to skip): ";
-    std::cin >> maxReleaseDate;
-
-    // Perform search
-    std::vector<Game*> searchResults = searchGames(titleQuery, minPrice, maxPrice, 
-                                                   categoryQuery, rating, 
-                                                   minReleaseDate, maxReleaseDate);
-
-    if (!searchResults.empty()) {
-        std::cout << "\nSearch results:\n";
-        for (const auto& game : searchResults) {
-            std::cout << "- " << game->getTitle() 
-                      << " (Price: $" << game->getPrice() 
-                      << ", Genre: " << game->getGenre() 
-                      << ", Rating: " << static_cast<int>(game->getRating()) 
-                      << ")\n";
+    Game * find(std::string_view key) const {
+      if (table.empty()) return nullptr;
+      size_t hash = hashOf(key);
+      size_t mask = table.size() - 1;
+      Game * first = nullptr;
+      for (size_t i = hash & mask; table[i].game; i = (i + 1) & mask) {
+        const Entry & entry = table[i];
+        if (entry.game != tombstone() && entry.hash == hash && KeyOf::get(entry.game) == key &&
+          (!first || entry.game -> getSequence() < first -> getSequence())) {
+          first = entry.game;
         }
-    } else {
-        std::cout << "No games found matching your search criteria.\n";
+      }
+      return first;
     }
-      
-     } else if (input == "4") { // Library
-
-        if (loggedIn) {
+};
 
-          while (true) {
+struct GameTitleKey {
+  static std::string_view get(const Game * game) {
+    return game -> getTitle();
+  }
+};
 
-            std::cout << "\nLibrary:\n";
+struct GameIdKey {
+  static std::string_view get(const Game * game) {
+    return game -> getGameId();
+  }
+};
 
+// Lookup layer over the catalog: games by title and by id through hash
+// indexes, and each developer's games in creation order
+class CatalogIndex {
+  private:
+    GameHashIndex < GameTitleKey > byTitle;
+    GameHashIndex < GameIdKey > byId;
+    // Keys view the developer name of the first game filed under them, which
+    // stays valid because game text lives in the arena for the store's lifetime
+    std::unordered_map < std::string_view, std::vector < Game * >> byDeveloper;
+    const std::vector < Game * > noGames;
 
-            if (currentUser) {
+  public:
+    void reserve(size_t count) {
+      byTitle.reserve(count);
+      byId.reserve(count);
+    }
 
-              for (const auto & game: currentUser -> getLibrary()) {
+    void add(Game * game) {
+      byTitle.insert(game);
+      byId.insert(game);
+      byDeveloper[game -> getDeveloperName()].push_back(game);
+    }
 
-                std::cout << "- " << game -> getTitle() << std::endl;
+    void remove(Game * game) {
+      byTitle.erase(game, game -> getTitle());
+      byId.erase(game, game -> getGameId());
+      auto found = byDeveloper.find(game -> getDeveloperName());
+      if (found != byDeveloper.end()) {
+        auto & list = found -> second;
+        list.erase(std::find(list.begin(), list.end(), game));
+        if (list.empty()) byDeveloper.erase(found);
+      }
+    }
 
-              }
+    // Call with the title the game had before Game::rename
+    void renamed(Game * game, std::string_view oldTitle) {
+      byTitle.erase(game, oldTitle);
+      byTitle.insert(game);
+    }
 
-            } else {
+    Game * findByTitle(std::string_view title) const {
+      return byTitle.find(title);
+    }
 
-              std::cout << "You need to log in to view your library.\n";
+    Game * findById(std::string_view gameId) const {
+      return byId.find(gameId);
+    }
 
-            }
+    const std::vector < Game * > & byDeveloperName(std::string_view developer) const {
+      auto found = byDeveloper.find(developer);
+      return found == byDeveloper.end() ? noGames : found -> second;
+    }
+};
 
-            std::cout << "\nOptions:\n";
+// ---------------------------------------------------------------------------
+// Snapshot persistence
+//
+// A snapshot file is a fixed header followed by a cold section and a hot
+// section. The hot section holds everything needed to rebuild the in-memory
+// structures (ids, titles, prices, users, ...). The cold section holds bulky
+// text that is rarely read: game descriptions and review text. Loading maps
+// the file and points those fields straight into the mapping, so cold pages
+// are only read from disk when something actually displays them.
+//
+// Cold strings are stored back to back without lengths; their lengths sit in
+// the hot records, so both sections must be written and read in the same order.
+// ---------------------------------------------------------------------------
+
+// 64-bit hash in the style of XXH64, used for snapshot checksums
+inline std::uint64_t checksum64(const unsigned char * data, size_t length, std::uint64_t seed) {
+  const std::uint64_t prime1 = 11400714785074694791ULL, prime2 = 14029467366897019727ULL,
+    prime3 = 1609587929392839161ULL, prime4 = 9650029242287828579ULL, prime5 = 2870177450012600261ULL;
+  auto rotl = [](std::uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+  };
+  auto read64 = [](const unsigned char * p) {
+    std::uint64_t v;
+    std::memcpy( & v, p, sizeof(v));
+    return v;
+  };
+  auto mixRound = [ & ](std::uint64_t acc, std::uint64_t input) {
+    return rotl(acc + input * prime2, 31) * prime1;
+  };
+  auto merge = [ & ](std::uint64_t acc, std::uint64_t lane) {
+    return (acc ^ mixRound(0, lane)) * prime1 + prime4;
+  };
+
+  const unsigned char * p = data;
+  const unsigned char * end = data + length;
+  std::uint64_t h;
+  if (length >= 32) {
+    std::uint64_t v1 = seed + prime1 + prime2, v2 = seed + prime2, v3 = seed, v4 = seed - prime1;
+    for (; p + 32 <= end; p += 32) {
+      v1 = mixRound(v1, read64(p));
+      v2 = mixRound(v2, read64(p + 8));
+      v3 = mixRound(v3, read64(p + 16));
+      v4 = mixRound(v4, read64(p + 24));
+    }
+    h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+    h = merge(merge(merge(merge(h, v1), v2), v3), v4);
+  } else {
+    h = seed + prime5;
+  }
+  h += length;
+  for (; p + 8 <= end; p += 8) {
+    h = rotl(h ^ mixRound(0, read64(p)), 27) * prime1 + prime4;
+  }
+  for (; p < end; ++p) {
+    h = rotl(h ^ ( * p * prime5), 11) * prime1;
+  }
+  h ^= h >> 33;
+  h *= prime2;
+  h ^= h >> 29;
+  h *= prime3;
+  h ^= h >> 32;
+  return h;
+}
+
+// Flushes a file, or a directory's entries, to disk
+void syncToDisk(const std::string & path) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw std::runtime_error("Cannot open " + path + " to sync it");
+  }
+  bool synced = ::fsync(fd) == 0;
+  ::close(fd);
+  if (!synced) {
+    throw std::runtime_error("Cannot sync " + path);
+  }
+}
+
+// Makes a rename into path's directory durable
+void syncParentDirectory(const std::string & path) {
+  size_t slash = path.rfind('/');
+  syncToDisk(slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash));
+}
+
+// Sections are checksummed in fixed-size blocks, each block's hash seeding the
+// next, so the writer can stream without holding a section in memory
+constexpr size_t SnapshotBlockSize = 64 * 1024;
+
+inline std::uint64_t sectionChecksum(const unsigned char * data, size_t length) {
+  std::uint64_t checksum = 0;
+  for (size_t offset = 0; offset < length; offset += SnapshotBlockSize) {
+    checksum = checksum64(data + offset, std::min(SnapshotBlockSize, length - offset), checksum);
+  }
+  return checksum;
+}
+
+struct SnapshotHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byteOrder; // SnapshotByteOrder as written by the saving machine
+  std::uint64_t coldBytes;
+  std::uint64_t hotBytes;
+  std::uint64_t coldChecksum;
+  std::uint64_t hotChecksum;
+  std::uint64_t logSequence; // last write-ahead log record the snapshot includes
+};
 
-            std::cout << "1. View Game\n";
+constexpr char SnapshotMagic[8] = {'G', 'M', 'S', 'N', 'A', 'P', '\0', '\0'};
+constexpr std::uint32_t SnapshotVersion = 7;
+constexpr std::uint32_t SnapshotByteOrder = 0x01020304;
 
-            std::cout << "2. Wishlist\n";
+// Buffered writer for one snapshot section that keeps the running checksum
+class SnapshotWriter {
+  private:
+    std::ofstream & out;
+    std::vector < unsigned char > block;
+    std::uint64_t checksum = 0;
+    std::uint64_t bytes = 0;
+
+    void flushBlock() {
+      if (block.empty()) return;
+      checksum = checksum64(block.data(), block.size(), checksum);
+      out.write(reinterpret_cast < const char * > (block.data()), static_cast < std::streamsize > (block.size()));
+      bytes += block.size();
+      block.clear();
+    }
 
-            std::cout << "3. navbar\n";
+  public:
+    explicit SnapshotWriter(std::ofstream & out): out(out) {
+      block.reserve(SnapshotBlockSize);
+    }
 
-            std::cout << "Enter your choice: ";
+    void write(const void * data, size_t length) {
+      const unsigned char * p = static_cast < const unsigned char * > (data);
+      while (length > 0) {
+        size_t chunk = std::min(length, SnapshotBlockSize - block.size());
+        block.insert(block.end(), p, p + chunk);
+        p += chunk;
+        length -= chunk;
+        if (block.size() == SnapshotBlockSize) flushBlock();
+      }
+    }
 
-            std::cin >> input;
+    template < typename T >
+    void put(T value) {
+      write( & value, sizeof(value));
+    }
 
-            if (input == "1") { //view game in library
+    // Length-prefixed string for the hot section
+    void putString(std::string_view text) {
+      put < std::uint32_t > (static_cast < std::uint32_t > (text.size()));
+      write(text.data(), text.size());
+    }
 
-                std::string gameTitle;
-                std::cout << "Enter the title of the game to view: ";
-                std::cin.ignore(); // Ignore the newline character in buffer
-                std::getline(std::cin, gameTitle);
+    // Finishes the section, returning its size and checksum
+    std::pair < std::uint64_t, std::uint64_t > finish() {
+      flushBlock();
+      return {
+        bytes, checksum
+      };
+    }
+};
 
-                Game* selectedGame = nullptr;
-                // Find the game in the user's library
-                for (const auto& libraryGame : currentUser->getLibrary()) 
-                {
-                    if (libraryGame->getTitle() == gameTitle) 
-                    {
-                        selectedGame = libraryGame;
-                        break;
-                    }
-                }
+// Bounds-checked reader over a mapped section
+class SnapshotReader {
+  private:
+    const unsigned char * cursor;
+    const unsigned char * end;
 
-                if (selectedGame) 
-                {
-                    while (true) 
-                    {
-                        //GAME DETAILS
-                        std::cout << "\nGame Details:\n";
-                        std::cout << "Title: " << selectedGame -> getTitle() << std::endl;
-                        std::cout << "Genre: " << selectedGame -> getGenre() << std::endl;
-                        std::cout << "Description: " << selectedGame -> getDescription() << std::endl;
-                        std::cout << "Price: $" << selectedGame -> getPrice() << std::endl;
-
-                        std::string ratingString;
-                        switch(selectedGame->getRating()) {
-                            case GameRating::E: ratingString = "Everyone"; break;
-                            case GameRating::E10: ratingString = "Everyone 10+"; break;
-                            case GameRating::T: ratingString = "Teen"; break;
-                            case GameRating::M: ratingString = "Mature"; break;
-                            case GameRating::AO: ratingString = "Adults Only"; break;
-                            default: ratingString = "Unknown"; break;
-                        }
-                        std::cout << "Maturity Rating: " << ratingString << std::endl;
-
-                        std::cout << "Release Date: " << selectedGame -> getReleaseDate() << std::endl;
-                        //End of details
-
-                        std::cout << "\nOptions:\n";
-                        std::cout << "1. Review Game\n";
-                        std::cout << "2. See Reviews\n";
-                        std::cout << "3. Delete from Library\n";
-                        std::cout << "4. back\n";
-                        std::cout << "Enter your choice: ";
-
-                        std::cin >> input;
-
-                        if (input == "1") 
-                        { // Review game
-                            int rating;
-                            std::string reviewText;
-
-                            std::cout << "Enter your review (text): ";
-                            std::cin.ignore();
-                            std::getline(std::cin, reviewText);
-
-                            while (true) 
-                            {
-                                std::cout << "Enter rating (1-5 stars): ";
-                                std::cin >> rating;
-
-                                // Validate rating
-                                if (rating >= 1 && rating <= 5) 
-                                {
-                                    try 
-                                    {
-                                        currentUser->reviewGame(selectedGame, reviewText, rating);
-                                        std::cout << "Review submitted successfully!\n";
-                                        break;
-                                    } catch (const std::exception& e) 
-                                    {
-                                        std::cout << "Error: " << e.what() << std::endl;
-                                    }
-                                } 
-                                else 
-                                {
-                                    std::cout << "Invalid rating. Please enter a rating between 1 and 5.\n";
-                                }
-                            }
-                        } 
-                        else if (input == "2") 
-                        { // See reviews
-                            std::cout << "\nReviews for " << selectedGame->getTitle() << ":\n";
-                            if (selectedGame->getAverageRating() > 0) 
-                            {
-                                for (const auto& review : selectedGame->getReviews()) 
-                                {
-                                    std::cout << review.first << " - " << review.second << " stars\n";
-                                }
-                                std::cout << "Average rating: " << selectedGame->getAverageRating() << " stars\n";
-                            } 
-                            else 
-                            {
-                                std::cout << "There are no reviews for this game yet.\n";
-                            }
-                        } 
-                        else if (input == "3") 
-                        { // Delete from Library
-                            // Find and remove the game from the library
-                            auto& library = currentUser->getLibrary();
-                            auto it = std::find(library.begin(), library.end(), selectedGame);
-                            if (it != library.end()) 
-                            {
-                                library.erase(it);
-                                std::cout << "Game '" << selectedGame->getTitle() << "' removed from your library.\n";
-                                break; // Exit the game details menu
-                            }
-                        } 
-                        else if (input == "4") 
-                        { // Back
-                            break;
-                        } 
-                        else 
-                        {
-                            std::cout << "Invalid choice!\n";
-                        }
-                    }
-                } 
-                else 
-                {
-                    std::cout << "Game not found in your library!\n";
-                }
+  public:
+    SnapshotReader(const unsigned char * begin, size_t length): cursor(begin), end(begin + length) {}
 
-            } else if (input == "2") { //wishlist
+    std::string_view take(size_t length) {
+      if (static_cast < size_t > (end - cursor) < length) {
+        throw std::runtime_error("Snapshot is truncated");
+      }
+      std::string_view bytes(reinterpret_cast < const char * > (cursor), length);
+      cursor += length;
+      return bytes;
+    }
 
-              while (true) {
+    template < typename T >
+    T get() {
+      T value;
+      std::memcpy( & value, take(sizeof(T)).data(), sizeof(T));
+      return value;
+    }
 
-                std::cout << "\nWishlist:\n";
+    std::string_view getString() {
+      return take(get < std::uint32_t > ());
+    }
+};
 
-                // --- Changed: Library and Wishlist are now attached to user data ---
+// Read-only memory mapping of a whole file, unmapped on destruction
+class MappedFile {
+  private:
+    const unsigned char * base = nullptr;
+    size_t length = 0;
 
-                if (currentUser) 
-                {
-                  for (const auto & game: currentUser -> getWishlist()) {
-                    std::cout << "- " << game -> getTitle() << std::endl;
-                  }
-                } else 
-                {
-                  std::cout << "You need to log in to view your wishlist.\n";
-                }
+  public:
+    explicit MappedFile(const std::string & path) {
+      int fd = ::open(path.c_str(), O_RDONLY);
+      if (fd < 0) {
+        throw std::runtime_error("Cannot open " + path);
+      }
+      struct stat info;
+      if (::fstat(fd, & info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot stat " + path);
+      }
+      length = static_cast < size_t > (info.st_size);
+      if (length > 0) {
+        void * mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+          ::close(fd);
+          throw std::runtime_error("Cannot map " + path);
+        }
+        base = static_cast < const unsigned char * > (mapped);
+      }
+      ::close(fd);
+    }
 
-                std::cout << "\nOptions:\n";
-                std::cout << "1. Add to Wishlist\n";
-                std::cout << "2. View Game \n"; 
-                std::cout << "3. back\n";
-                std::cout << "Enter your choice: ";
-                std::cin >> input;
+    MappedFile(const MappedFile & ) = delete;
+    MappedFile & operator = (const MappedFile & ) = delete;
 
-                if (input == "1") {//add to wishlist
+    ~MappedFile() {
+      if (base) ::munmap(const_cast < unsigned char * > (base), length);
+    }
 
-                  std::string gameTitle;
+    const unsigned char * data() const {
+      return base;
+    }
+    size_t size() const {
+      return length;
+    }
 
-                  std::cout << "Enter the title of the game to add to wishlist: ";
+    // Paging hint for a byte range; the range is widened to whole pages
+    void advise(size_t offset, size_t bytes, int advice) const {
+      if (!base || bytes == 0) return;
+      size_t page = static_cast < size_t > (::sysconf(_SC_PAGESIZE));
+      size_t start = offset / page * page;
+      ::madvise(const_cast < unsigned char * > (base) + start, offset + bytes - start, advice);
+    }
+};
 
-                  std::cin.ignore(); // Ignore the newline character in buffer
+// ---------------------------------------------------------------------------
+// Community feed
+//
+// Posts are kept in an append-only log cut into segments of SegmentCapacity
+// posts. Ids are 64-bit, start at 1, are handed out in posting order and are
+// never reused, so post id N lives at position N - 1 of the log and an id is
+// also a pagination cursor. Ids freed by removals stay behind as tombstones.
+// Each segment packs its posts into one byte buffer:
+//   [i64 timestamp][u32 author length][u32 content length][author][content]
+// Full segments are sealed and never change again (tombstones are kept
+// beside the bytes). When a spill file is set, only the newest sealed
+// segments plus the ones read most recently stay in memory; the rest are
+// written to the file once and read back when a page reaches them, so a page
+// touches only the segments it returns from.
+// ---------------------------------------------------------------------------
+
+class CommunityFeed {
+  public:
+    static constexpr size_t SegmentCapacity = 4096;
+    static constexpr size_t DefaultResidentSegments = 64;
+
+    struct Page {
+      std::vector < Post > posts; // newest first
+      std::uint64_t nextBefore = 0; // cursor for the following page, 0 when this was the last
+    };
+
+    struct Stats {
+      size_t posts; // live posts
+      size_t segments;
+      size_t residentSegments;
+      size_t residentBytes;
+      std::uint64_t spilledBytes;
+    };
 
-                  std::getline(std::cin, gameTitle);
+  private:
+    struct Segment {
+      std::string bytes; // packed records, empty while evicted
+      std::vector < std::uint32_t > offsets; // start of each record, rebuilt on reload
+      std::vector < std::uint8_t > removed; // one flag per record, kept while evicted
+      std::uint32_t count = 0;
+      bool resident = true;
+      bool spilled = false; // already written to the spill file
+      std::uint64_t spillOffset = 0;
+      std::uint64_t spillLength = 0;
+      std::uint64_t lastUse = 0;
+    };
+
+    static constexpr size_t RecordHeaderSize = sizeof(std::int64_t) + 2 * sizeof(std::uint32_t);
+
+    mutable std::mutex mutex; // reads page segments in and out, so they lock too
+    mutable std::vector < Segment > segments;
+    std::unordered_map < std::string, std::vector < std::uint64_t >> timelines; // author -> live ids, oldest first
+    std::uint64_t nextPostId = 1;
+    std::time_t newest = 0;
+    size_t livePosts = 0;
+
+    int spillFd = -1;
+    mutable std::uint64_t spillEnd = 0;
+    size_t maxResident = DefaultResidentSegments;
+    mutable std::vector < size_t > residentSealed; // sealed segments currently in memory
+    mutable std::uint64_t useClock = 0;
+
+    static std::uint32_t readU32(const char * p) {
+      std::uint32_t value;
+      std::memcpy( & value, p, sizeof(value));
+      return value;
+    }
 
-                  Game * selectedGame = nullptr;
+    static Post decode(std::uint64_t id, const Segment & segment, std::uint32_t index) {
+      const char * record = segment.bytes.data() + segment.offsets[index];
+      std::int64_t timestamp;
+      std::memcpy( & timestamp, record, sizeof(timestamp));
+      std::uint32_t authorLength = readU32(record + sizeof(std::int64_t));
+      std::uint32_t contentLength = readU32(record + sizeof(std::int64_t) + sizeof(std::uint32_t));
+      const char * text = record + RecordHeaderSize;
+      return Post(id, std::string(text, authorLength), std::string(text + authorLength, contentLength),
+        static_cast < std::time_t > (timestamp));
+    }
 
-                  for (const auto & game: games) {
+    static void indexRecords(Segment & segment) {
+      segment.offsets.clear();
+      segment.offsets.reserve(segment.count);
+      size_t at = 0;
+      while (at + RecordHeaderSize <= segment.bytes.size()) {
+        segment.offsets.push_back(static_cast < std::uint32_t > (at));
+        const char * record = segment.bytes.data() + at;
+        at += RecordHeaderSize + readU32(record + sizeof(std::int64_t)) +
+          readU32(record + sizeof(std::int64_t) + sizeof(std::uint32_t));
+      }
+      if (segment.offsets.size() != segment.count || at != segment.bytes.size()) {
+        throw std::runtime_error("Feed spill file is corrupt");
+      }
+    }
 
-                    if (game -> getTitle() == gameTitle) {
+    void appendRecord(std::string_view author, std::string_view content, std::time_t timestamp, bool tombstone) {
+      if (segments.empty() || segments.back().count == SegmentCapacity) {
+        if (!segments.empty()) {
+          segments.back().lastUse = ++useClock;
+          residentSealed.push_back(segments.size() - 1);
+          evictColdSegments();
+        }
+        segments.emplace_back();
+        segments.back().removed.reserve(SegmentCapacity);
+      }
+      Segment & tail = segments.back();
+      tail.offsets.push_back(static_cast < std::uint32_t > (tail.bytes.size()));
+      std::int64_t stamp = static_cast < std::int64_t > (timestamp);
+      std::uint32_t lengths[2] = {
+        static_cast < std::uint32_t > (author.size()), static_cast < std::uint32_t > (content.size())
+      };
+      tail.bytes.append(reinterpret_cast < const char * > ( & stamp), sizeof(stamp));
+      tail.bytes.append(reinterpret_cast < const char * > (lengths), sizeof(lengths));
+      tail.bytes.append(author.data(), author.size());
+      tail.bytes.append(content.data(), content.size());
+      tail.removed.push_back(tombstone ? 1 : 0);
+      tail.count++;
+      nextPostId++;
+    }
 
-                      selectedGame = game;
+    void readSpilled(const Segment & segment, std::string & bytes) const {
+      bytes.resize(static_cast < size_t > (segment.spillLength));
+      for (size_t done = 0; done < bytes.size();) {
+        ssize_t n = ::pread(spillFd, & bytes[done], bytes.size() - done, static_cast < off_t > (segment.spillOffset + done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) throw std::runtime_error("Cannot read feed spill file");
+        done += static_cast < size_t > (n);
+      }
+    }
 
-                      break;
+    // Brings a segment into memory and marks it used
+    const Segment & touch(size_t index) const {
+      Segment & segment = segments[index];
+      segment.lastUse = ++useClock;
+      if (segment.resident) return segment;
+      try {
+        readSpilled(segment, segment.bytes);
+        indexRecords(segment);
+      } catch (...) {
+        std::string().swap(segment.bytes);
+        throw;
+      }
+      segment.resident = true;
+      residentSealed.push_back(index);
+      evictColdSegments();
+      return segment;
+    }
 
-                    }
+    void evict(size_t index) const {
+      Segment & segment = segments[index];
+      if (!segment.spilled) {
+        size_t done = 0;
+        while (done < segment.bytes.size()) {
+          ssize_t n = ::pwrite(spillFd, segment.bytes.data() + done, segment.bytes.size() - done,
+            static_cast < off_t > (spillEnd + done));
+          if (n < 0 && errno == EINTR) continue;
+          if (n <= 0) throw std::runtime_error("Cannot write feed spill file");
+          done += static_cast < size_t > (n);
+        }
+        segment.spillOffset = spillEnd;
+        segment.spillLength = segment.bytes.size();
+        spillEnd += segment.bytes.size();
+        segment.spilled = true;
+      }
+      std::string().swap(segment.bytes);
+      std::vector < std::uint32_t > ().swap(segment.offsets);
+      segment.resident = false;
+    }
 
-                  }
-
-                  if (selectedGame) {
-
-                    currentUser -> addToWishlist(selectedGame);
-
-                    std::cout << selectedGame -> getTitle() << " added to wishlist.\n";
-
-                  } else {
-
-                    std::cout << "Game not found!\n";
-
-                  }
-
-                } else if (input == "2") { //View Game
-                        std::string gameTitle;
-                        std::cout << "Enter the title of the game to view: ";
-                        std::cin.ignore(); // Ignore the newline character in buffer
-                        std::getline(std::cin, gameTitle);
-
-                        Game* selectedGame = nullptr;
-                        // Find the game in the user's wishlist
-                        for (const auto& wishlistGame : currentUser->getWishlist()) {
-                            if (wishlistGame->getTitle() == gameTitle) {
-                                selectedGame = wishlistGame;
-                                break;
-                            }
-                        }
-
-                        if (selectedGame) {
-                            while (true) {
-                                //GAME DETAILS
-                                std::cout << "\nGame Details:\n";
-                                std::cout << "Title: " << selectedGame -> getTitle() << std::endl;
-                                std::cout << "Genre: " << selectedGame -> getGenre() << std::endl;
-                                std::cout << "Description: " << selectedGame -> getDescription() << std::endl;
-                                std::cout << "Price: $" << selectedGame -> getPrice() << std::endl;
-
-                                std::string ratingString;
-                                switch(selectedGame->getRating()) {
-                                    case GameRating::E: ratingString = "Everyone"; break;
-                                    case GameRating::E10: ratingString = "Everyone 10+"; break;
-                                    case GameRating::T: ratingString = "Teen"; break;
-                                    case GameRating::M: ratingString = "Mature"; break;
-                                    case GameRating::AO: ratingString = "Adults Only"; break;
-                                    default: ratingString = "Unknown"; break;
-                                }
-                                std::cout << "Maturity Rating: " << ratingString << std::endl;
-
-                                std::cout << "Release Date: " << selectedGame -> getReleaseDate() << std::endl;
-                                //End of details
-
-                                std::cout << "\nOptions:\n";
-                                std::cout << "1. Buy Game\n";
-                                std::cout << "2. Remove from Wishlist\n";
-                                std::cout << "3. back\n";
-                                std::cout << "Enter your choice: ";
-
-                                std::cin >> input;
-
-                                if (input == "1") { // Buy Game
-                                    bool gameInLibrary = false;
-                                    for (const auto& libraryGame : currentUser->getLibrary()) {
-                                        if (libraryGame->getTitle() == selectedGame->getTitle()) {
-                                            gameInLibrary = true;
-                                            break;
-                                        }
-                                    }
-
-                                    if (!gameInLibrary) {
-                                        currentUser->addToLibrary(selectedGame);
-                                        std::cout << "Game '" << selectedGame->getTitle() << "' purchased and added to your library.\n";
-                                        
-                                        // Remove from wishlist after purchase
-                                        auto& wishlist = currentUser->getWishlist();
-                                        auto it = std::find(wishlist.begin(), wishlist.end(), selectedGame);
-                                        if (it != wishlist.end()) {
-                                            wishlist.erase(it);
-                                        }
-                                    } else {
-                                        std::cout << "You already own this game in your library.\n";
-                                    }
-                                } else if (input == "2") { // Remove from Wishlist
-                                    auto& wishlist = currentUser->getWishlist();
-                                    auto it = std::find(wishlist.begin(), wishlist.end(), selectedGame);
-                                    if (it != wishlist.end()) {
-                                        wishlist.erase(it);
-                                        std::cout << "Game '" << selectedGame->getTitle() << "' removed from your wishlist.\n";
-                                        break; // Exit the game details menu
-                                    }
-                                } else if (input == "3") { // Back
-                                    break;
-                                } else {
-                                    std::cout << "Invalid choice!\n";
-                                }
-                            }
-                        } else {
-                            std::cout << "Game not found in your wishlist!\n";
-                        }
-                
-                } else if (input == "3") {
-
-                  break; // Go back to Library
-
-                } else {
-
-                  std::cout << "Invalid choice!\n";
+    // Evicts the least recently used sealed segments beyond the budget
+    void evictColdSegments() const {
+      if (spillFd < 0) return;
+      while (residentSealed.size() > maxResident) {
+        auto coldest = std::min_element(residentSealed.begin(), residentSealed.end(), [ & ](size_t a, size_t b) {
+          return segments[a].lastUse < segments[b].lastUse;
+        });
+        evict( * coldest);
+        * coldest = residentSealed.back();
+        residentSealed.pop_back();
+      }
+    }
 
-                }
-              }
+    // Decodes the live posts among ids, newest (last) first, until limit are found
+    template < typename Ids >
+    Page collect(const Ids & ids, size_t limit) const {
+      Page page;
+      if (limit == 0) return page;
+      page.posts.reserve(std::min(limit, ids.size()));
+      for (size_t i = ids.size(); i > 0; --i) {
+        std::uint64_t id = ids[i - 1];
+        if (page.posts.size() == limit) {
+          page.nextBefore = page.posts.back().postId;
+          break;
+        }
+        size_t position = static_cast < size_t > (id - 1);
+        const Segment & segment = touch(position / SegmentCapacity);
+        std::uint32_t index = static_cast < std::uint32_t > (position % SegmentCapacity);
+        if (!segment.removed[index]) page.posts.push_back(decode(id, segment, index));
+      }
+      return page;
+    }
 
+  public:
+    CommunityFeed() = default;
+    CommunityFeed(const CommunityFeed & ) = delete;
+    CommunityFeed & operator = (const CommunityFeed & ) = delete;
 
-            } else if (input == "3") { //navbar
+    ~CommunityFeed() {
+      if (spillFd >= 0) ::close(spillFd);
+    }
 
-              break; // Go back to navbar
+    // Lets cold segments go to disk. The file is unlinked as soon as it is
+    // created: it is only a cache, the snapshot and log keep the posts.
+    void spillTo(const std::string & path, size_t residentSegments = DefaultResidentSegments) {
+      std::lock_guard < std::mutex > lock(mutex);
+      if (spillFd >= 0) return;
+      spillFd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+      if (spillFd < 0) {
+        throw std::runtime_error("Cannot create feed spill file " + path);
+      }
+      ::unlink(path.c_str());
+      maxResident = std::max < size_t > (1, residentSegments);
+      evictColdSegments();
+    }
 
-            } else { //inval choice
+    // Timestamps are expected not to go backwards; callers clamp with newestTimestamp()
+    std::uint64_t append(std::string_view author, std::string_view content, std::time_t timestamp) {
+      std::lock_guard < std::mutex > lock(mutex);
+      std::uint64_t id = nextPostId;
+      appendRecord(author, content, timestamp, false);
+      timelines[std::string(author)].push_back(id);
+      newest = std::max(newest, timestamp);
+      livePosts++;
+      return id;
+    }
 
-              std::cout << "Invalid choice!\n";
+    // Re-adds a post with a known id, as when loading a snapshot or replaying
+    // the log. Ids skipped over become tombstones.
+    void restore(std::uint64_t id, std::string_view author, std::string_view content, std::time_t timestamp) {
+      {
+        std::lock_guard < std::mutex > lock(mutex);
+        if (id < nextPostId) throw std::runtime_error("Post ids must increase");
+        while (nextPostId < id) appendRecord("", "", 0, true);
+      }
+      append(author, content, timestamp);
+    }
 
-            }
+    // Moves the next id past ids that were handed out and then removed
+    void reserveThrough(std::uint64_t nextId) {
+      std::lock_guard < std::mutex > lock(mutex);
+      while (nextPostId < nextId) appendRecord("", "", 0, true);
+    }
 
-          }
+    bool remove(std::uint64_t id) {
+      std::lock_guard < std::mutex > lock(mutex);
+      if (id == 0 || id >= nextPostId) return false;
+      size_t position = static_cast < size_t > (id - 1);
+      Segment & segment = segments[position / SegmentCapacity];
+      std::uint32_t index = static_cast < std::uint32_t > (position % SegmentCapacity);
+      if (segment.removed[index]) return false;
+      Post post = decode(id, touch(position / SegmentCapacity), index);
+      segment.removed[index] = 1;
+      livePosts--;
+      std::vector < std::uint64_t > & timeline = timelines[post.userId];
+      timeline.erase(std::lower_bound(timeline.begin(), timeline.end(), id));
+      if (timeline.empty()) timelines.erase(post.userId);
+      return true;
+    }
 
-        } else {
+    // Copies a live post into out; false when the id is unknown or removed
+    bool find(std::uint64_t id, Post & out) const {
+      std::lock_guard < std::mutex > lock(mutex);
+      if (id == 0 || id >= nextPostId) return false;
+      size_t position = static_cast < size_t > (id - 1);
+      const Segment & segment = touch(position / SegmentCapacity);
+      std::uint32_t index = static_cast < std::uint32_t > (position % SegmentCapacity);
+      if (segment.removed[index]) return false;
+      out = decode(id, segment, index);
+      return true;
+    }
 
-          std::cout << "You need to log in to view your library.\n";
-
-        }
-
-      } else if (input == "5") { // Login/Logout
-
-        if (loggedIn) {
-          currentUser = nullptr;
-          currentAdmin = nullptr;
-          loggedIn = false;
-          std::cout << "Logged out successfully.\n";
-        } 
-
-        else {
-          std::cout << "\nLogin:\n";
-          std::cout << "1. Customer\n";
-          std::cout << "2. Developer\n";
-          std::cout << "3. Manager\n";
-          std::cout << "4. Administrator\n"; 
-          std::cout << "Enter your role: ";
-          std::cin >> input;
-
-          UserRole role;
-          if (input == "1") {
-            role = UserRole::CUSTOMER;
-          } else if (input == "2") {
-            role = UserRole::DEVELOPER;
-          } else if (input == "3") {
-            role = UserRole::MANAGER;
-          } else if (input == "4") {
-            role = UserRole::ADMINISTRATOR; // Use ADMINISTRATOR role
-          } else {
-            std::cout << "Invalid role!\n";
-            continue;
-          }
+    // Up to limit posts older than before (0 = from the newest), newest first.
+    // Costs the page size plus any tombstones skipped on the way.
+    Page latest(size_t limit, std::uint64_t before = 0) const {
+      std::lock_guard < std::mutex > lock(mutex);
+      std::uint64_t end = before == 0 || before > nextPostId ? nextPostId : before;
+      // A view of the ids 1 .. end - 1 without materialising them
+      struct IdRange {
+        std::uint64_t end;
+        size_t size() const {
+          return static_cast < size_t > (end - 1);
+        }
+        std::uint64_t operator[](size_t i) const {
+          return i + 1;
+        }
+      };
+      return collect(IdRange {end}, limit);
+    }
 
-          // ... (display user data for testing - adjust indices if needed)
-                    // Display the 1st default user data for testing
-          std::cout << "\nFor testing, use:\n";
-          if (role == UserRole::CUSTOMER) {
-            std::cout << "Username: " << users[0]->getUsername() << std::endl; 
-          } else if (role == UserRole::DEVELOPER) {
-            std::cout << "Username: " << users[2]->getUsername() << std::endl; 
-          } else if (role == UserRole::MANAGER) {
-            std::cout << "Username: " << users[4]->getUsername() << std::endl; 
-          } else if (role == UserRole::ADMINISTRATOR) {
-            std::cout << "Username: " << administrators[0]->getAdminUsername() << std::endl;
-          }
-          std::cout << "Password: password\n\n"; 
-
-          std::string username, password;
-          std::cout << "Enter username: ";
-          std::cin >> username;
-          std::cout << "Enter password: ";
-          std::cin >> password;
-
-          if (role == UserRole::ADMINISTRATOR) {
-            // Administrator login
-            for (const auto & admin : administrators) {
-              if (admin->getAdminUsername() == username && password == "password") { 
-                loggedIn = true;
-                std::cout << "Login successful!\n";
-                runAdminUI(admin); // Call the admin UI function
-              }
-            }
-          } else {
-            // Customer, Developer, Manager login
-            for (const auto & user : users) {
-              if (user->getUsername() == username && user->getRole() == role && user->login(password)) {
-                currentUser = user;
-                loggedIn = true;
-                std::cout << "Login successful!\n";
-
-                // Redirect to the appropriate UI based on role
-                if (role == UserRole::DEVELOPER) {
-                  runDeveloperUI(currentUser);
-                } else if (role == UserRole::MANAGER) {
-                  runManagerUI(currentUser); 
-                } 
-                break;
-              }
-            }
-          }
+    // The same for one author's posts, found by binary search on their timeline
+    Page latestBy(std::string_view author, size_t limit, std::uint64_t before = 0) const {
+      std::lock_guard < std::mutex > lock(mutex);
+      auto found = timelines.find(std::string(author));
+      if (found == timelines.end()) return Page();
+      const std::vector < std::uint64_t > & ids = found -> second;
+      size_t end = before == 0 ? ids.size() :
+        static_cast < size_t > (std::lower_bound(ids.begin(), ids.end(), before) - ids.begin());
+      struct Prefix {
+        const std::vector < std::uint64_t > & ids;
+        size_t end;
+        size_t size() const {
+          return end;
+        }
+        std::uint64_t operator[](size_t i) const {
+          return ids[i];
+        }
+      };
+      return collect(Prefix {ids, end}, limit);
+    }
 
-          if (!loggedIn) {
-            std::cout << "Invalid username or password.\n";
-          }
+    // Calls fn on every live post, oldest first, without disturbing which
+    // segments stay in memory
+    template < typename Fn >
+    void forEach(Fn && fn) const {
+      std::lock_guard < std::mutex > lock(mutex);
+      Segment scratch;
+      for (size_t s = 0; s < segments.size(); ++s) {
+        const Segment * segment = & segments[s];
+        if (!segment -> resident) {
+          scratch.count = segment -> count;
+          readSpilled( * segment, scratch.bytes);
+          indexRecords(scratch);
+          scratch.removed = segment -> removed;
+          segment = & scratch;
+        }
+        for (std::uint32_t i = 0; i < segment -> count; ++i) {
+          if (!segment -> removed[i]) fn(decode(s * SegmentCapacity + i + 1, * segment, i));
         }
+      }
+    }
 
-      } else if (input == "0") { // Exit
+    std::uint64_t nextId() const {
+      std::lock_guard < std::mutex > lock(mutex);
+      return nextPostId;
+    }
 
-        std::cout << "Exiting...\n";
+    std::time_t newestTimestamp() const {
+      std::lock_guard < std::mutex > lock(mutex);
+      return newest;
+    }
 
-        break;
+    Stats stats() const {
+      std::lock_guard < std::mutex > lock(mutex);
+      Stats stats {livePosts, segments.size(), 0, 0, spillEnd};
+      for (const Segment & segment: segments) {
+        if (!segment.resident) continue;
+        stats.residentSegments++;
+        stats.residentBytes += segment.bytes.capacity() + segment.offsets.capacity() * sizeof(std::uint32_t);
+      }
+      return stats;
+    }
+};
 
-      } else {
+// ---------------------------------------------------------------------------
+// Sales ledger
+//
+// Every purchase is appended as one row and never changed afterwards. Rows
+// are stored column by column in chunks of ChunkRows, so the ledger grows
+// without copying the rows it already has:
+//   buyer | game slot | game generation | developer | price paid | discount | timestamp
+// Buyers and developers are interned to dense keys. Totals per game, per
+// developer and per UTC day are updated as each row is appended, so a report
+// reads one counter per game or developer instead of scanning the rows.
+// ---------------------------------------------------------------------------
+
+class SalesLedger {
+  public:
+    static constexpr size_t ChunkRows = 1 << 16;
+    static constexpr std::time_t SecondsPerDay = 86400;
+
+    struct Sale {
+      std::uint32_t priceCents; // what the buyer paid
+      std::uint16_t discountBasisPoints; // off the list price, 10000 = free
+      std::time_t timestamp;
+    };
+
+    struct Row {
+      std::uint32_t buyer;
+      GameHandle game; // empty once the game was removed before a snapshot
+      std::uint32_t developer;
+      Sale sale;
+    };
+
+    struct Totals {
+      std::uint64_t units = 0;
+      std::uint64_t revenueCents = 0;
+    };
+
+    struct Stats {
+      size_t rows;
+      size_t chunks;
+      size_t bytes;
+    };
 
-        std::cout << "Invalid choice!\n";
+  private:
+    struct Chunk {
+      std::array < std::uint32_t, ChunkRows > buyers;
+      std::array < std::uint32_t, ChunkRows > games;
+      std::array < std::uint32_t, ChunkRows > generations;
+      std::array < std::uint32_t, ChunkRows > developers;
+      std::array < std::uint32_t, ChunkRows > prices;
+      std::array < std::uint16_t, ChunkRows > discounts;
+      std::array < std::int64_t, ChunkRows > timestamps;
+    };
+
+    // Names to dense keys; names view the map's own keys
+    struct Dictionary {
+      std::unordered_map < std::string, std::uint32_t > keys;
+      std::vector < std::string_view > names;
+
+      std::uint32_t intern(std::string_view name) {
+        auto found = keys.emplace(std::string(name), static_cast < std::uint32_t > (names.size()));
+        if (found.second) names.push_back(found.first -> first);
+        return found.first -> second;
       }
 
+      const std::uint32_t * find(std::string_view name) const {
+        auto found = keys.find(std::string(name));
+        return found == keys.end() ? nullptr : & found -> second;
+      }
+    };
+
+    mutable std::mutex mutex;
+    std::vector < std::unique_ptr < Chunk >> chunks;
+    size_t rowCount = 0;
+    Dictionary buyers;
+    Dictionary developers;
+    std::vector < std::pair < std::uint32_t, Totals >> gameTotals; // by catalog slot: generation, totals
+    std::vector < Totals > developerTotals; // by developer key
+    std::map < std::int64_t, Totals > dayTotals; // by days since the epoch
+
+    static void add(Totals & totals, const Sale & sale) {
+      totals.units++;
+      totals.revenueCents += sale.priceCents;
     }
-  }
-
-  void runDeveloperUI(User * currentUser) 
-  {
-    std::string input;
 
-    while (true) {
-        std::cout << "\nDeveloper UI\n";
-        std::cout << "1. Change Game Price\n";
-        std::cout << "2. View Sales History\n";
-        std::cout << "3. List My Games\n"; // Added option to list games
-        std::cout << "4. Logout\n"; // Shifted logout option to 4
-        std::cout << "Enter your choice: ";
-        std::cin >> input;
+    static std::int64_t dayOf(std::time_t timestamp) {
+      std::int64_t seconds = static_cast < std::int64_t > (timestamp);
+      return seconds / SecondsPerDay - (seconds % SecondsPerDay < 0 ? 1 : 0);
+    }
 
-      if (input == "1") {
-        std::string gameTitle;
-        double newPrice;
-        std::cout << "Enter the title of the game to change price: ";
-        std::cin.ignore();
-        std::getline(std::cin, gameTitle);
-
-        Game* selectedGame = nullptr;
-        for (const auto& game : games) {
-          if (game->getTitle() == gameTitle && game->getDeveloperName() == currentUser->getUsername()) {
-            selectedGame = game;
-            break;
-          }
-        }
+    void append(const Row & row) {
+      if (rowCount == chunks.size() * ChunkRows) {
+        chunks.emplace_back(new Chunk); // left uninitialized, rows are written before they are read
+      }
+      Chunk & chunk = * chunks.back();
+      size_t at = rowCount % ChunkRows;
+      chunk.buyers[at] = row.buyer;
+      chunk.games[at] = row.game.slot;
+      chunk.generations[at] = row.game.generation;
+      chunk.developers[at] = row.developer;
+      chunk.prices[at] = row.sale.priceCents;
+      chunk.discounts[at] = row.sale.discountBasisPoints;
+      chunk.timestamps[at] = static_cast < std::int64_t > (row.sale.timestamp);
+      rowCount++;
+
+      if (!row.game.empty()) {
+        if (gameTotals.size() <= row.game.slot) gameTotals.resize(row.game.slot + 1);
+        auto & totals = gameTotals[row.game.slot];
+        // A reused slot starts over; rows arrive in time order, so after its old game's
+        if (totals.first != row.game.generation) totals = {row.game.generation, Totals()};
+        add(totals.second, row.sale);
+      }
+      if (developerTotals.size() <= row.developer) developerTotals.resize(row.developer + 1);
+      add(developerTotals[row.developer], row.sale);
+      add(dayTotals[dayOf(row.sale.timestamp)], row.sale);
+    }
 
-        if (selectedGame) {
-          std::cout << "Enter the new price: $";
-          std::cin >> newPrice;
-          selectedGame->updatePrice(newPrice);
-          std::cout << "Price updated successfully!\n";
-        } else {
-          std::cout << "Game not found or you don't have permission to change its price.\n";
-        }
+  public:
+    SalesLedger() = default;
+    SalesLedger(const SalesLedger & ) = delete;
+    SalesLedger & operator = (const SalesLedger & ) = delete;
 
-      } else if (input == "2") {
-        std::cout << "\nSales History:\n";
-        // Make up default sales history values
-        for (const auto& game : games) {
-          if (game->getDeveloperName() == currentUser->getUsername()) {
-            int salesCount = rand() % 100 + 1; // Generate random sales count (1-100)
-            std::cout << game->getTitle() << ": " << salesCount << " sales\n";
-          }
-		 }
+    void record(std::string_view buyer, GameHandle game, std::string_view developer, const Sale & sale) {
+      std::lock_guard < std::mutex > lock(mutex);
+      append({buyers.intern(buyer), game, developers.intern(developer), sale});
+    }
 
-      } else if (input == "3") {
-        std::cout << "\nYour Games:\n";
-        for (const auto& game : games) {
-          if (game->getDeveloperName() == currentUser->getUsername()) {
-            std::cout << "- " << game->getTitle() << std::endl;
-             }
-        }
-      }else if (input == "4") {
-        std::cout << "Logging out...\n";
-        break; 
-      } else {
-        std::cout << "Invalid choice!\n";
+    // Appends a row whose keys came from buyerKey/developerKey
+    void record(const Row & row) {
+      std::lock_guard < std::mutex > lock(mutex);
+      if (row.buyer >= buyers.names.size() || row.developer >= developers.names.size()) {
+        throw std::out_of_range("Sale refers to an unknown buyer or developer");
       }
+      append(row);
     }
-  }
 
-  void runManagerUI(User * currentUser) 
-  {
-    std::string input;
+    // record(Row) for a batch under one lock. Nothing is added if any row
+    // refers to an unknown key.
+    void record(const std::vector < Row > & rows) {
+      std::lock_guard < std::mutex > lock(mutex);
+      for (const Row & row: rows) {
+        if (row.buyer >= buyers.names.size() || row.developer >= developers.names.size()) {
+          throw std::out_of_range("Sale refers to an unknown buyer or developer");
+        }
+      }
+      for (const Row & row: rows) append(row);
+    }
 
-    while (true) {
-      std::cout << "\nManager UI\n";
-      std::cout << "1. Set Weekly Sale\n";
-      std::cout << "2. View Developer Sales History\n"; // Placeholder for dev sales
-      std::cout << "3. Logout\n";
-      std::cout << "Enter your choice: ";
-      std::cin >> input;
+    std::uint32_t buyerKey(std::string_view buyer) {
+      std::lock_guard < std::mutex > lock(mutex);
+      return buyers.intern(buyer);
+    }
 
-    if (input == "1") {
-        std::string gameTitle;
-        double discountPercentage;
-        std::cout << "Enter the name of the game to put on sale: ";
-        std::cin.ignore();
-        std::getline(std::cin, gameTitle);
+    std::uint32_t developerKey(std::string_view developer) {
+      std::lock_guard < std::mutex > lock(mutex);
+      return developers.intern(developer);
+    }
 
-        Game* selectedGame = nullptr;
-        for (const auto& game : games) 
-        {
-            if (game->getTitle() == gameTitle) 
-            {
-                selectedGame = game;
-                break;
-            }
-        }
+    Totals game(GameHandle game) const {
+      std::lock_guard < std::mutex > lock(mutex);
+      if (game.slot >= gameTotals.size() || gameTotals[game.slot].first != game.generation) return Totals();
+      return gameTotals[game.slot].second;
+    }
 
-        if (selectedGame) 
-        {
-            std::cout << "Enter the discount percentage: ";
-            std::cin >> discountPercentage;
-            for (const auto& admin : administrators) 
-            {
-                admin->setWeeklySale(selectedGame->getGameId(), discountPercentage); 
-            }
-            std::cout << "Weekly sale set successfully!\n";
-        } 
-        else 
-        {
-            std::cout << "Game not found.\n";
-        }
+    Totals developer(std::string_view name) const {
+      std::lock_guard < std::mutex > lock(mutex);
+      const std::uint32_t * key = developers.find(name);
+      return key ? developerTotals[ * key] : Totals();
+    }
 
-      } else if (input == "2") 
-      {
-        std::cout << "\nDeveloper Sales History:\n";
-        for (const auto& user : users) 
-        {
-          if (user->getRole() == UserRole::DEVELOPER) 
-          {
-            int totalSales = 0;
-            for (const auto& game : games) 
-            {
-              if (game->getDeveloperName() == user->getUsername()) 
-              {
-                int salesCount = rand() % 100 + 1; // Generate random sales count
-                totalSales += salesCount;
-              }
-            }
-            std::cout << user->getUsername() << ": " << totalSales << " sales\n";
-          }
-        }
+    // Every developer with at least one sale, by name, read off the running
+    // totals: the cost follows the number of developers, not of rows
+    std::vector < std::pair < std::string, Totals >> developersWithSales() const {
+      std::lock_guard < std::mutex > lock(mutex);
+      std::vector < std::pair < std::string, Totals >> result;
+      for (size_t key = 0; key < developerTotals.size(); ++key) {
+        if (developerTotals[key].units > 0) result.emplace_back(std::string(developers.names[key]), developerTotals[key]);
+      }
+      std::sort(result.begin(), result.end(), [](const auto & a, const auto & b) {
+        return a.first < b.first;
+      });
+      return result;
+    }
 
-      } else if (input == "3") {
-        std::cout << "Logging out...\n";
-        break;
-      } else {
-        std::cout << "Invalid choice!\n";
+    // Days from the one containing from through the one containing to that
+    // had sales, oldest first, each keyed by the time it starts (UTC)
+    std::vector < std::pair < std::time_t, Totals >> days(std::time_t from, std::time_t to) const {
+      std::lock_guard < std::mutex > lock(mutex);
+      std::vector < std::pair < std::time_t, Totals >> result;
+      for (auto it = dayTotals.lower_bound(dayOf(from)); it != dayTotals.end() && it -> first <= dayOf(to); ++it) {
+        result.emplace_back(static_cast < std::time_t > (it -> first * SecondsPerDay), it -> second);
       }
+      return result;
     }
-  }
 
-    void runAdminUI(Administrator * currentAdmin)
-    {
-        //leave blank no functional requirements
-        std::string input;
-        while (true) 
-        {
-        std::cout << "\nAdministrator UI\n";
-        std::cout << "Nothing to see here!\n";
-        std::cout << "1. Logout\n";
-        std::cout << "Enter your choice: ";
-        std::cin >> input;
+    // Calls fn(row) for every row in the order they were recorded. Appends
+    // must not run concurrently.
+    template < typename Fn >
+    void forEach(Fn && fn) const {
+      for (size_t i = 0; i < rowCount; ++i) {
+        const Chunk & chunk = * chunks[i / ChunkRows];
+        size_t at = i % ChunkRows;
+        fn(Row {
+          chunk.buyers[at], {chunk.games[at], chunk.generations[at]}, chunk.developers[at], {
+            chunk.prices[at], chunk.discounts[at], static_cast < std::time_t > (chunk.timestamps[at])
+          }
+        });
+      }
+    }
 
-        if (input == "1") 
-        {
-            std::cout << "Logging out...\n";
-            break; // Exit the admin UI loop
-        } else 
-        {
-            std::cout << "Invalid choice!\n";
-        }
-        }
+    // Names by key, valid until the next append. For snapshots.
+    const std::vector < std::string_view > & buyerNames() const {
+      return buyers.names;
+    }
+    const std::vector < std::string_view > & developerNames() const {
+      return developers.names;
     }
 
+    size_t size() const {
+      std::lock_guard < std::mutex > lock(mutex);
+      return rowCount;
+    }
 
+    Stats stats() const {
+      std::lock_guard < std::mutex > lock(mutex);
+      return {
+        rowCount, chunks.size(), chunks.size() * sizeof(Chunk)
+      };
+    }
+};
 
+// ---------------------------------------------------------------------------
+// Write-ahead log
+//
+// Every mutation that has to survive a restart is appended to the log as a
+// framed record: [u32 body length][u64 checksum of body][body], where the body
+// is [u64 sequence][u8 MutationType][payload]. A background thread writes the
+// pending records and fsyncs them as one batch (group commit), so concurrent
+// writers share a single fsync instead of paying for one each. Startup loads
+// the latest snapshot and replays the records written after it.
+// ---------------------------------------------------------------------------
+
+enum class MutationType : std::uint8_t {
+  REGISTER_USER = 1,
+  PURCHASE,
+  LIBRARY_REMOVE,
+  WISHLIST_ADD,
+  WISHLIST_REMOVE,
+  REVIEW,
+  PRICE_UPDATE,
+  SALE_RULE,
+  POST,
+  POST_REMOVE
 };
 
-int main() {
+// Builds a record payload; read back with SnapshotReader
+class LogEncoder {
+  private:
+    std::string bytes;
 
-  // Example usage
+  public:
+    template < typename T >
+    void put(T value) {
+      bytes.append(reinterpret_cast < const char * > ( & value), sizeof(value));
+    }
+
+    void putString(std::string_view text) {
+      put < std::uint32_t > (static_cast < std::uint32_t > (text.size()));
+      bytes.append(text.data(), text.size());
+    }
+
+    const std::string & payload() const {
+      return bytes;
+    }
+};
+
+class WriteAheadLog {
+  public:
+    struct Record {
+      std::uint64_t sequence;
+      MutationType type;
+      std::string payload;
+    };
+
+  private:
+    static constexpr size_t FrameHeaderSize = sizeof(std::uint32_t) + sizeof(std::uint64_t);
+
+    int fd = -1;
+    std::string path;
+    std::mutex mutex;
+    std::condition_variable pendingReady;
+    std::condition_variable durableAdvanced;
+    std::string pending; // encoded records not yet handed to the kernel
+    std::uint64_t nextSequence = 1;
+    std::uint64_t appendedSequence = 0;
+    std::uint64_t durableSequence = 0;
+    std::uint64_t logBytes = 0;
+    bool stopping = false;
+    bool failed = false; // a write or sync failed; nothing is logged after it
+    std::thread flusher;
+
+    void flushLoop() {
+      std::unique_lock < std::mutex > lock(mutex);
+      while (true) {
+        pendingReady.wait(lock, [this] {
+          return stopping || !pending.empty();
+        });
+        if (pending.empty()) break; // stopping with nothing left to write
+
+        // Everything appended so far goes out in one write and one fsync;
+        // records appended meanwhile wait for the next round
+        std::string batch;
+        batch.swap(pending);
+        std::uint64_t batchSequence = appendedSequence;
+        lock.unlock();
+
+        bool ok = true;
+        for (size_t written = 0; written < batch.size();) {
+          ssize_t n = ::write(fd, batch.data() + written, batch.size() - written);
+          if (n < 0 && errno == EINTR) continue;
+          if (n < 0) {
+            ok = false;
+            break;
+          }
+          written += static_cast < size_t > (n);
+        }
+        ok = ok && ::fdatasync(fd) == 0;
+
+        lock.lock();
+        if (!ok) {
+          // Records written after a torn frame would be unreachable, since
+          // recover() stops at it. Cut the frame off if possible and stop
+          // logging: every waiter and every later append fails.
+          if (::ftruncate(fd, static_cast < off_t > (logBytes)) != 0) {
+            std::cerr << "Cannot cut " << path << " back after a failed write" << std::endl;
+          }
+          failed = true;
+          pending.clear();
+          durableAdvanced.notify_all();
+          break;
+        }
+        durableSequence = batchSequence;
+        logBytes += batch.size();
+        durableAdvanced.notify_all();
+      }
+    }
+
+  public:
+    explicit WriteAheadLog(const std::string & path): path(path) {
+      fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+      if (fd < 0) {
+        throw std::runtime_error("Cannot open " + path);
+      }
+    }
+
+    WriteAheadLog(const WriteAheadLog & ) = delete;
+    WriteAheadLog & operator = (const WriteAheadLog & ) = delete;
+
+    ~WriteAheadLog() {
+      if (flusher.joinable()) {
+        {
+          std::lock_guard < std::mutex > lock(mutex);
+          stopping = true;
+        }
+        pendingReady.notify_one();
+        flusher.join();
+      }
+      ::close(fd);
+    }
+
+    // Reads back every intact record. A torn or corrupt record (e.g. from a
+    // crash mid-write) ends the log: it and anything after it are cut off.
+    std::vector < Record > recover() {
+      std::vector < Record > records;
+      struct stat info;
+      if (::fstat(fd, & info) != 0) {
+        throw std::runtime_error("Cannot stat " + path);
+      }
+      std::string contents(static_cast < size_t > (info.st_size), '\0');
+      for (size_t read = 0; read < contents.size();) {
+        ssize_t n = ::pread(fd, & contents[read], contents.size() - read, static_cast < off_t > (read));
+        if (n <= 0) {
+          throw std::runtime_error("Cannot read " + path);
+        }
+        read += static_cast < size_t > (n);
+      }
+
+      size_t offset = 0;
+      const unsigned char * bytes = reinterpret_cast < const unsigned char * > (contents.data());
+      while (contents.size() - offset >= FrameHeaderSize) {
+        std::uint32_t bodyLength;
+        std::uint64_t checksum;
+        std::memcpy( & bodyLength, bytes + offset, sizeof(bodyLength));
+        std::memcpy( & checksum, bytes + offset + sizeof(bodyLength), sizeof(checksum));
+        const size_t bodyStart = offset + FrameHeaderSize;
+        if (bodyLength < sizeof(std::uint64_t) + 1 || contents.size() - bodyStart < bodyLength ||
+          checksum64(bytes + bodyStart, bodyLength, 0) != checksum) {
+          break;
+        }
+        Record record;
+        std::memcpy( & record.sequence, bytes + bodyStart, sizeof(record.sequence));
+        record.type = static_cast < MutationType > (bytes[bodyStart + sizeof(record.sequence)]);
+        record.payload.assign(contents, bodyStart + sizeof(record.sequence) + 1,
+          bodyLength - sizeof(record.sequence) - 1);
+        records.push_back(std::move(record));
+        offset = bodyStart + bodyLength;
+      }
+      if (offset != contents.size() && ::ftruncate(fd, static_cast < off_t > (offset)) != 0) {
+        throw std::runtime_error("Cannot truncate " + path);
+      }
+      logBytes = offset;
+      return records;
+    }
+
+    // Starts the group-commit thread; sequence numbers continue from firstSequence
+    void start(std::uint64_t firstSequence) {
+      nextSequence = firstSequence;
+      appendedSequence = durableSequence = firstSequence - 1;
+      flusher = std::thread( & WriteAheadLog::flushLoop, this);
+    }
+
+    // Queues a record and returns its sequence number without waiting for
+    // disk. Throws once a write has failed.
+    std::uint64_t append(MutationType type, const std::string & payload) {
+      std::uint64_t sequence;
+      {
+        std::lock_guard < std::mutex > lock(mutex);
+        if (failed) {
+          throw std::runtime_error("Write-ahead log write failed");
+        }
+        sequence = nextSequence++;
+        std::string body;
+        body.reserve(sizeof(sequence) + 1 + payload.size());
+        body.append(reinterpret_cast < const char * > ( & sequence), sizeof(sequence));
+        body.push_back(static_cast < char > (type));
+        body.append(payload);
+        std::uint32_t bodyLength = static_cast < std::uint32_t > (body.size());
+        std::uint64_t checksum = checksum64(reinterpret_cast < const unsigned char * > (body.data()), body.size(), 0);
+        pending.append(reinterpret_cast < const char * > ( & bodyLength), sizeof(bodyLength));
+        pending.append(reinterpret_cast < const char * > ( & checksum), sizeof(checksum));
+        pending.append(body);
+        appendedSequence = sequence;
+      }
+      pendingReady.notify_one();
+      return sequence;
+    }
+
+    // Blocks until the record with this sequence number is on disk
+    void waitDurable(std::uint64_t sequence) {
+      std::unique_lock < std::mutex > lock(mutex);
+      durableAdvanced.wait(lock, [ & ] {
+        return failed || durableSequence >= sequence;
+      });
+      if (durableSequence < sequence) {
+        throw std::runtime_error("Write-ahead log write failed");
+      }
+    }
+
+    std::uint64_t lastSequence() {
+      std::lock_guard < std::mutex > lock(mutex);
+      return appendedSequence;
+    }
+
+    std::uint64_t sizeOnDisk() {
+      std::lock_guard < std::mutex > lock(mutex);
+      return logBytes;
+    }
+
+    // Empties the log once a snapshot covers it. Callers must make sure every
+    // appended record is durable and no new ones arrive meanwhile.
+    void reset() {
+      std::lock_guard < std::mutex > lock(mutex);
+      if (::ftruncate(fd, 0) != 0 || ::fdatasync(fd) != 0) {
+        throw std::runtime_error("Cannot truncate " + path);
+      }
+      logBytes = 0;
+    }
+};
+
+// Result orders for ranked, paged searches
+enum class SearchOrder {
+  CATALOG, // insertion order
+  PRICE_LOW_TO_HIGH,
+  PRICE_HIGH_TO_LOW,
+  TOP_RATED, // highest average review rating first
+  NEWEST,
+  RELEVANCE // earliest title match first, then fewest typos, then shortest title; catalog order without a title
+};
+
+struct SearchPage {
+  std::vector < Game * > games;
+  std::string nextCursor; // empty on the last page
+};
+
+// Position of the last result on a page: its sort value and catalog slot,
+// which breaks ties so pages never overlap or skip. Serialized as opaque hex.
+struct SearchCursor {
+  SearchOrder order;
+  double value;
+  std::uint32_t slot;
+
+  std::string encode() const {
+    std::uint64_t bits;
+    std::memcpy( & bits, & value, sizeof(bits));
+    char text[28];
+    std::snprintf(text, sizeof(text), "%x%016llx%08x", static_cast < unsigned > (order),
+      static_cast < unsigned long long > (bits), static_cast < unsigned > (slot));
+    return text;
+  }
+
+  // Throws std::invalid_argument for a malformed cursor or one from another order
+  static SearchCursor decode(std::string_view text, SearchOrder expected) {
+    if (text.size() != 25 || text.find_first_not_of("0123456789abcdef") != std::string_view::npos ||
+      static_cast < SearchOrder > (text[0] - '0') != expected) {
+      throw std::invalid_argument("Invalid search cursor");
+    }
+    std::uint64_t bits = std::stoull(std::string(text.substr(1, 16)), nullptr, 16);
+    SearchCursor cursor {
+      expected, 0.0, static_cast < std::uint32_t > (std::stoul(std::string(text.substr(17)), nullptr, 16))
+    };
+    std::memcpy( & cursor.value, & bits, sizeof(bits));
+    return cursor;
+  }
+};
+
+// A fixed set of reader/writer locks; every entity maps to one of them by
+// key. Stripes are padded so neighbouring locks do not share a cache line.
+template < size_t Count >
+class LockStripes {
+  private:
+    struct alignas(64) Stripe {
+      std::shared_mutex mutex;
+    };
+    std::array < Stripe, Count > stripes;
+
+  public:
+    std::shared_mutex & at(size_t key) {
+      return stripes[key % Count].mutex;
+    }
+
+    // Always taken in index order, so two of these never deadlock
+    void lockAllShared() {
+      for (auto & stripe: stripes) stripe.mutex.lock_shared();
+    }
+    void unlockAllShared() {
+      for (auto & stripe: stripes) stripe.mutex.unlock_shared();
+    }
+};
+
+// Runs the deliberately slow password work on a few threads of its own
+// behind a bounded queue. A burst of logins then uses at most these threads,
+// never the ones serving searches and purchases, and once the queue is full
+// run fails fast with Busy instead of letting waiters pile up.
+class HashingPool {
+  public:
+    struct Busy: std::runtime_error {
+      Busy(): std::runtime_error("Too many logins in progress, try again shortly") {}
+    };
+
+  private:
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque < std::function < void() >> queue;
+    size_t capacity;
+    bool stopping = false;
+    std::vector < std::thread > threads;
+
+    void work() {
+      for (;;) {
+        std::function < void() > task;
+        {
+          std::unique_lock < std::mutex > lock(mutex);
+          wake.wait(lock, [ & ] {
+            return stopping || !queue.empty();
+          });
+          if (queue.empty()) return;
+          task = std::move(queue.front());
+          queue.pop_front();
+        }
+        task();
+      }
+    }
+
+  public:
+    HashingPool(unsigned threadCount, size_t capacity): capacity(capacity) {
+      for (unsigned t = 0; t < std::max(1u, threadCount); ++t) threads.emplace_back([this] {
+        work();
+      });
+    }
+    HashingPool(const HashingPool & ) = delete;
+    HashingPool & operator = (const HashingPool & ) = delete;
+
+    ~HashingPool() {
+      {
+        std::lock_guard < std::mutex > lock(mutex);
+        stopping = true;
+      }
+      wake.notify_all();
+      for (auto & thread: threads) thread.join();
+    }
+
+    // Runs fn on a pool thread and returns its result, or throws Busy when
+    // capacity tasks are already waiting
+    template < typename Fn >
+    auto run(Fn fn) -> decltype(fn()) {
+      std::packaged_task < decltype(fn())() > task(std::move(fn));
+      auto result = task.get_future();
+      {
+        std::lock_guard < std::mutex > lock(mutex);
+        if (queue.size() >= capacity) throw Busy();
+        queue.emplace_back([ & task] {
+          task();
+        });
+      }
+      wake.notify_one();
+      return result.get();
+    }
+
+    size_t threadCount() const {
+      return threads.size();
+    }
+};
+
+// Settings for GameMarketplace::populateSynthetic. The same config and seed
+// always build the same marketplace, whatever the thread count.
+struct SyntheticConfig {
+  std::uint64_t seed = 1;
+  size_t games = 100000;
+  size_t users = 1000000; // customers, on top of the developers and managers
+  size_t developers = 0; // 0 means one studio per 25 games
+  size_t managers = 10;
+  size_t administrators = 2;
+  size_t posts = 100000;
+  double popularitySkew = 1.0; // Zipf exponent for games, studios and posters
+  double meanLibrary = 12.0; // games per customer, Lomax distributed
+  double libraryTail = 1.5; // Lomax shape; lower means a heavier tail
+  size_t maxLibrary = 2000;
+  double wishlistRatio = 0.3; // wishlist entries per library entry
+  double reviewsPerGame = 8.0; // on average; popular games get most of them
+  bool recordSales = true; // one sales ledger row per library entry
+  std::time_t now = 1704067200; // end of the generated history (2024-01-01 UTC)
+  int historyDays = 3650; // releases, purchases and posts fall in this window
+  unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+};
+
+// splitmix64. The standard distributions are not specified bit for bit, so
+// generated data draws from this directly to stay the same on every library.
+// A stream is keyed by (seed, phase, block), so blocks of work can be handed
+// to any thread in any order and still draw the same numbers.
+class SeededRandom {
+  private:
+    std::uint64_t state;
+
+    static std::uint64_t mix(std::uint64_t z) {
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      return z ^ (z >> 31);
+    }
+
+  public:
+    explicit SeededRandom(std::uint64_t seed, std::uint64_t phase = 0, std::uint64_t block = 0)
+    : state(mix(mix(seed ^ mix(phase + 0x9e3779b97f4a7c15ULL)) + block)) {}
+
+    std::uint64_t next() {
+      state += 0x9e3779b97f4a7c15ULL;
+      return mix(state);
+    }
+
+    // In [0, 1)
+    double uniform() {
+      return static_cast < double > (next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    // In [0, count)
+    std::uint64_t below(std::uint64_t count) {
+      return static_cast < std::uint64_t > (uniform() * static_cast < double > (count));
+    }
+
+    bool chance(double probability) {
+      return uniform() < probability;
+    }
+
+    // Rounds up with probability equal to the fraction, so sums keep their mean
+    size_t roundStochastic(double value) {
+      double whole = std::floor(value);
+      return static_cast < size_t > (whole) + (chance(value - whole) ? 1 : 0);
+    }
+
+    // Index into weights with probability proportional to its weight
+    template < size_t N >
+    size_t weighted(const std::array < double, N > & weights) {
+      double total = 0;
+      for (double weight: weights) total += weight;
+      double pick = uniform() * total;
+      for (size_t i = 0; i + 1 < N; ++i) {
+        if (pick < weights[i]) return i;
+        pick -= weights[i];
+      }
+      return N - 1;
+    }
+};
+
+// Draws ranks 0..count-1 with P(rank) proportional to 1 / (rank + 1)^exponent
+// in O(1), by rejection-inversion (Hörmann and Derflinger), without a table.
+class ZipfSampler {
+  private:
+    double exponent;
+    size_t count;
+    double hIntegralX1;
+    double hIntegralCount;
+    double squeeze;
+
+    // log1p(x) / x and expm1(x) / x, accurate near 0
+    static double helper1(double x) {
+      return std::abs(x) > 1e-8 ? std::log1p(x) / x : 1 - x * (0.5 - x * (1.0 / 3 - 0.25 * x));
+    }
+    static double helper2(double x) {
+      return std::abs(x) > 1e-8 ? std::expm1(x) / x : 1 + x * 0.5 * (1 + x * (1.0 / 3) * (1 + 0.25 * x));
+    }
+
+    double h(double x) const {
+      return std::exp(-exponent * std::log(x));
+    }
+    double hIntegral(double x) const {
+      double logX = std::log(x);
+      return helper2((1 - exponent) * logX) * logX;
+    }
+    double hIntegralInverse(double x) const {
+      double t = std::max(-1.0, x * (1 - exponent));
+      return std::exp(helper1(t) * x);
+    }
+
+  public:
+    ZipfSampler(size_t count, double exponent): exponent(exponent), count(count) {
+      if (count == 0 || exponent <= 0) {
+        throw std::invalid_argument("Zipf needs at least one rank and a positive exponent");
+      }
+      hIntegralX1 = hIntegral(1.5) - 1;
+      hIntegralCount = hIntegral(static_cast < double > (count) + 0.5);
+      squeeze = 2 - hIntegralInverse(hIntegral(2.5) - h(2));
+    }
+
+    size_t operator()(SeededRandom & random) const {
+      for (;;) {
+        double u = hIntegralCount + random.uniform() * (hIntegralX1 - hIntegralCount);
+        double x = hIntegralInverse(u);
+        double k = std::min(std::max(std::floor(x + 0.5), 1.0), static_cast < double > (count));
+        if (k - x <= squeeze || u >= hIntegral(k + 0.5) - h(k)) {
+          return static_cast < size_t > (k) - 1;
+        }
+      }
+    }
+
+    // Fraction of all draws that land on rank
+    double share(size_t rank, double harmonic) const {
+      return h(static_cast < double > (rank + 1)) / harmonic;
+    }
+
+    // Normalizer for share: the sum of 1 / k^exponent over every rank
+    double harmonic() const {
+      double sum = 0;
+      for (size_t k = count; k >= 1; --k) sum += h(static_cast < double > (k));
+      return sum;
+    }
+};
+
+// Calls work(block) once for every block in [0, blockCount), spread over up
+// to threads threads (the caller's included). Blocks go to whichever thread
+// is free next.
+template < typename Work >
+void forEachBlock(size_t blockCount, unsigned threads, Work work) {
+  std::atomic < size_t > next {
+    0
+  };
+  auto drain = [ & ] {
+    for (size_t block; (block = next.fetch_add(1, std::memory_order_relaxed)) < blockCount;) work(block);
+  };
+  size_t helpers = std::min < size_t > (std::max(1u, threads), std::max < size_t > (blockCount, 1)) - 1;
+  std::vector < std::thread > pool;
+  for (size_t t = 0; t < helpers; ++t) pool.emplace_back(drain);
+  drain();
+  for (auto & thread: pool) thread.join();
+}
+
+// GameMarketplace Class to manage overall system
+class GameMarketplace{
+  private:
+    // Every entity is owned by one of these pools; the vectors below only
+    // reference them. Declared first so they outlive everything else.
+    ObjectPool < User > userPool;
+    ObjectPool < Game > gamePool;
+    ObjectPool < Administrator > adminPool;
+    StringArena textArena;
+    // Snapshots this marketplace was loaded from; restored games view their text
+    std::vector < std::unique_ptr < MappedFile >> snapshotMappings;
+
+    std::vector < User * > users;
+    std::vector < Game * > games; // in creation order
+    std::uint64_t nextGameNumber = 1; // ids are numbered and never reused, even after removeGame
+    std::vector < Administrator * > administrators;
+    CommunityFeed feed;
+    SalesLedger sales;
+
+    // Columnar game fields and search indexes, addressed by
+    // Game::getCatalogSlot(). The genre index is keyed by genre id instead.
+    // Titles are indexed folded (see foldForSearch), computed once per title.
+    CatalogStore catalog;
+    // Writes effective prices into catalog. Readers advance it when a sale
+    // window opens or closes (see settlePrices), hence mutable.
+    mutable PricingEngine pricing {
+      catalog
+    };
+    mutable std::atomic < std::time_t > nextPriceChange {
+      std::numeric_limits < std::time_t > ::min()
+    };
+    std::vector < std::string_view > foldedTitles; // views the title itself when folding changes nothing
+    TrigramIndex titleIndex;
+    FuzzyWordIndex titleWords;
+    TrigramIndex genreIndex;
+    std::uint32_t indexedGenres = 0;
+    CatalogIndex lookup;
+    std::unordered_map < std::string_view, User * > usersById; // keys view User::userId
+    std::unordered_map < std::string_view, User * > usersByName; // keys view User::username
+    std::unordered_map < std::string_view, Administrator * > adminsByName;
+
+    // Concurrency. Adding or removing users and games, renames, snapshots
+    // and compaction hold structureMutex exclusively; everything else holds
+    // it shared and then locks only the stripes of the entities it touches
+    // (user stripes before game stripes). A search reads every game's
+    // columns, so it takes all game stripes shared. The feed locks itself;
+    // postsMutex only keeps post ids in the same order as their log records.
+    static constexpr size_t LockStripeCount = 32;
+    mutable std::shared_mutex structureMutex;
+    mutable LockStripes < LockStripeCount > userStripes;
+    mutable LockStripes < LockStripeCount > gameStripes;
+    std::mutex postsMutex;
+
+    // Password hashing runs here, never under structureMutex: a few threads
+    // (a quarter of the cores) and at most 16 waiting logins per thread.
+    // Declared after the pools so it stops before they are torn down.
+    mutable HashingPool hashing {
+      std::max(1u, std::thread::hardware_concurrency() / 4),
+        16 * std::max < size_t > (1, std::thread::hardware_concurrency() / 4)
+    };
+    std::atomic < std::uint32_t > passwordCost {
+      PasswordHash::DefaultCost
+    };
+
+    std::shared_mutex & userLock(const User * user) const {
+      return userStripes.at(reinterpret_cast < std::uintptr_t > (user) / sizeof(User));
+    }
+    std::shared_mutex & gameLock(const Game * game) const {
+      return gameStripes.at(game -> getCatalogSlot());
+    }
+
+    // Durability: a mutation is logged while it still holds its locks, so
+    // the log orders conflicting changes the way they were applied; callers
+    // then wait for their record after releasing them
+    std::unique_ptr < WriteAheadLog > wal;
+    bool replaying = false;
+    std::uint64_t snapshotSequence = 0; // last log record the loaded snapshot covers
+    std::string snapshotPath;
+    std::thread compactor;
+    std::mutex compactorMutex;
+    std::condition_variable compactorWake;
+    bool compactorStopping = false;
+
+    // The log is folded into a fresh snapshot once it grows past this size
+    static constexpr std::uint64_t CompactionThreshold = 4u << 20;
+    static constexpr std::chrono::seconds CompactionInterval {
+      30
+    };
+
+    void addUser(User * user) {
+      users.push_back(user);
+      usersById[user -> getUserId()] = user;
+      usersByName[user -> getUsername()] = user;
+    }
+
+    void addAdministrator(Administrator * admin) {
+      administrators.push_back(admin);
+      adminsByName[admin -> getAdminUsername()] = admin;
+    }
+
+    User * findUserById(std::string_view userId) const {
+      auto it = usersById.find(userId);
+      return it == usersById.end() ? nullptr : it -> second;
+    }
+
+    // Matches no password, at the current cost, so a login for an unknown
+    // name takes as long as one for a real account
+    PasswordHash decoyCredential() const {
+      PasswordHash decoy;
+      decoy.cost = passwordCost.load(std::memory_order_relaxed);
+      return decoy;
+    }
+
+    // Queues a record describing a mutation that was just applied. Returns
+    // its sequence number, or 0 when nothing needs to wait for the log.
+    template < typename Encode >
+    std::uint64_t logMutation(MutationType type, Encode encode) {
+      if (!wal || replaying) return 0;
+      LogEncoder encoder;
+      encode(encoder);
+      return wal -> append(type, encoder.payload());
+    }
+
+    void awaitDurable(std::uint64_t sequence) {
+      if (sequence != 0) wal -> waitDurable(sequence);
+    }
+
+    template < typename Apply >
+    bool logUserGameChange(MutationType type, User * user, Game * game, Apply apply) {
+      std::uint64_t sequence;
+      {
+        std::shared_lock < std::shared_mutex > structure(structureMutex);
+        std::unique_lock < std::shared_mutex > lock(userLock(user));
+        if (!apply()) return false;
+        sequence = logMutation(type, [ & ](LogEncoder & out) {
+          out.putString(user -> getUserId());
+          out.putString(game -> getGameId());
+        });
+      }
+      awaitDurable(sequence);
+      return true;
+    }
+
+    // Opens and closes the sale windows due by now. Costs one clock read
+    // unless a window boundary has passed; callers must not hold
+    // structureMutex.
+    void settlePrices() const {
+      std::time_t now = std::time(nullptr);
+      if (now < nextPriceChange.load(std::memory_order_acquire)) return;
+      std::unique_lock < std::shared_mutex > structure(structureMutex);
+      pricing.advance(now);
+      nextPriceChange.store(pricing.nextChange(), std::memory_order_release);
+    }
+
+    // Adds the game to the library and records the sale at the current price,
+    // or at the price and time of a replayed purchase
+    bool purchase(User * user, Game * game, const SalesLedger::Sale * replayed) {
+      std::uint64_t sequence;
+      {
+        std::shared_lock < std::shared_mutex > structure(structureMutex);
+        std::unique_lock < std::shared_mutex > lock(userLock(user));
+        std::shared_lock < std::shared_mutex > reader(gameLock(game));
+        if (!user -> addToLibrary(game)) return false;
+        SalesLedger::Sale sale = replayed ? * replayed : SalesLedger::Sale {
+          static_cast < std::uint32_t > (std::llround(game -> getPrice() * 100)),
+            pricing.discount(game -> getCatalogSlot()), std::time(nullptr)
+        };
+        sales.record(user -> getUserId(), game -> getHandle(), game -> getDeveloperName(), sale);
+        sequence = logMutation(MutationType::PURCHASE, [ & ](LogEncoder & out) {
+          out.putString(user -> getUserId());
+          out.putString(game -> getGameId());
+          out.put < std::uint32_t > (sale.priceCents);
+          out.put < std::uint16_t > (sale.discountBasisPoints);
+          out.put < std::int64_t > (static_cast < std::int64_t > (sale.timestamp));
+        });
+      }
+      awaitDurable(sequence);
+      return true;
+    }
+
+    // Logs the credential, never the password
+    User * registerAccount(const std::string & username,
+      const std::string & email,
+        const PasswordHash & credential, UserRole role) {
+      std::uint64_t sequence;
+      User * newUser;
+      {
+        std::unique_lock < std::shared_mutex > structure(structureMutex);
+        if (usersByName.count(username)) throw std::invalid_argument("Username already taken");
+        newUser = userPool.create(std::to_string(users.size() + 1),
+          username, email, credential, role);
+        addUser(newUser);
+        sequence = logMutation(MutationType::REGISTER_USER, [ & ](LogEncoder & out) {
+          out.putString(username);
+          out.putString(email);
+          out.putString(credential.serialize());
+          out.put < std::uint8_t > (static_cast < std::uint8_t > (role));
+        });
+      }
+      awaitDurable(sequence);
+      return newUser;
+    }
+
+    // Re-applies one logged mutation through the same methods that logged it
+    void applyLogRecord(const WriteAheadLog::Record & record) {
+      SnapshotReader in(reinterpret_cast < const unsigned char * > (record.payload.data()), record.payload.size());
+      auto user = [ & ] {
+        User * found = findUserById(in.getString());
+        if (!found) throw std::runtime_error("Log refers to an unknown user");
+        return found;
+      };
+      auto game = [ & ] {
+        Game * found = findGameById(in.getString());
+        if (!found) throw std::runtime_error("Log refers to an unknown game");
+        return found;
+      };
+      switch (record.type) {
+      case MutationType::REGISTER_USER: {
+        std::string username(in.getString());
+        std::string email(in.getString());
+        PasswordHash credential = PasswordHash::deserialize(in.getString());
+        registerAccount(username, email, credential, static_cast < UserRole > (in.get < std::uint8_t > ()));
+        break;
+      }
+      case MutationType::PURCHASE: {
+        User * buyer = user();
+        Game * bought = game();
+        SalesLedger::Sale sale;
+        sale.priceCents = in.get < std::uint32_t > ();
+        sale.discountBasisPoints = in.get < std::uint16_t > ();
+        sale.timestamp = static_cast < std::time_t > (in.get < std::int64_t > ());
+        purchase(buyer, bought, & sale);
+        break;
+      }
+      case MutationType::LIBRARY_REMOVE: {
+        User * owner = user();
+        removeFromLibrary(owner, game());
+        break;
+      }
+      case MutationType::WISHLIST_ADD: {
+        User * owner = user();
+        addToWishlist(owner, game());
+        break;
+      }
+      case MutationType::WISHLIST_REMOVE: {
+        User * owner = user();
+        removeFromWishlist(owner, game());
+        break;
+      }
+      case MutationType::REVIEW: {
+        User * reviewer = user();
+        Game * reviewed = game();
+        std::string text(in.getString());
+        submitReview(reviewer, reviewed, text, in.get < std::int32_t > ());
+        break;
+      }
+      case MutationType::PRICE_UPDATE: {
+        Game * priced = game();
+        changePrice(priced, in.get < double > ());
+        break;
+      }
+      case MutationType::SALE_RULE: {
+        Game * discounted = game();
+        std::uint16_t discount = in.get < std::uint16_t > ();
+        std::time_t start = static_cast < std::time_t > (in.get < std::int64_t > ());
+        scheduleSale(discounted, discount / 100.0, start, static_cast < std::time_t > (in.get < std::int64_t > ()));
+        break;
+      }
+      case MutationType::POST: {
+        std::uint64_t id = in.get < std::uint64_t > ();
+        std::string_view author = in.getString();
+        std::string_view content = in.getString();
+        feed.restore(id, author, content, static_cast < std::time_t > (in.get < std::int64_t > ()));
+        break;
+      }
+      case MutationType::POST_REMOVE:
+        removePost(in.get < std::uint64_t > ());
+        break;
+      default:
+        throw std::runtime_error("Unknown log record type");
+      }
+    }
+
+    // Folds the log into a new snapshot and empties it
+    void compact() {
+      std::unique_lock < std::shared_mutex > structure(structureMutex);
+      std::uint64_t sequence = wal -> lastSequence();
+      wal -> waitDurable(sequence);
+      saveSnapshot(snapshotPath, sequence);
+      snapshotSequence = sequence;
+      wal -> reset();
+    }
+
+    void compactionLoop() {
+      std::unique_lock < std::mutex > lock(compactorMutex);
+      while (!compactorWake.wait_for(lock, CompactionInterval, [this] {
+          return compactorStopping;
+        })) {
+        if (wal -> sizeOnDisk() < CompactionThreshold) continue;
+        lock.unlock();
+        try {
+          compact();
+        } catch (const std::exception & e) {
+          std::cerr << "Compaction failed: " << e.what() << std::endl; // the log still has everything
+        }
+        lock.lock();
+      }
+    }
+
+    void indexTitle(Game * game) {
+      std::uint32_t slot = game -> getCatalogSlot();
+      if (foldedTitles.size() <= slot) foldedTitles.resize(slot + 1);
+      std::string folded = foldForSearch(game -> getTitle());
+      foldedTitles[slot] = folded == game -> getTitle() ? game -> getTitle() : textArena.store(folded);
+      titleIndex.add(slot, foldedTitles[slot]);
+      titleWords.add(slot, foldedTitles[slot]);
+    }
+
+    void unindexTitle(Game * game) {
+      std::uint32_t slot = game -> getCatalogSlot();
+      titleIndex.remove(slot, foldedTitles[slot]);
+      titleWords.remove(slot, foldedTitles[slot]);
+    }
+
+    void addToCatalog(Game * game) {
+      games.push_back(game);
+      lookup.add(game);
+      indexTitle(game);
+      pricing.track(game -> getCatalogSlot());
+      for (; indexedGenres < catalog.genreCount(); ++indexedGenres) {
+        genreIndex.add(indexedGenres, catalog.genreName(indexedGenres));
+      }
+    }
+
+    // Buffers searchGames reuses between calls on the same thread, so a warm
+    // search only allocates its result vector
+    struct SearchScratch {
+      SelectionBitmap selected;
+      std::vector < std::uint8_t > genreAllowed;
+      std::vector < std::int32_t > genreAllowedWide;
+      std::vector < std::uint32_t > candidates;
+      TrigramIndex::Scratch trigrams;
+      std::string foldedQuery;
+      std::vector < std::string_view > queryWords;
+      std::vector < std::vector < FuzzyWordIndex::Match >> wordMatches;
+      std::vector < std::pair < size_t, size_t >> wordCosts; // (games carrying a close word, query word)
+      FuzzyWordIndex::Scratch words;
+      // (slot, rank) per matching title: where the folded query starts in it,
+      // or TypoRank plus the typos when only its words matched
+      std::vector < std::pair < std::uint32_t, std::uint32_t >> matched, mergedMatches;
+      // (slot, total typos) for the games matched through close words, by slot
+      std::vector < std::pair < std::uint32_t, int >> typoMatches, closeSlots, merged;
+    };
+
+    static constexpr std::uint32_t TypoRank = 1u << 24;
+
+    // Fills scratch.matched, ascending by slot, with the games keep accepts
+    // whose title matches: either the folded query appears in the folded
+    // title, or every query word is within a few typos of some word of the
+    // title, in any order.
+    template < typename Keep >
+    void matchTitles(std::string_view title, SearchScratch & scratch, Keep && keep) const {
+      auto & matched = scratch.matched;
+      matched.clear();
+      foldForSearch(title, scratch.foldedQuery);
+      const std::string & query = scratch.foldedQuery;
+      auto checkSubstring = [ & ](std::uint32_t slot) {
+        if (!keep(slot)) return;
+        size_t at = foldedTitles[slot].find(query);
+        if (at != std::string_view::npos) matched.emplace_back(slot, static_cast < std::uint32_t > (std::min < size_t > (at, TypoRank - 1)));
+      };
+      if (TrigramIndex::canAnswer(query)) {
+        titleIndex.candidates(query, scratch.candidates, scratch.trigrams);
+        for (std::uint32_t slot: scratch.candidates) checkSubstring(slot);
+      } else {
+        for (std::uint32_t slot = 0; slot < catalog.size(); ++slot) checkSubstring(slot);
+      }
+
+      scratch.queryWords.clear();
+      forEachSearchWord(query, [ & ](std::string_view word) {
+        scratch.queryWords.push_back(word);
+      });
+      if (scratch.queryWords.empty()) return;
+
+      // Typo matches are the games that carry, for every query word, some
+      // word close to it: intersect those sets, smallest first
+      const size_t wordCount = scratch.queryWords.size();
+      if (scratch.wordMatches.size() < wordCount) scratch.wordMatches.resize(wordCount);
+      scratch.wordCosts.clear();
+      for (size_t i = 0; i < wordCount; ++i) {
+        std::string_view word = scratch.queryWords[i];
+        titleWords.lookup(word, FuzzyWordIndex::allowedTypos(word.size()), scratch.wordMatches[i], scratch.words);
+        size_t cost = 0;
+        for (const auto & match: scratch.wordMatches[i]) cost += titleWords.slotsOf(match.word).size();
+        if (cost == 0) return;
+        scratch.wordCosts.emplace_back(cost, i);
+      }
+      std::sort(scratch.wordCosts.begin(), scratch.wordCosts.end());
+
+      // Games carrying a word close to query word i, by slot, each with the
+      // distance to the closest such word
+      auto gatherClose = [ & ](size_t i, std::vector < std::pair < std::uint32_t, int >> & out) {
+        out.clear();
+        for (const auto & match: scratch.wordMatches[i]) {
+          for (std::uint32_t slot: titleWords.slotsOf(match.word)) out.emplace_back(slot, match.distance);
+        }
+        if (scratch.wordMatches[i].size() > 1) {
+          std::sort(out.begin(), out.end());
+          out.erase(std::unique(out.begin(), out.end(), [](const auto & a, const auto & b) {
+            return a.first == b.first;
+          }), out.end());
+        }
+      };
+      auto & typoMatches = scratch.typoMatches;
+      auto & merged = scratch.merged;
+      gatherClose(scratch.wordCosts[0].second, typoMatches);
+      for (size_t k = 1; k < wordCount && !typoMatches.empty(); ++k) {
+        const auto & matches = scratch.wordMatches[scratch.wordCosts[k].second];
+        merged.clear();
+        if (matches.size() == 1 && typoMatches.size() * 16 < titleWords.slotsOf(matches[0].word).size()) {
+          // Far fewer games so far than carry the word: probe its posting list
+          const auto & slots = titleWords.slotsOf(matches[0].word);
+          for (const auto & typoMatch: typoMatches) {
+            if (std::binary_search(slots.begin(), slots.end(), typoMatch.first)) {
+              merged.emplace_back(typoMatch.first, typoMatch.second + matches[0].distance);
+            }
+          }
+        } else {
+          gatherClose(scratch.wordCosts[k].second, scratch.closeSlots);
+          auto close = scratch.closeSlots.begin();
+          for (const auto & typoMatch: typoMatches) {
+            while (close != scratch.closeSlots.end() && close -> first < typoMatch.first) ++close;
+            if (close == scratch.closeSlots.end()) break;
+            if (close -> first == typoMatch.first) merged.emplace_back(typoMatch.first, typoMatch.second + close -> second);
+          }
+        }
+        typoMatches.swap(merged);
+      }
+
+      const size_t substringMatches = matched.size();
+      for (const auto & typoMatch: typoMatches) {
+        if (keep(typoMatch.first)) matched.emplace_back(typoMatch.first, TypoRank + typoMatch.second);
+      }
+      if (substringMatches > 0 && matched.size() > substringMatches) {
+        // Both runs are sorted; a title found both ways keeps its substring
+        // rank, which sorts first. Merged into scratch, as inplace_merge
+        // would allocate a buffer on every call.
+        auto & sorted = scratch.mergedMatches;
+        sorted.clear();
+        std::merge(matched.begin(), matched.begin() + substringMatches, matched.begin() + substringMatches,
+          matched.end(), std::back_inserter(sorted));
+        matched.swap(sorted);
+        matched.erase(std::unique(matched.begin(), matched.end(), [](const auto & a, const auto & b) {
+          return a.first == b.first;
+        }), matched.end());
+      }
+    }
+
+    // Flags each interned genre whose name contains the category query
+    void matchingGenres(std::string_view category, SearchScratch & scratch) const {
+      std::vector < std::uint8_t > & allowed = scratch.genreAllowed;
+      allowed.assign(catalog.genreCount(), category.empty() ? 1 : 0);
+      if (category.empty()) return;
+      if (TrigramIndex::canAnswer(category)) {
+        genreIndex.candidates(category, scratch.candidates, scratch.trigrams);
+        for (std::uint32_t id: scratch.candidates) {
+          allowed[id] = catalog.genreName(id).find(category) != std::string::npos;
+        }
+      } else {
+        for (std::uint32_t id = 0; id < catalog.genreCount(); ++id) {
+          allowed[id] = catalog.genreName(id).find(category) != std::string::npos;
+        }
+      }
+    }
+
+  public:
+    // Methods to register users, add games, etc.
+    // Hashes the password on the hashing pool (which may throw
+    // HashingPool::Busy) before taking any lock. Usernames are unique.
+    User * registerUser(const std::string & username,
+    const std::string & email,
+    const std::string & password, UserRole role) {
+      {
+        std::shared_lock < std::shared_mutex > structure(structureMutex);
+        if (usersByName.count(username)) throw std::invalid_argument("Username already taken");
+      }
+      std::uint32_t cost = passwordCost.load(std::memory_order_relaxed);
+      PasswordHash credential = hashing.run([ & ] {
+        return PasswordHash::create(password, cost);
+      });
+      return registerAccount(username, email, credential, role);
+    }
+
+    size_t hashingThreads() const {
+    return hashing.threadCount();
+  }
+
+  // Cost (PBKDF2 iterations) for passwords hashed from now on
+    void setPasswordCost(std::uint32_t iterations) {
+      if (iterations == 0) throw std::invalid_argument("Password cost must be at least 1");
+      passwordCost.store(iterations, std::memory_order_relaxed);
+    }
+
+  // Logged mutations. Each returns once its change is durable, and false
+  // (without logging) when it would change nothing.
+  bool purchaseGame(User * user, Game * game) {
+    settlePrices();
+    return purchase(user, game, nullptr);
+  }
+
+  bool removeFromLibrary(User * user, Game * game) {
+    return logUserGameChange(MutationType::LIBRARY_REMOVE, user, game, [ & ] {
+      return user -> removeFromLibrary(game);
+    });
+  }
+
+  bool addToWishlist(User * user, Game * game) {
+    return logUserGameChange(MutationType::WISHLIST_ADD, user, game, [ & ] {
+      return user -> addToWishlist(game);
+    });
+  }
+
+  bool removeFromWishlist(User * user, Game * game) {
+    return logUserGameChange(MutationType::WISHLIST_REMOVE, user, game, [ & ] {
+      return user -> removeFromWishlist(game);
+    });
+  }
+
+  // Throws like User::reviewGame when the review is rejected
+  void submitReview(User * user, Game * game, const std::string & reviewText, int rating) {
+    std::uint64_t sequence;
+    {
+      std::shared_lock < std::shared_mutex > structure(structureMutex);
+      std::shared_lock < std::shared_mutex > reader(userLock(user));
+      std::unique_lock < std::shared_mutex > lock(gameLock(game));
+      user -> reviewGame(game, reviewText, rating);
+      sequence = logMutation(MutationType::REVIEW, [ & ](LogEncoder & out) {
+        out.putString(user -> getUserId());
+        out.putString(game -> getGameId());
+        out.putString(reviewText);
+        out.put < std::int32_t > (rating);
+      });
+    }
+    awaitDurable(sequence);
+  }
+
+  void changePrice(Game * game, double newPrice) {
+    std::uint64_t sequence;
+    {
+      std::shared_lock < std::shared_mutex > structure(structureMutex);
+      std::unique_lock < std::shared_mutex > lock(gameLock(game));
+      pricing.setBasePrice(game -> getCatalogSlot(), newPrice);
+      sequence = logMutation(MutationType::PRICE_UPDATE, [ & ](LogEncoder & out) {
+        out.putString(game -> getGameId());
+        out.put < double > (newPrice);
+      });
+    }
+    awaitDurable(sequence);
+  }
+
+  // Puts a game on sale for [start, end) and returns the sale's rule id.
+  // Throws std::invalid_argument for a discount outside (0, 100] or an empty
+  // window. Overlapping sales do not compound; the best one applies.
+  std::uint64_t scheduleSale(Game * game, double discountPercentage, std::time_t start, std::time_t end) {
+    if (!(discountPercentage > 0 && discountPercentage <= 100)) {
+      throw std::invalid_argument("Discount must be above 0% and at most 100%");
+    }
+    std::uint16_t discount = static_cast < std::uint16_t > (std::lround(discountPercentage * 100));
+    std::uint64_t sequence, id;
+    {
+      std::unique_lock < std::shared_mutex > structure(structureMutex);
+      id = pricing.addRule(game -> getCatalogSlot(), discount, start, end);
+      pricing.advance(std::time(nullptr));
+      nextPriceChange.store(pricing.nextChange(), std::memory_order_release);
+      sequence = logMutation(MutationType::SALE_RULE, [ & ](LogEncoder & out) {
+        out.putString(game -> getGameId());
+        out.put < std::uint16_t > (discount);
+        out.put < std::int64_t > (static_cast < std::int64_t > (start));
+        out.put < std::int64_t > (static_cast < std::int64_t > (end));
+      });
+    }
+    awaitDurable(sequence);
+    return id;
+  }
+
+  // Returns the new post's id
+  std::uint64_t writePost(const std::string & author, const std::string & content) {
+    std::uint64_t sequence, id;
+    {
+      std::shared_lock < std::shared_mutex > structure(structureMutex);
+      std::lock_guard < std::mutex > lock(postsMutex);
+      // Never earlier than the newest post, so id order stays time order
+      std::time_t timestamp = std::max(std::time(nullptr), feed.newestTimestamp());
+      id = feed.append(author, content, timestamp);
+      sequence = logMutation(MutationType::POST, [ & ](LogEncoder & out) {
+        out.put < std::uint64_t > (id);
+        out.putString(author);
+        out.putString(content);
+        out.put < std::int64_t > (static_cast < std::int64_t > (timestamp));
+      });
+    }
+    awaitDurable(sequence);
+    return id;
+  }
+
+  // False when there is no such post; its id is not handed out again
+  bool removePost(std::uint64_t postId) {
+    std::uint64_t sequence;
+    {
+      std::shared_lock < std::shared_mutex > structure(structureMutex);
+      std::lock_guard < std::mutex > lock(postsMutex);
+      if (!feed.remove(postId)) return false;
+      sequence = logMutation(MutationType::POST_REMOVE, [ & ](LogEncoder & out) {
+        out.put < std::uint64_t > (postId);
+      });
+    }
+    awaitDurable(sequence);
+    return true;
+  }
+
+  // Loads path (or seeds the defaults if it does not exist yet), replays
+  // path + ".wal" on top and keeps logging every mutation from then on
+  void openDurable(const std::string & path) {
+    // Older posts are paged out next to the snapshot instead of held in memory
+    feed.spillTo(path + ".feed");
+    if (std::ifstream(path).good()) {
+      loadSnapshot(path);
+    } else {
+      // Seeding is randomized, so the log must start from a saved base
+      populateWithDefaults();
+      saveSnapshot(path);
+    }
+    snapshotPath = path;
+    wal = std::make_unique < WriteAheadLog > (path + ".wal");
+    std::uint64_t lastSequence = snapshotSequence;
+    replaying = true;
+    for (const auto & record: wal -> recover()) {
+      // Records up to the snapshot's sequence are already part of it; they
+      // remain only if a crash hit between saving the snapshot and the reset
+      if (record.sequence <= snapshotSequence) continue;
+      applyLogRecord(record);
+      lastSequence = record.sequence;
+    }
+    replaying = false;
+    wal -> start(lastSequence + 1);
+    compactor = std::thread( & GameMarketplace::compactionLoop, this);
+  }
+
+  // Stops background compaction and folds the remaining log into the snapshot
+  void closeDurable() {
+    if (!wal) return;
+    {
+      std::lock_guard < std::mutex > lock(compactorMutex);
+      compactorStopping = true;
+    }
+    compactorWake.notify_one();
+    compactor.join();
+    compact();
+    wal.reset();
+  }
+
+  ~GameMarketplace() {
+    if (!wal) return;
+    try {
+      closeDurable();
+    } catch (const std::exception & e) {
+      std::cerr << "Final compaction failed: " << e.what() << std::endl;
+    }
+  }
+
+  Game * createGame(const std::string & title,
+    const std::string & description,
+      double price,
+      const std::string & genre,
+        GameRating rating,
+        const std::string & developer) {
+    std::unique_lock < std::shared_mutex > structure(structureMutex);
+    Game * newGame = gamePool.create(catalog, textArena, std::to_string(nextGameNumber++),
+      title, description, price,
+      genre, rating, developer);
+    addToCatalog(newGame);
+    return newGame;
+  }
+
+  Game * findGameByTitle(std::string_view title) const {
+    std::shared_lock < std::shared_mutex > structure(structureMutex);
+    return lookup.findByTitle(title);
+  }
+
+  Game * findGameById(std::string_view gameId) const {
+    std::shared_lock < std::shared_mutex > structure(structureMutex);
+    return lookup.findById(gameId);
+  }
+
+  // Reads that are safe while other threads write. Review text views point
+  // into the arena, so the copy stays valid after the lock is released.
+  std::vector < std::pair < std::string_view, int >> reviewsOf(const Game * game) const {
+    std::shared_lock < std::shared_mutex > structure(structureMutex);
+    std::shared_lock < std::shared_mutex > lock(gameLock(game));
+    return game -> getReviews();
+  }
+
+  double priceOf(const Game * game) const {
+    settlePrices();
+    std::shared_lock < std::shared_mutex > structure(structureMutex);
+    std::shared_lock < std::shared_mutex > lock(gameLock(game));
+    return game -> getPrice();
+  }
+
+  bool ownsGame(const User * user, const Game * game) const {
+    std::shared_lock < std::shared_mutex > structure(structureMutex);
+    std::shared_lock < std::shared_mutex > lock(userLock(user));
+    return user -> owns(game -> getHandle());
+  }
+
+  // Run read(entity) while holding the entity's stripe shared, for callers
+  // that need several fields to be consistent with each other
+  template < typename Read >
+  auto withGame(const Game * game, Read read) const {
+    settlePrices();
+    std::shared_lock < std::shared_mutex > structure(structureMutex);
+    std::shared_lock < std::shared_mutex > lock(gameLock(game));
+    return read( * game);
+  }
+
+  template < typename Read >
+  auto withUser(const User * user, Read read) const {
+    std::shared_lock < std::shared_mutex > structure(structureMutex);
+    std::shared_lock < std::shared_mutex > lock(userLock(user));
+    return read( * user);
+  }
+
+  // Copies of the entity lists, safe to iterate while other threads write
+  std::vector < Game * > catalogGames() const {
+    std::shared_lock < std::shared_mutex > structure(structureMutex);
+    return games;
+  }
+
+  // Games with a sale in effect, in catalog order
+  std::vector < Game * > saleGames() const {
+    settlePrices();
+    std::shared_lock < std::shared_mutex > structure(structureMutex);
+    std::vector < Game * > onSale;
+    for (std::uint32_t slot: pricing.saleSlots()) onSale.push_back(catalog.owner(slot));
+    return onSale;
+  }
+
+  double basePriceOf(const Game * game) const {
+    std::shared_lock < std::shared_mutex > structure(structureMutex);
+    std::shared_lock < std::shared_mutex > lock(gameLock(game));
+    return pricing.basePrice(game -> getCatalogSlot());
+  }
+
+  std::vector < Game * > libraryOf(const User * user) const {
+    return withUser(user, [this](const User & owner) {
+      std::vector < Game * > copy;
+      copy.reserve(owner.getLibrary().size());
+      for (GameHandle handle: owner.getLibrary()) {
+        if (Game * game = catalog.resolve(handle)) copy.push_back(game);
+      }
+      return copy;
+    });
+  }
+
+  std::vector < Game * > wishlistOf(const User * user) const {
+    return withUser(user, [this](const User & owner) {
+      std::vector < Game * > copy;
+      copy.reserve(owner.getWishlist().size());
+      for (GameHandle handle: owner.getWishlist()) {
+        if (Game * game = catalog.resolve(handle)) copy.push_back(game);
+      }
+      return copy;
+    });
+  }
+
+  std::vector < User * > usersWithRole(UserRole role) const {
+    std::shared_lock < std::shared_mutex > structure(structureMutex);
+    std::vector < User * > matching;
+    for (auto * user: users) {
+      if (user -> getRole() == role) matching.push_back(user);
+    }
+    return matching;
+  }
+
+  // Up to limit posts older than post id before (0 = the newest), newest
+  // first, from everyone or from one author
+  CommunityFeed::Page communityFeed(size_t limit, std::uint64_t before = 0, std::string_view author = "") const {
+    return author.empty() ? feed.latest(limit, before) : feed.latestBy(author, limit, before);
+  }
+
+  bool findPost(std::uint64_t postId, Post & out) const {
+    return feed.find(postId, out);
+  }
+
+  // Sales of each of a developer's games, in the order they were added
+  std::vector < std::pair < std::string, SalesLedger::Totals >> gameSales(std::string_view developer) const {
+    std::shared_lock < std::shared_mutex > structure(structureMutex);
+    std::vector < std::pair < std::string, SalesLedger::Totals >> rows;
+    for (const Game * game: lookup.byDeveloperName(developer)) {
+      rows.emplace_back(std::string(game -> getTitle()), sales.game(game -> getHandle()));
+    }
+    return rows;
+  }
+
+  // Includes games that have since been removed
+  SalesLedger::Totals developerSales(std::string_view developer) const {
+    return sales.developer(developer);
+  }
+
+  std::vector < std::pair < std::string, SalesLedger::Totals >> salesByDeveloper() const {
+    return sales.developersWithSales();
+  }
+
+  std::vector < std::pair < std::time_t, SalesLedger::Totals >> dailySales(std::time_t from, std::time_t to) const {
+    return sales.days(from, to);
+  }
+
+  // Returns nullptr when no account matches. The password is checked on the
+  // hashing pool, so this throws HashingPool::Busy when too many logins are
+  // already waiting. An unknown name costs the same hashing as a known one.
+  User * authenticate(std::string_view username, UserRole role, const std::string & password) const {
+    User * user = nullptr;
+    PasswordHash credential = decoyCredential();
+    {
+      std::shared_lock < std::shared_mutex > structure(structureMutex);
+      auto found = usersByName.find(username);
+      if (found != usersByName.end() && found -> second -> getRole() == role) {
+        user = found -> second;
+        credential = user -> credential;
+      }
+    }
+    bool matches = hashing.run([ & ] {
+      return credential.matches(password);
+    });
+    return matches ? user : nullptr;
+  }
+
+  Administrator * authenticateAdmin(std::string_view username, const std::string & password) const {
+    Administrator * admin = nullptr;
+    PasswordHash credential = decoyCredential();
+    {
+      std::shared_lock < std::shared_mutex > structure(structureMutex);
+      auto found = adminsByName.find(username);
+      if (found != adminsByName.end()) {
+        admin = found -> second;
+        credential = admin -> getCredential();
+      }
+    }
+    bool matches = hashing.run([ & ] {
+      return credential.matches(password);
+    });
+    return matches ? admin : nullptr;
+  }
+
+  // First account with the role, shown as a login hint; empty if none
+  std::string sampleUsername(UserRole role) const {
+    std::shared_lock < std::shared_mutex > structure(structureMutex);
+    if (role == UserRole::ADMINISTRATOR) {
+      return administrators.empty() ? std::string() : std::string(administrators.front() -> getAdminUsername());
+    }
+    for (const auto * user: users) {
+      if (user -> getRole() == role) return std::string(user -> getUsername());
+    }
+    return std::string();
+  }
+
+  // The list is only stable until the next game is added or removed
+  const std::vector < Game * > & gamesByDeveloper(std::string_view developer) const {
+    return lookup.byDeveloperName(developer);
+  }
+
+  void renameGame(Game * game, const std::string & newTitle) {
+    std::unique_lock < std::shared_mutex > structure(structureMutex);
+    std::string_view oldTitle = game -> getTitle(); // still valid, the arena keeps it
+    unindexTitle(game);
+    game -> rename(newTitle);
+    lookup.renamed(game, oldTitle);
+    indexTitle(game);
+  }
+
+  // Removes a game from the store along with every reference to it
+  bool removeGame(Game * game) {
+    std::unique_lock < std::shared_mutex > structure(structureMutex);
+    auto it = std::find(games.begin(), games.end(), game);
+    if (it == games.end()) {
+      return false;
+    }
+    games.erase(it);
+    // Libraries and wishlists keep the game's handle, which stops resolving
+    // once retire bumps the slot's generation; no user needs visiting
+    pricing.untrack(game -> getCatalogSlot());
+    unindexTitle(game);
+    lookup.remove(game);
+    catalog.retire(game -> getCatalogSlot());
+    gamePool.destroy(game);
+    return true;
+  }
+
+  // Search functionality
+    std::vector<Game*> searchGames(std::string_view title = "", 
+                                    double minPrice = 0.0, 
+                                    double maxPrice = std::numeric_limits<double>::max(),
+                                    std::string_view category = "",
+                                    GameRating rating = GameRating::E,
+                                    std::time_t minReleaseDate = 0, 
+                                    std::time_t maxReleaseDate = std::numeric_limits<std::time_t>::max()) 
+    {
+        settlePrices();
+        thread_local SearchScratch scratch;
+        std::vector<Game*> results;
+        std::shared_lock<std::shared_mutex> structure(structureMutex);
+        gameStripes.lockAllShared();
+        struct StripeRelease {
+            LockStripes<LockStripeCount>& stripes;
+            ~StripeRelease() { stripes.unlockAllShared(); }
+        } release{gameStripes};
+
+        // Price, category (genre), rating and release date are checked in one
+        // pass over the columnar store; rating E means "any rating"
+        matchingGenres(category, scratch);
+        catalog.filterInto(minPrice, maxPrice, rating, minReleaseDate, maxReleaseDate,
+                           scratch.genreAllowed, scratch.selected, scratch.genreAllowedWide);
+        const SelectionBitmap& selected = scratch.selected;
+
+        if (!title.empty())
+        {
+            // Case- and accent-insensitive, tolerating a typo or two per word
+            matchTitles(title, scratch, [&](std::uint32_t slot) { return selected.test(slot); });
+            results.reserve(scratch.matched.size());
+            for (const auto& match : scratch.matched) results.push_back(catalog.owner(match.first));
+        }
+        else
+        {
+            size_t selectedCount = 0;
+            for (std::uint64_t word : selected.words) selectedCount += __builtin_popcountll(word);
+            results.reserve(selectedCount);
+
+            for (size_t w = 0; w < selected.words.size(); ++w) 
+            {
+                for (std::uint64_t bits = selected.words[w]; bits != 0; bits &= bits - 1)
+                {
+                    std::uint32_t slot = static_cast<std::uint32_t>(w * 64 + __builtin_ctzll(bits));
+                    results.push_back(catalog.owner(slot));
+                }
+            }
+        }
+
+        return results;
+    }
+
+    // One page of matches in the given order. Takes time proportional to
+    // the page size when only the filters are set: the page is read off a
+    // sorted index (or catalog order) starting at the cursor. A title query
+    // or relevance order keeps the best pageSize matches in a bounded heap.
+    SearchPage searchGamesPage(std::string_view title, double minPrice, double maxPrice,
+                               std::string_view category, GameRating rating,
+                               std::time_t minReleaseDate, std::time_t maxReleaseDate,
+                               SearchOrder order, size_t pageSize, std::string_view cursor = "")
+    {
+        if (pageSize == 0) throw std::invalid_argument("Page size must be positive");
+        if (order == SearchOrder::RELEVANCE && title.empty()) order = SearchOrder::CATALOG;
+        const bool hasCursor = !cursor.empty();
+        const SearchCursor after = hasCursor ? SearchCursor::decode(cursor, order) : SearchCursor{order, 0.0, 0};
+        const bool descending = order == SearchOrder::PRICE_HIGH_TO_LOW || order == SearchOrder::TOP_RATED ||
+                                order == SearchOrder::NEWEST;
+
+        thread_local SearchScratch scratch;
+        thread_local std::vector<std::pair<double, std::uint32_t>> ranked;
+        ranked.clear();
+        settlePrices();
+        std::shared_lock<std::shared_mutex> structure(structureMutex);
+        gameStripes.lockAllShared();
+        struct StripeRelease {
+            LockStripes<LockStripeCount>& stripes;
+            ~StripeRelease() { stripes.unlockAllShared(); }
+        } release{gameStripes};
+
+        matchingGenres(category, scratch);
+        // titleRank is the rank matchTitles gave the slot
+        auto sortValue = [&](std::uint32_t slot, std::uint32_t titleRank) {
+            switch (order) {
+            case SearchOrder::PRICE_LOW_TO_HIGH:
+            case SearchOrder::PRICE_HIGH_TO_LOW: return catalog.price(slot);
+            case SearchOrder::TOP_RATED: return catalog.averageRating(slot);
+            case SearchOrder::NEWEST: return static_cast<double>(catalog.releaseDate(slot));
+            case SearchOrder::RELEVANCE:
+                return static_cast<double>(titleRank) * 65536.0 + static_cast<double>(foldedTitles[slot].size());
+            default: return 0.0;
+            }
+        };
+        // True when position a comes before position b in this order
+        auto precedes = [descending](const std::pair<double, std::uint32_t>& a, const std::pair<double, std::uint32_t>& b) {
+            return descending ? b < a : a < b;
+        };
+        const std::pair<double, std::uint32_t> start{after.value, after.slot};
+
+        // One extra result tells whether another page follows
+        const size_t wanted = pageSize + 1;
+        if (title.empty() && order != SearchOrder::CATALOG)
+        {
+            const CatalogStore::SortIndex& index = catalog.sortIndex(
+                order == SearchOrder::TOP_RATED ? SortColumn::AVERAGE_RATING :
+                order == SearchOrder::NEWEST ? SortColumn::RELEASE_DATE : SortColumn::PRICE);
+            auto take = [&](auto begin, auto end) {
+                for (auto it = begin; it != end && ranked.size() < wanted; ++it) {
+                    if (catalog.passes(it->second, minPrice, maxPrice, rating, minReleaseDate, maxReleaseDate,
+                                       scratch.genreAllowed)) {
+                        ranked.push_back(*it);
+                    }
+                }
+            };
+            if (descending) {
+                take(hasCursor ? std::make_reverse_iterator(index.lower_bound(start)) : index.rbegin(), index.rend());
+            } else {
+                take(hasCursor ? index.upper_bound(start) : index.begin(), index.end());
+            }
+        }
+        else if (title.empty())
+        {
+            for (std::uint32_t slot = hasCursor ? after.slot + 1 : 0; slot < catalog.size() && ranked.size() < wanted; ++slot) {
+                if (catalog.passes(slot, minPrice, maxPrice, rating, minReleaseDate, maxReleaseDate, scratch.genreAllowed)) {
+                    ranked.emplace_back(0.0, slot);
+                }
+            }
+        }
+        else
+        {
+            // Bounded max-heap on position: the top is the worst of the best so far
+            std::priority_queue<std::pair<double, std::uint32_t>, std::vector<std::pair<double, std::uint32_t>>,
+                                decltype(precedes)> best(precedes);
+            matchTitles(title, scratch, [&](std::uint32_t slot) {
+                return catalog.passes(slot, minPrice, maxPrice, rating, minReleaseDate, maxReleaseDate, scratch.genreAllowed);
+            });
+            for (const auto& match : scratch.matched) {
+                std::pair<double, std::uint32_t> position{sortValue(match.first, match.second), match.first};
+                if (hasCursor && !precedes(start, position)) continue;
+                if (best.size() < wanted) {
+                    best.push(position);
+                } else if (precedes(position, best.top())) {
+                    best.pop();
+                    best.push(position);
+                }
+            }
+            for (; !best.empty(); best.pop()) ranked.push_back(best.top());
+            std::reverse(ranked.begin(), ranked.end());
+        }
+
+        SearchPage page;
+        if (ranked.size() > pageSize) {
+            ranked.pop_back();
+            page.nextCursor = SearchCursor{order, ranked.back().first, ranked.back().second}.encode();
+        }
+        page.games.reserve(ranked.size());
+        for (const auto& position : ranked) page.games.push_back(catalog.owner(position.second));
+        return page;
+    }
+
+  // Entities are owned by the pools, which free everything in bulk on
+  // destruction, including posts and games that are only on the sale list
+
+  struct AllocationReport {
+    ObjectPool < User > ::Stats users;
+    ObjectPool < Game > ::Stats games;
+    ObjectPool < Administrator > ::Stats administrators;
+    CommunityFeed::Stats posts;
+    StringArena::Stats text;
+    SalesLedger::Stats sales;
+  };
+
+  AllocationReport allocationStats() const {
+    std::unique_lock < std::shared_mutex > structure(structureMutex);
+    return {
+      userPool.stats(), gamePool.stats(), adminPool.stats(), feed.stats(), textArena.stats(), sales.stats()
+    };
+  }
+
+  void populateWithDefaults() {
+    // Every default account's password is "password"; hashed once and shared,
+    // since these are test accounts
+    PasswordHash credential = PasswordHash::create("password", passwordCost.load(std::memory_order_relaxed));
+
+    // Create 2 default customer users
+    for (int i = 1; i <= 2; ++i) {
+      std::string userId = "customer" + std::to_string(i);
+      addUser(userPool.create(userId, userId, userId + "@example.com", credential, UserRole::CUSTOMER));
+    }
+
+    // Create 2 default developer users
+    for (int i = 1; i <= 2; ++i) {
+      std::string userId = "developer" + std::to_string(i);
+      addUser(userPool.create(userId, userId, userId + "@example.com", credential, UserRole::DEVELOPER));
+    }
+
+    // Create 2 default manager users
+    for (int i = 1; i <= 2; ++i) {
+      std::string userId = "manager" + std::to_string(i);
+      addUser(userPool.create(userId, userId, userId + "@example.com", credential, UserRole::MANAGER));
+    }
+
+    //Added 2 default admin users
+    for (int i = 1; i <= 2; ++i) {
+      std::string adminId = "admin" + std::to_string(i);
+      addAdministrator(adminPool.create(adminId, adminId, credential));
+    }
+
+    // Create 10 default games with ratings and reviews, randomly assigned to developers
+        std::random_device rd; 
+        std::mt19937 gen(rd()); 
+        std::uniform_int_distribution<> devDistrib(1, 2); // Distribution for developer index (1 or 2)
+
+        GameRating ratings[] = {GameRating::E, GameRating::E10, GameRating::T, GameRating::M, GameRating::AO};
+        for (int i = 1; i <= 10; ++i) {
+        std::string gameId = "game" + std::to_string(i);
+        GameRating selectedRating = ratings[(i-1) % 5];
+
+        // Randomly select a developer
+        int devIndex = devDistrib(gen);
+        std::string developerName = "developer" + std::to_string(devIndex); 
+
+        Game* newGame = gamePool.create(
+            catalog,
+            textArena,
+            gameId, 
+            "Game " + std::to_string(i), 
+            "Description " + std::to_string(i),
+            19.99 + i, 
+            "Genre " + std::to_string(i),
+            selectedRating, 
+            developerName 
+        );
+
+        addToCatalog(newGame);
+
+        // Add reviews to some games
+        if (i % 2 == 0) {
+            std::vector<std::pair<std::string, int>> seedReviews;
+            for (int j = 1; j <= i / 2; ++j) {
+                seedReviews.push_back(std::make_pair("Review " + std::to_string(j), j % 5 + 1)); // Ratings from 1 to 5
+            }
+            newGame->addReviews(seedReviews);
+        }
+
+        if (i <= 3) {
+            pricing.addRule(newGame->getCatalogSlot(), 2500, std::time(nullptr), std::time(nullptr) + 7 * 24 * 60 * 60);
+        }
+    }
+
+    // Add 3 default posts to the community tab
+    std::time_t now = std::time(nullptr);
+    feed.append("customer1", "This game is awesome!", now);
+    feed.append("customer2", "Anyone want to play?", now);
+    feed.append("user3", "sigma", now);
+
+  }
+
+  // Builds a marketplace at capacity-testing scale from config.seed. Game
+  // popularity, studio catalogs, review counts and posting activity follow
+  // Zipf's law; library sizes are heavy tailed and libraries and wishlists
+  // lean toward popular games; every owned game has a purchase in the sales
+  // ledger. Libraries, wishlists and reviews are drawn in parallel, each block
+  // of users or games from its own stream, so the thread count never changes
+  // the result. Nothing is logged: call it before openDurable, or save a
+  // snapshot afterwards. The marketplace must be empty.
+  void populateSynthetic(const SyntheticConfig & config) {
+    if (!users.empty() || !games.empty() || !administrators.empty() || feed.nextId() != 1 || sales.size() != 0) {
+      throw std::logic_error("Synthetic data can only be generated into an empty marketplace");
+    }
+    if (config.games == 0 || config.historyDays <= 0 || config.popularitySkew <= 0) {
+      throw std::invalid_argument("A synthetic marketplace needs games, a history window and a positive skew");
+    }
+    if (config.meanLibrary < 0 || config.libraryTail <= 1 || config.wishlistRatio < 0 || config.reviewsPerGame < 0) {
+      throw std::invalid_argument(
+        "Library, wishlist and review rates cannot be negative, and the library tail must exceed 1");
+    }
+
+    enum Phase: std::uint64_t {
+      GAMES = 1, POPULARITY, LIBRARIES, REVIEWS, SALES, POSTS
+    };
+    const size_t BlockSize = 4096;
+    auto blocksOf = [ & ](size_t count) {
+      return (count + BlockSize - 1) / BlockSize;
+    };
+    // Visits 0..count-1 in a scrambled order: i -> (i * stride + offset) % count
+    auto scramble = [ & ](size_t count, SeededRandom & random) {
+      std::uint64_t stride = 1 + random.below(count);
+      while (std::gcd < std::uint64_t > (stride, count) != 1) ++stride;
+      return std::make_pair(stride, random.below(count));
+    };
+
+    static const char * const adjectives[] = {"Crimson", "Silent", "Ancient", "Galactic", "Mystic", "Broken",
+      "Infinite", "Hollow", "Savage", "Radiant", "Frozen", "Iron", "Shadow", "Golden", "Forgotten", "Neon",
+      "Wild", "Last", "Lost", "Sacred", "Burning", "Distant", "Endless", "Hidden", "Royal", "Rusty", "Stellar",
+      "Sunken", "Twisted", "Velvet", "Wandering", "Emerald"};
+    static const char * const nouns[] = {"Kingdom", "Empire", "Odyssey", "Frontier", "Dungeon", "Horizon",
+      "Requiem", "Crusade", "Rampage", "Chronicles", "Outlaws", "Voyage", "Citadel", "Paradox", "Tactics",
+      "Legends", "Harvest", "Depths", "Skies", "Circuit", "Garden", "Tides", "Engine", "Colony", "Arena",
+      "Orchard", "Station", "Labyrinth", "Rebellion", "Archive", "Wasteland", "Lighthouse"};
+    static const char * const subtitles[] = {"", ": Reborn", ": Origins", ": Awakening", ": Remastered",
+      ": The Lost Chapter", ": Ascension", ": Definitive Edition", ": Beyond", ": Redemption", ": Uprising",
+      ": Deluxe", ": Exodus", ": Homecoming", ": Nightfall", ": Legacy"};
+    static const char * const studioWords[] = {"Iron", "Blue", "Red", "North", "Hollow", "Bright", "Stone",
+      "Lunar", "Pixel", "Copper", "Wild", "Quiet", "Golden", "Storm", "Glass", "Paper"};
+    static const char * const studioKinds[] = {"forge", "bird", "wolf", "light", "tree", "works", "gate", "hill"};
+    static const char * const handleWords[] = {"quiet", "swift", "lucky", "brave", "sleepy", "clever", "grumpy",
+      "happy", "salty", "shy", "noble", "fuzzy", "rapid", "tiny", "bold", "calm"};
+    static const char * const handleNouns[] = {"fox", "raven", "otter", "panda", "wolf", "gecko", "moose",
+      "badger", "falcon", "tiger", "koala", "lynx", "heron", "bison", "shark", "crab"};
+    static const std::array < const char * , 12 > genres = {"Action", "Adventure", "Role-Playing", "Strategy",
+      "Simulation", "Puzzle", "Platformer", "Shooter", "Racing", "Sports", "Horror", "Casual"};
+    static const std::array < double, 12 > genreWeights = {18, 14, 12, 9, 10, 8, 7, 8, 4, 4, 5, 11};
+    static const std::array < GameRating, 5 > ratings = {GameRating::E, GameRating::E10, GameRating::T,
+      GameRating::M, GameRating::AO};
+    static const std::array < double, 5 > ratingWeights = {30, 20, 30, 18, 2};
+    static const std::array < double, 9 > prices = {0.99, 4.99, 9.99, 14.99, 19.99, 24.99, 29.99, 39.99, 59.99};
+    static const std::array < double, 9 > priceWeights = {6, 18, 22, 16, 14, 6, 8, 5, 5};
+    // Descriptions read first + genre + second + studio + third
+    static const std::array < std::array < const char * , 3 > , 4 > blurbs = {{
+      {"A ", " game from ", " that critics keep calling a sleeper hit."},
+      {"Explore, fight and build in this ", " adventure by ", "."},
+      {"A ", " experience handcrafted by the team at ", "."},
+      {"", " done right: the latest release from ", "."}
+    }};
+    static const char * const reviewLines[5][4] = {
+      {"Refunded after an hour.", "Crashes constantly.", "Not worth it, even on sale.", "Avoid."},
+      {"Some good ideas, poorly executed.", "Gets repetitive fast.", "Wait for a patch.", "Disappointing."},
+      {"Decent, nothing special.", "Fun in short bursts.", "Good on sale.", "It's fine."},
+      {"Really enjoyable.", "Great with friends.", "Solid and polished.", "Lost a weekend to this."},
+      {"Masterpiece.", "Game of the year for me.", "Instantly one of my favorites.", "Buy it now."}
+    };
+    static const std::array < std::pair < const char * , const char * > , 5 > postLines = {{
+      {"Anyone else playing ", "?"}, {"Just finished ", ", what a ride."},
+      {"", " is on my wishlist until the next sale."}, {"Looking for a group in ", "."},
+      {"Is ", " worth it at full price?"}
+    }};
+    static const std::array < double, 4 > discountWeights = {80, 8, 7, 5};
+    static const std::array < std::uint16_t, 4 > discounts = {0, 2500, 5000, 7500};
+
+    const std::time_t span = static_cast < std::time_t > (config.historyDays) * SalesLedger::SecondsPerDay;
+    const size_t studios = config.developers ? config.developers : std::max < size_t > (1, config.games / 25);
+    const size_t combinations = std::size(adjectives) * std::size(nouns) * std::size(subtitles);
+    SeededRandom setup(config.seed, GAMES);
+    auto titles = scramble(combinations, setup);
+
+    // Studios first, so a game can carry its developer's name
+    std::vector < std::string_view > studioNames(studios);
+    const size_t studioPairs = std::size(studioWords) * std::size(studioKinds);
+    for (size_t k = 0; k < studios; ++k) {
+      std::string name = std::string(studioWords[k % std::size(studioWords)]) +
+        studioKinds[(k / std::size(studioWords)) % std::size(studioKinds)] +
+        (k >= studioPairs ? std::to_string(k / studioPairs + 1) : "");
+      studioNames[k] = textArena.store(name);
+    }
+
+    // Games: drawn in parallel, then added in slot order
+    struct GameSpec {
+      std::uint32_t developer;
+      std::uint8_t genre;
+      std::uint8_t rating;
+      std::uint8_t price;
+      std::uint8_t blurb;
+      std::time_t release;
+    };
+    std::vector < GameSpec > specs(config.games);
+    ZipfSampler studioSizes(studios, config.popularitySkew);
+    forEachBlock(blocksOf(config.games), config.threads, [ & ](size_t block) {
+      SeededRandom random(config.seed, GAMES, block);
+      for (size_t i = block * BlockSize; i < std::min(config.games, (block + 1) * BlockSize); ++i) {
+        GameSpec & spec = specs[i];
+        spec.developer = static_cast < std::uint32_t > (studioSizes(random));
+        spec.genre = static_cast < std::uint8_t > (random.weighted(genreWeights));
+        spec.rating = static_cast < std::uint8_t > (random.weighted(ratingWeights));
+        spec.price = static_cast < std::uint8_t > (random.weighted(priceWeights));
+        spec.blurb = static_cast < std::uint8_t > (random.below(blurbs.size()));
+        // Most of the catalog is recent
+        double age = random.uniform();
+        spec.release = config.now - static_cast < std::time_t > (age * age * static_cast < double > (span));
+      }
+    });
+
+    games.reserve(config.games);
+    catalog.reserve(config.games);
+    lookup.reserve(config.games);
+    std::string title, description;
+    for (size_t i = 0; i < config.games; ++i) {
+      const GameSpec & spec = specs[i];
+      size_t combination = (i * titles.first + titles.second) % combinations;
+      title.assign(adjectives[combination % std::size(adjectives)]);
+      title.append(" ").append(nouns[(combination / std::size(adjectives)) % std::size(nouns)]);
+      title.append(subtitles[combination / (std::size(adjectives) * std::size(nouns))]);
+      if (i >= combinations) title.append(" ").append(std::to_string(i / combinations + 1));
+      const auto & blurb = blurbs[spec.blurb];
+      description.assign(blurb[0]).append(genres[spec.genre]).append(blurb[1]);
+      description.append(studioNames[spec.developer]).append(blurb[2]);
+      Game * game = gamePool.create(catalog, textArena, std::to_string(nextGameNumber++), textArena.store(title),
+        textArena.store(description), prices[spec.price], genres[spec.genre], ratings[spec.rating],
+        studioNames[spec.developer], spec.release);
+      addToCatalog(game);
+    }
+
+    // Accounts: studios, managers, then customers. Every password is
+    // "password", hashed once (each at full cost would take hours) under a
+    // salt drawn from the seed.
+    std::array < unsigned char, PasswordHash::SaltSize > salt;
+    for (auto & byte: salt) byte = static_cast < unsigned char > (setup.next());
+    PasswordHash credential = PasswordHash::create("password", passwordCost.load(std::memory_order_relaxed), salt);
+    users.reserve(studios + config.managers + config.users);
+    usersById.reserve(studios + config.managers + config.users);
+    usersByName.reserve(studios + config.managers + config.users);
+    auto addAccount = [ & ](const std::string & username, UserRole role) {
+      addUser(userPool.create(std::to_string(users.size() + 1), username, username + "@example.com", credential, role));
+    };
+    for (size_t k = 0; k < studios; ++k) addAccount(std::string(studioNames[k]), UserRole::DEVELOPER);
+    for (size_t k = 1; k <= config.managers; ++k) addAccount("manager" + std::to_string(k), UserRole::MANAGER);
+    const size_t firstCustomer = users.size();
+    std::string handle;
+    for (size_t i = 0; i < config.users; ++i) {
+      size_t pick = i * 7 + config.seed;
+      handle.assign(handleWords[pick % std::size(handleWords)]);
+      handle.append(handleNouns[(pick / std::size(handleWords)) % std::size(handleNouns)]);
+      handle.append(std::to_string(i + 1));
+      addAccount(handle, UserRole::CUSTOMER);
+    }
+    for (size_t k = 1; k <= config.administrators; ++k) {
+      std::string adminId = "admin" + std::to_string(k);
+      addAdministrator(adminPool.create(adminId, adminId, credential));
+    }
+
+    // Popularity rank -> game, independent of slot order
+    std::vector < Game * > byRank(games);
+    SeededRandom shuffle(config.seed, POPULARITY);
+    for (size_t i = byRank.size() - 1; i > 0; --i) std::swap(byRank[i], byRank[shuffle.below(i + 1)]);
+    ZipfSampler popularity(config.games, config.popularitySkew);
+
+    // Libraries and wishlists; each block owns its users outright
+    const double lomaxScale = config.meanLibrary * (config.libraryTail - 1);
+    const double libraryCap = static_cast < double > (std::min(config.maxLibrary, config.games));
+    forEachBlock(blocksOf(config.users), config.threads, [ & ](size_t block) {
+      SeededRandom random(config.seed, LIBRARIES, block);
+      for (size_t i = block * BlockSize; i < std::min(config.users, (block + 1) * BlockSize); ++i) {
+        User * user = users[firstCustomer + i];
+        double draw = lomaxScale * (std::pow(1 - random.uniform(), -1 / config.libraryTail) - 1);
+        size_t size = static_cast < size_t > (std::min(draw, libraryCap));
+        // Duplicate picks are retried, up to a point for tiny catalogs
+        for (size_t attempts = 0; user -> library.size() < size && attempts < 4 * size; ++attempts) {
+          user -> addToLibrary(byRank[popularity(random)]);
+        }
+        size_t wishes = random.roundStochastic(static_cast < double > (size + 1) * config.wishlistRatio);
+        for (size_t attempts = 0; user -> wishlist.size() < wishes && attempts < 4 * wishes; ++attempts) {
+          Game * game = byRank[popularity(random)];
+          if (!user -> owns(game -> getHandle())) user -> addToWishlist(game);
+        }
+      }
+    });
+
+    // Reviews: each game's count is its popularity share of the total, and
+    // its stars scatter around a per-game quality
+    if (config.reviewsPerGame > 0) {
+      const double harmonic = popularity.harmonic();
+      const double totalReviews = config.reviewsPerGame * static_cast < double > (config.games);
+      forEachBlock(blocksOf(config.games), config.threads, [ & ](size_t block) {
+        SeededRandom random(config.seed, REVIEWS, block);
+        std::vector < std::pair < std::string_view, int >> batch;
+        for (size_t rank = block * BlockSize; rank < std::min(config.games, (block + 1) * BlockSize); ++rank) {
+          size_t count = random.roundStochastic(totalReviews * popularity.share(rank, harmonic));
+          double quality = 1 + 4 * random.uniform();
+          batch.resize(count);
+          for (auto & review: batch) {
+            double stars = std::floor(quality + 2 * random.uniform() - 0.5);
+            review.second = static_cast < int > (std::min(std::max(stars, 1.0), 5.0));
+            review.first = reviewLines[review.second - 1][random.below(4)];
+          }
+          byRank[rank] -> adoptReviews(batch);
+        }
+      });
+    }
+
+    // One purchase per owned game, some bought on sale, at some point after
+    // the game's release. Rows are drawn in parallel and appended block by
+    // block, so the ledger is the same on every run.
+    if (config.recordSales) {
+      std::vector < std::uint32_t > studioKeys(studios);
+      for (size_t k = 0; k < studios; ++k) studioKeys[k] = sales.developerKey(studioNames[k]);
+      std::vector < std::uint32_t > buyerKeys(config.users);
+      for (size_t i = 0; i < config.users; ++i) {
+        const User * user = users[firstCustomer + i];
+        if (user -> library.size() != 0) buyerKeys[i] = sales.buyerKey(user -> getUserId());
+      }
+      const size_t blocks = blocksOf(config.users);
+      std::vector < std::vector < SalesLedger::Row >> rows(blocks);
+      std::vector < std::uint8_t > drawn(blocks, 0);
+      std::mutex drawnMutex;
+      size_t nextToRecord = 0;
+      // Whichever thread draws the oldest block still missing records it and
+      // any later blocks already drawn, so buffers never pile up
+      forEachBlock(blocks, config.threads, [ & ](size_t block) {
+        SeededRandom random(config.seed, SALES, block);
+        std::vector < SalesLedger::Row > & batch = rows[block];
+        for (size_t i = block * BlockSize; i < std::min(config.users, (block + 1) * BlockSize); ++i) {
+          for (GameHandle game: users[firstCustomer + i] -> library) {
+            std::uint16_t discount = discounts[random.weighted(discountWeights)];
+            std::time_t release = catalog.releaseDate(game.slot);
+            batch.push_back({buyerKeys[i], game, studioKeys[specs[game.slot].developer], {
+              static_cast < std::uint32_t > (std::llround(catalog.price(game.slot) * (10000 - discount) / 100)),
+              discount, release + static_cast < std::time_t > (random.uniform() * static_cast < double > (config.now - release))
+            }});
+          }
+        }
+        std::unique_lock < std::mutex > lock(drawnMutex);
+        drawn[block] = 1;
+        if (block != nextToRecord) return;
+        while (nextToRecord < blocks && drawn[nextToRecord]) {
+          size_t next = nextToRecord;
+          lock.unlock();
+          sales.record(rows[next]);
+          std::vector < SalesLedger::Row > ().swap(rows[next]);
+          lock.lock();
+          nextToRecord = next + 1;
+        }
+      });
+    }
+
+    // Posts, evenly spaced through the history; a few users write most of them
+    if (config.posts > 0) {
+      SeededRandom random(config.seed, POSTS);
+      ZipfSampler posters(users.size(), config.popularitySkew);
+      auto posterOrder = scramble(users.size(), random);
+      std::string content;
+      for (size_t p = 0; p < config.posts; ++p) {
+        const User * author = users[(posters(random) * posterOrder.first + posterOrder.second) % users.size()];
+        const auto & line = postLines[random.below(postLines.size())];
+        content.assign(line.first).append(byRank[popularity(random)] -> getTitle()).append(line.second);
+        std::time_t timestamp = config.now - span + static_cast < std::time_t > (
+          static_cast < double > (span) * static_cast < double > (p) / static_cast < double > (config.posts));
+        feed.append(author -> getUsername(), content, timestamp);
+      }
+    }
+  }
+
+  // Writes the whole marketplace to path. The file is written next to path
+  // and renamed over it once complete, so a crash never leaves a torn snapshot.
+  void saveSnapshot(const std::string & path, std::uint64_t logSequence = 0) const {
+    std::string tempPath = path + ".tmp";
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      throw std::runtime_error("Cannot write " + tempPath);
+    }
+    SnapshotHeader header {};
+    out.write(reinterpret_cast < const char * > ( & header), sizeof(header));
+
+    // Cold section: descriptions, then review text, in catalog order
+    SnapshotWriter cold(out);
+    for (const auto * game: games) {
+      cold.write(game -> getDescription().data(), game -> getDescription().size());
+      for (const auto & review: game -> getReviews()) {
+        cold.write(review.first.data(), review.first.size());
+      }
+    }
+    auto coldSection = cold.finish();
+
+    // Hot section
+    SnapshotWriter hot(out);
+    hot.put < std::uint32_t > (catalog.genreCount());
+    for (std::uint32_t id = 0; id < catalog.genreCount(); ++id) {
+      hot.putString(catalog.genreName(id));
+    }
+
+    // Both counters, so ids and sequences of removed games stay retired
+    std::unordered_map < const Game * , std::uint32_t > gameIndex;
+    gameIndex.reserve(games.size());
+    hot.put < std::uint64_t > (nextGameNumber);
+    hot.put < std::uint64_t > (catalog.sequencesIssued());
+    hot.put < std::uint64_t > (games.size());
+    for (const auto * game: games) {
+      gameIndex.emplace(game, static_cast < std::uint32_t > (gameIndex.size()));
+      hot.put < std::uint64_t > (game -> getSequence());
+      hot.putString(game -> getGameId());
+      hot.putString(game -> getTitle());
+      hot.putString(game -> getDeveloperName());
+      hot.put < double > (pricing.basePrice(game -> getCatalogSlot()));
+      hot.put < std::uint32_t > (catalog.genreId(game -> getCatalogSlot()));
+      hot.put < std::uint8_t > (static_cast < std::uint8_t > (game -> getRating()));
+      hot.put < std::int64_t > (game -> getReleaseDate());
+      hot.put < std::uint32_t > (static_cast < std::uint32_t > (game -> getDescription().size()));
+      hot.put < std::uint32_t > (static_cast < std::uint32_t > (game -> getReviews().size()));
+      for (const auto & review: game -> getReviews()) {
+        hot.put < std::uint32_t > (static_cast < std::uint32_t > (review.first.size()));
+        hot.put < std::uint8_t > (static_cast < std::uint8_t > (review.second));
+      }
+    }
+
+    // Handles of removed games are dropped here
+    std::vector < std::uint32_t > listed;
+    auto putGameList = [ & ](const GameSet & list) {
+      listed.clear();
+      for (GameHandle handle: list) {
+        if (const Game * game = catalog.resolve(handle)) listed.push_back(gameIndex.at(game));
+      }
+      hot.put < std::uint32_t > (static_cast < std::uint32_t > (listed.size()));
+      for (std::uint32_t index: listed) hot.put < std::uint32_t > (index);
+    };
+    hot.put < std::uint64_t > (users.size());
+    for (const auto * user: users) {
+      hot.putString(user -> userId);
+      hot.putString(user -> username);
+      hot.putString(user -> email);
+      hot.putString(user -> credential.serialize());
+      hot.put < std::uint8_t > (static_cast < std::uint8_t > (user -> role));
+      putGameList(user -> library);
+      putGameList(user -> wishlist);
+    }
+
+    hot.put < std::uint64_t > (administrators.size());
+    for (const auto * admin: administrators) {
+      hot.putString(admin -> getAdminId());
+      hot.putString(admin -> getAdminUsername());
+      hot.putString(admin -> getCredential().serialize());
+    }
+
+    // Live posts only, followed by an end marker; removed ids stay retired
+    // through the next id
+    hot.put < std::uint64_t > (feed.nextId());
+    feed.forEach([ & ](const Post & post) {
+      hot.put < std::uint64_t > (post.postId);
+      hot.putString(post.userId);
+      hot.putString(post.content);
+      hot.put < std::int64_t > (post.timestamp);
+    });
+    hot.put < std::uint64_t > (0);
+
+    // Sale rules still scheduled or in effect; expired ones are gone
+    hot.put < std::uint64_t > (pricing.nextId());
+    hot.put < std::uint64_t > (pricing.ruleCount());
+    pricing.forEachRule([ & ](const PricingEngine::Rule & rule) {
+      hot.put < std::uint64_t > (rule.id);
+      hot.put < std::uint32_t > (gameIndex.at(catalog.owner(rule.slot)));
+      hot.put < std::uint16_t > (rule.discountBasisPoints);
+      hot.put < std::int64_t > (static_cast < std::int64_t > (rule.start));
+      hot.put < std::int64_t > (static_cast < std::int64_t > (rule.end));
+    });
+
+    // Sales: buyer and developer names in key order, then every row. Rows of
+    // removed games still count toward their developer and day.
+    for (const auto * names: { & sales.buyerNames(), & sales.developerNames()}) {
+      hot.put < std::uint32_t > (static_cast < std::uint32_t > (names -> size()));
+      for (std::string_view name: * names) hot.putString(name);
+    }
+    hot.put < std::uint64_t > (sales.size());
+    sales.forEach([ & ](const SalesLedger::Row & row) {
+      const Game * game = catalog.resolve(row.game);
+      hot.put < std::uint32_t > (row.buyer);
+      hot.put < std::uint32_t > (game ? gameIndex.at(game) : GameHandle::NoSlot);
+      hot.put < std::uint32_t > (row.developer);
+      hot.put < std::uint32_t > (row.sale.priceCents);
+      hot.put < std::uint16_t > (row.sale.discountBasisPoints);
+      hot.put < std::int64_t > (static_cast < std::int64_t > (row.sale.timestamp));
+    });
+    auto hotSection = hot.finish();
+
+    std::memcpy(header.magic, SnapshotMagic, sizeof(header.magic));
+    header.version = SnapshotVersion;
+    header.byteOrder = SnapshotByteOrder;
+    header.coldBytes = coldSection.first;
+    header.coldChecksum = coldSection.second;
+    header.hotBytes = hotSection.first;
+    header.hotChecksum = hotSection.second;
+    header.logSequence = logSequence;
+    out.seekp(0);
+    out.write(reinterpret_cast < const char * > ( & header), sizeof(header));
+    out.close();
+    if (!out) {
+      throw std::runtime_error("Failed writing " + tempPath);
+    }
+    // The snapshot must be on disk before the rename is, and the rename
+    // before compaction empties the log that it replaces
+    syncToDisk(tempPath);
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+      throw std::runtime_error("Cannot replace " + path);
+    }
+    syncParentDirectory(path);
+  }
+
+  // Rebuilds an empty marketplace from a snapshot. The hot section is always
+  // verified; verifying the cold section reads every description and review,
+  // so it is optional.
+  void loadSnapshot(const std::string & path, bool verifyColdSection = false) {
+    if (!users.empty() || !games.empty() || !administrators.empty() || feed.nextId() != 1 || sales.size() != 0) {
+      throw std::logic_error("Snapshots can only be loaded into an empty marketplace");
+    }
+    auto mapping = std::make_unique < MappedFile > (path);
+    SnapshotHeader header;
+    if (mapping -> size() < sizeof(header)) {
+      throw std::runtime_error("Snapshot is truncated");
+    }
+    std::memcpy( & header, mapping -> data(), sizeof(header));
+    if (std::memcmp(header.magic, SnapshotMagic, sizeof(header.magic)) != 0) {
+      throw std::runtime_error("Not a marketplace snapshot");
+    }
+    if (header.version != SnapshotVersion || header.byteOrder != SnapshotByteOrder) {
+      throw std::runtime_error("Unsupported snapshot version or byte order");
+    }
+    if (mapping -> size() != sizeof(header) + header.coldBytes + header.hotBytes) {
+      throw std::runtime_error("Snapshot is truncated");
+    }
+    const unsigned char * coldBegin = mapping -> data() + sizeof(header);
+    const unsigned char * hotBegin = coldBegin + header.coldBytes;
+    mapping -> advise(sizeof(header) + header.coldBytes, header.hotBytes, MADV_SEQUENTIAL);
+    if (sectionChecksum(hotBegin, header.hotBytes) != header.hotChecksum ||
+      (verifyColdSection && sectionChecksum(coldBegin, header.coldBytes) != header.coldChecksum)) {
+      throw std::runtime_error("Snapshot checksum mismatch");
+    }
+
+    SnapshotReader hot(hotBegin, header.hotBytes);
+    SnapshotReader cold(coldBegin, header.coldBytes);
+
+    std::vector < std::string_view > genres(hot.get < std::uint32_t > ());
+    for (auto & genre: genres) genre = hot.getString();
+
+    nextGameNumber = hot.get < std::uint64_t > ();
+    std::uint64_t nextSequence = hot.get < std::uint64_t > ();
+    std::vector < Game * > restored(hot.get < std::uint64_t > ());
+    games.reserve(restored.size());
+    catalog.reserve(restored.size());
+    lookup.reserve(restored.size());
+    std::vector < std::pair < std::string_view, int >> reviewBatch;
+    for (auto & game: restored) {
+      std::uint64_t sequence = hot.get < std::uint64_t > ();
+      std::string id(hot.getString());
+      std::string_view title = hot.getString();
+      std::string_view developer = hot.getString();
+      double price = hot.get < double > ();
+      std::uint32_t genreId = hot.get < std::uint32_t > ();
+      GameRating rating = static_cast < GameRating > (hot.get < std::uint8_t > ());
+      std::time_t releaseDate = static_cast < std::time_t > (hot.get < std::int64_t > ());
+      std::string_view description = cold.take(hot.get < std::uint32_t > ());
+      if (genreId >= genres.size()) {
+        throw std::runtime_error("Snapshot references an unknown genre");
+      }
+      game = gamePool.create(catalog, textArena, id, title, description, price,
+        genres[genreId], rating, developer, releaseDate);
+      catalog.restoreSequence(game -> getCatalogSlot(), sequence);
+      addToCatalog(game);
+
+      reviewBatch.resize(hot.get < std::uint32_t > ());
+      for (auto & review: reviewBatch) {
+        std::uint32_t length = hot.get < std::uint32_t > ();
+        review.second = hot.get < std::uint8_t > ();
+        review.first = cold.take(length);
+      }
+      game -> adoptReviews(reviewBatch);
+    }
+    catalog.reserveSequencesThrough(nextSequence);
+
+    auto gameAt = [ & ](std::uint32_t index) {
+      if (index >= restored.size()) {
+        throw std::runtime_error("Snapshot references an unknown game");
+      }
+      return restored[index];
+    };
+    users.resize(hot.get < std::uint64_t > ());
+    usersById.reserve(users.size());
+    usersByName.reserve(users.size());
+    for (auto & user: users) {
+      std::string id(hot.getString());
+      std::string username(hot.getString());
+      std::string email(hot.getString());
+      PasswordHash credential = PasswordHash::deserialize(hot.getString());
+      UserRole role = static_cast < UserRole > (hot.get < std::uint8_t > ());
+      user = userPool.create(id, username, email, credential, role);
+      usersById[user -> getUserId()] = user;
+      usersByName[user -> getUsername()] = user;
+      for (std::uint32_t n = hot.get < std::uint32_t > (); n > 0; --n) {
+        user -> addToLibrary(gameAt(hot.get < std::uint32_t > ()));
+      }
+      for (std::uint32_t n = hot.get < std::uint32_t > (); n > 0; --n) {
+        user -> addToWishlist(gameAt(hot.get < std::uint32_t > ()));
+      }
+    }
+
+    for (std::uint64_t n = hot.get < std::uint64_t > (); n > 0; --n) {
+      std::string id(hot.getString());
+      std::string username(hot.getString());
+      PasswordHash credential = PasswordHash::deserialize(hot.getString());
+      addAdministrator(adminPool.create(id, username, credential));
+    }
+
+    std::uint64_t nextPostId = hot.get < std::uint64_t > ();
+    for (std::uint64_t id = hot.get < std::uint64_t > (); id != 0; id = hot.get < std::uint64_t > ()) {
+      std::string_view userId = hot.getString();
+      std::string_view content = hot.getString();
+      feed.restore(id, userId, content, static_cast < std::time_t > (hot.get < std::int64_t > ()));
+    }
+    feed.reserveThrough(nextPostId);
+
+    std::uint64_t nextRuleId = hot.get < std::uint64_t > ();
+    for (std::uint64_t n = hot.get < std::uint64_t > (); n > 0; --n) {
+      PricingEngine::Rule rule;
+      rule.id = hot.get < std::uint64_t > ();
+      rule.slot = gameAt(hot.get < std::uint32_t > ()) -> getCatalogSlot();
+      rule.discountBasisPoints = hot.get < std::uint16_t > ();
+      rule.start = static_cast < std::time_t > (hot.get < std::int64_t > ());
+      rule.end = static_cast < std::time_t > (hot.get < std::int64_t > ());
+      pricing.restoreRule(rule);
+    }
+    pricing.reserveThrough(nextRuleId);
+
+    for (std::uint32_t n = hot.get < std::uint32_t > (); n > 0; --n) sales.buyerKey(hot.getString());
+    for (std::uint32_t n = hot.get < std::uint32_t > (); n > 0; --n) sales.developerKey(hot.getString());
+    for (std::uint64_t n = hot.get < std::uint64_t > (); n > 0; --n) {
+      SalesLedger::Row row;
+      row.buyer = hot.get < std::uint32_t > ();
+      std::uint32_t index = hot.get < std::uint32_t > ();
+      if (index != GameHandle::NoSlot) row.game = gameAt(index) -> getHandle();
+      row.developer = hot.get < std::uint32_t > ();
+      row.sale.priceCents = hot.get < std::uint32_t > ();
+      row.sale.discountBasisPoints = hot.get < std::uint16_t > ();
+      row.sale.timestamp = static_cast < std::time_t > (hot.get < std::int64_t > ());
+      sales.record(row);
+    }
+
+    snapshotSequence = header.logSequence;
+
+    // Cold pages are read on demand from here on
+    mapping -> advise(sizeof(header), header.coldBytes, MADV_RANDOM);
+    snapshotMappings.push_back(std::move(mapping));
+  }
+
+  // Writes everything a snapshot keeps as text, one item per line and in a
+  // fixed order, so two marketplaces can be compared line by line. Prices
+  // are written exactly (hexfloat); credentials as hex.
+  void writeStateDump(std::ostream & out) const {
+    auto hexBytes = [ & ](std::string_view bytes) {
+      static const char digits[] = "0123456789abcdef";
+      for (unsigned char c: bytes) out << digits[c >> 4] << digits[c & 15];
+    };
+    auto gameList = [ & ](const char * label, const GameSet & list) {
+      out << label;
+      for (GameHandle handle: list) {
+        if (const Game * game = catalog.resolve(handle)) out << ' ' << game -> getGameId();
+      }
+      out << '\n';
+    };
+    out << std::hexfloat;
+    out << "games " << games.size() << " | next id " << nextGameNumber << " | next sequence "
+      << catalog.sequencesIssued() << '\n';
+    for (const auto * game: games) {
+      out << "game " << game -> getSequence() << " " << game -> getGameId() << " | " << game -> getTitle() << " | " << game -> getDeveloperName()
+        << " | " << pricing.basePrice(game -> getCatalogSlot()) << " | " << game -> getGenre() << " | "
+        << static_cast < int > (game -> getRating()) << " | " << game -> getReleaseDate() << " | "
+        << game -> getDescription() << '\n';
+      for (const auto & review: game -> getReviews()) out << "  review " << review.second << " " << review.first << '\n';
+    }
+    out << "users " << users.size() << '\n';
+    for (const auto * user: users) {
+      out << "user " << user -> userId << " | " << user -> username << " | " << user -> email << " | "
+        << static_cast < int > (user -> role) << " | ";
+      hexBytes(user -> credential.serialize());
+      out << '\n';
+      gameList("  library", user -> library);
+      gameList("  wishlist", user -> wishlist);
+    }
+    out << "administrators " << administrators.size() << '\n';
+    for (const auto * admin: administrators) {
+      out << "admin " << admin -> getAdminId() << " | " << admin -> getAdminUsername() << " | ";
+      hexBytes(admin -> getCredential().serialize());
+      out << '\n';
+    }
+    out << "next post " << feed.nextId() << '\n';
+    feed.forEach([ & ](const Post & post) {
+      out << "post " << post.postId << " | " << post.userId << " | " << post.timestamp << " | " << post.content << '\n';
+    });
+    std::vector < PricingEngine::Rule > rules;
+    pricing.forEachRule([ & ](const PricingEngine::Rule & rule) { rules.push_back(rule); });
+    std::sort(rules.begin(), rules.end(), [](const auto & a, const auto & b) { return a.id < b.id; });
+    out << "next rule " << pricing.nextId() << '\n';
+    for (const auto & rule: rules) {
+      out << "rule " << rule.id << " " << catalog.owner(rule.slot) -> getGameId() << " " << rule.discountBasisPoints
+        << " " << rule.start << " " << rule.end << '\n';
+    }
+    out << "sales " << sales.size() << '\n';
+    sales.forEach([ & ](const SalesLedger::Row & row) {
+      const Game * game = catalog.resolve(row.game);
+      out << "sale " << sales.buyerNames()[row.buyer] << " | " << (game ? game -> getGameId() : "-") << " | "
+        << sales.developerNames()[row.developer] << " | " << row.sale.priceCents << " " << row.sale.discountBasisPoints
+        << " " << row.sale.timestamp << '\n';
+    });
+    out << std::defaultfloat;
+  }
+};
+
+// ---------------------------------------------------------------------------
+// Request API
+//
+// Every user-facing operation as a typed request/response pair, independent of
+// how it is driven. A Session carries who is logged in; responses carry copies
+// of the data, so they stay valid however long the caller keeps them.
+// ---------------------------------------------------------------------------
+
+enum class ApiStatus {
+  OK,
+  UNAUTHENTICATED, // the session is not logged in
+  FORBIDDEN, // logged in with a role that may not do this
+  NOT_FOUND,
+  CONFLICT, // the request would change nothing (already owned, ...)
+  INVALID,
+  BUSY // too many logins in progress; try again
+};
+
+struct ApiResponse {
+  ApiStatus status = ApiStatus::OK;
+  std::string error;
+
+  bool ok() const {
+    return status == ApiStatus::OK;
+  }
+};
+
+class Session {
+  private:
+    User * user = nullptr;
+    Administrator * admin = nullptr;
+    friend class MarketplaceApi;
+
+  public:
+    bool loggedIn() const {
+      return user != nullptr || admin != nullptr;
+    }
+    UserRole role() const {
+      return admin ? UserRole::ADMINISTRATOR : user -> getRole();
+    }
+    std::string username() const {
+      return std::string(admin ? admin -> getAdminUsername() : user -> getUsername());
+    }
+};
+
+struct GameSummary {
+  std::string gameId;
+  std::string title;
+  std::string genre;
+  double price = 0.0;
+  GameRating rating = GameRating::E;
+};
+
+struct GameDetails: GameSummary {
+  std::string description;
+  std::time_t releaseDate = 0;
+  // Relative to the requesting session; false when logged out
+  bool owned = false;
+  bool wishlisted = false;
+};
+
+struct LoginRequest {
+  UserRole role;
+  std::string username;
+  std::string password;
+};
+
+struct GameRequest {
+  std::string title;
+};
+
+struct ReviewRequest {
+  std::string title;
+  std::string text;
+  int stars;
+};
+
+struct PostRequest {
+  std::string content;
+};
+
+struct FeedRequest {
+  std::string author; // empty for everyone's posts
+  size_t pageSize = 20;
+  std::string cursor; // nextCursor of the previous page
+};
+
+struct RemovePostRequest {
+  std::uint64_t postId;
+};
+
+struct SearchRequest {
+  std::string title;
+  double minPrice = 0.0;
+  double maxPrice = std::numeric_limits < double > ::max();
+  std::string category;
+  GameRating rating = GameRating::E; // E matches any rating
+  std::time_t minReleaseDate = 0;
+  std::time_t maxReleaseDate = std::numeric_limits < std::time_t > ::max();
+  SearchOrder order = SearchOrder::CATALOG;
+  size_t pageSize = 0; // 0 returns every match in catalog order
+  std::string cursor; // nextCursor of the previous page
+};
+
+struct PageRequest {
+  size_t pageSize = 20;
+  std::string cursor;
+};
+
+struct PriceChangeRequest {
+  std::string title;
+  double newPrice;
+};
+
+struct SaleRequest {
+  std::string title;
+  double discountPercentage;
+  std::time_t start = 0; // 0 = now
+  int days = 7;
+};
+
+struct GameListResponse: ApiResponse {
+  std::vector < GameSummary > games;
+  std::string nextCursor; // set when the list was paged and more follow
+};
+
+struct GameDetailsResponse: ApiResponse {
+  GameDetails game;
+};
+
+struct ReviewsResponse: ApiResponse {
+  std::vector < std::pair < std::string, int >> reviews;
+  double averageRating = 0.0;
+  std::array < int, 5 > histogram {};
+};
+
+struct FeedResponse: ApiResponse {
+  struct Entry {
+    std::uint64_t id;
+    std::string author;
+    std::string content;
+    std::time_t timestamp;
+  };
+  std::vector < Entry > posts; // newest first
+  std::string nextCursor; // set when older posts follow
+};
+
+struct SalesResponse: ApiResponse {
+  struct Row {
+    std::string name;
+    std::uint64_t units;
+    double revenue;
+  };
+  struct Day {
+    std::time_t start; // midnight UTC
+    std::uint64_t units;
+    double revenue;
+  };
+  std::vector < Row > rows; // per game for a developer, per developer for a manager
+  std::vector < Day > days; // managers only: the last week's days with sales, oldest first
+};
+
+struct AllocationResponse: ApiResponse {
+  GameMarketplace::AllocationReport report {};
+};
+
+class MarketplaceApi {
+  private:
+    GameMarketplace & marketplace;
+
+    static ApiResponse failure(ApiStatus status, const std::string & error) {
+      ApiResponse response;
+      response.status = status;
+      response.error = error;
+      return response;
+    }
+
+    template < typename Response >
+    static Response fail(ApiStatus status, const std::string & error) {
+      Response response;
+      static_cast < ApiResponse & > (response) = failure(status, error);
+      return response;
+    }
+
+    static GameSummary summarize(const Game & game) {
+      return {
+        std::string(game.getGameId()), std::string(game.getTitle()), std::string(game.getGenre()),
+          game.getPrice(), game.getRating()
+      };
+    }
+
+    GameListResponse listGames(const std::vector < Game * > & games) const {
+      GameListResponse response;
+      response.games.reserve(games.size());
+      for (const auto * game: games) {
+        response.games.push_back(marketplace.withGame(game, summarize));
+      }
+      return response;
+    }
+
+    // Resolves the request's title and checks the session has a customer-side account
+    Game * accountGame(const Session & session, const std::string & title, ApiResponse & response) const {
+      if (!session.user) {
+        response = failure(ApiStatus::UNAUTHENTICATED, "You need to be logged in.");
+        return nullptr;
+      }
+      Game * game = marketplace.findGameByTitle(title);
+      if (!game) {
+        response = failure(ApiStatus::NOT_FOUND, "Game not found!");
+      }
+      return game;
+    }
+
+  public:
+    explicit MarketplaceApi(GameMarketplace & marketplace): marketplace(marketplace) {}
+
+    ApiResponse login(Session & session, const LoginRequest & request) {
+      if (session.loggedIn()) {
+        return failure(ApiStatus::CONFLICT, "Already logged in.");
+      }
+      try {
+        if (request.role == UserRole::ADMINISTRATOR) {
+          session.admin = marketplace.authenticateAdmin(request.username, request.password);
+        } else {
+          session.user = marketplace.authenticate(request.username, request.role, request.password);
+        }
+      } catch (const HashingPool::Busy & e) {
+        return failure(ApiStatus::BUSY, e.what());
+      }
+      if (!session.loggedIn()) {
+        return failure(ApiStatus::UNAUTHENTICATED, "Invalid username or password.");
+      }
+      return ApiResponse();
+    }
+
+    ApiResponse logout(Session & session) {
+      session.user = nullptr;
+      session.admin = nullptr;
+      return ApiResponse();
+    }
+
+    std::string loginHint(UserRole role) const {
+      return marketplace.sampleUsername(role);
+    }
+
+    // The cursor is the id of the last post on the previous page
+    FeedResponse communityFeed(const FeedRequest & request = FeedRequest()) const {
+      std::uint64_t before = 0;
+      if (!request.cursor.empty()) {
+        char * end = nullptr;
+        before = std::strtoull(request.cursor.c_str(), & end, 10);
+        if ( * end != '\0' || before == 0) {
+          return fail < FeedResponse > (ApiStatus::INVALID, "Invalid page cursor");
+        }
+      }
+      if (request.pageSize == 0) {
+        return fail < FeedResponse > (ApiStatus::INVALID, "Page size must be positive");
+      }
+      CommunityFeed::Page page = marketplace.communityFeed(request.pageSize, before, request.author);
+      FeedResponse response;
+      response.posts.reserve(page.posts.size());
+      for (auto & post: page.posts) {
+        response.posts.push_back({
+          post.postId, std::move(post.userId), std::move(post.content), post.timestamp
+        });
+      }
+      if (page.nextBefore != 0) response.nextCursor = std::to_string(page.nextBefore);
+      return response;
+    }
+
+    ApiResponse writePost(const Session & session, const PostRequest & request) {
+      if (!session.user) {
+        return failure(ApiStatus::UNAUTHENTICATED, "You need to be logged in to write a post.");
+      }
+      marketplace.writePost(std::string(session.user -> getUsername()), request.content);
+      return ApiResponse();
+    }
+
+    // Authors can remove their own posts, managers and administrators any post
+    ApiResponse removePost(const Session & session, const RemovePostRequest & request) {
+      if (!session.loggedIn()) {
+        return failure(ApiStatus::UNAUTHENTICATED, "You need to be logged in.");
+      }
+      Post post;
+      if (!marketplace.findPost(request.postId, post)) {
+        return failure(ApiStatus::NOT_FOUND, "Post not found.");
+      }
+      if (post.userId != session.username() && session.role() != UserRole::MANAGER &&
+        session.role() != UserRole::ADMINISTRATOR) {
+        return failure(ApiStatus::FORBIDDEN, "You can only remove your own posts.");
+      }
+      if (!marketplace.removePost(request.postId)) {
+        return failure(ApiStatus::NOT_FOUND, "Post not found.");
+      }
+      return ApiResponse();
+    }
+
+    GameListResponse allGames(const PageRequest & request) const {
+      SearchRequest search;
+      search.pageSize = request.pageSize;
+      search.cursor = request.cursor;
+      return this -> search(search);
+    }
+
+    // The sale list is short and in catalog order, but sales start and end
+    // between pages, so its cursor is the catalog slot to continue from
+    GameListResponse gamesOnSale(const PageRequest & request) const {
+      std::vector < Game * > sale = marketplace.saleGames();
+      std::uint64_t from = 0;
+      if (!request.cursor.empty()) {
+        char * end = nullptr;
+        from = std::strtoull(request.cursor.c_str(), & end, 10);
+        if ( * end != '\0') {
+          return fail < GameListResponse > (ApiStatus::INVALID, "Invalid page cursor");
+        }
+      }
+      auto first = std::find_if(sale.begin(), sale.end(), [ & ](const Game * game) {
+        return game -> getCatalogSlot() >= from;
+      });
+      size_t remaining = static_cast < size_t > (sale.end() - first);
+      size_t count = request.pageSize == 0 ? remaining : std::min(request.pageSize, remaining);
+      GameListResponse response = listGames(std::vector < Game * > (first, first + count));
+      if (count < remaining) response.nextCursor = std::to_string(first[count - 1] -> getCatalogSlot() + 1);
+      return response;
+    }
+
+    GameListResponse search(const SearchRequest & request) const {
+      if (request.pageSize == 0) {
+        return listGames(marketplace.searchGames(request.title, request.minPrice, request.maxPrice,
+          request.category, request.rating, request.minReleaseDate, request.maxReleaseDate));
+      }
+      SearchPage page;
+      try {
+        page = marketplace.searchGamesPage(request.title, request.minPrice, request.maxPrice,
+          request.category, request.rating, request.minReleaseDate, request.maxReleaseDate,
+          request.order, request.pageSize, request.cursor);
+      } catch (const std::invalid_argument & e) {
+        return fail < GameListResponse > (ApiStatus::INVALID, e.what());
+      }
+      GameListResponse response = listGames(page.games);
+      response.nextCursor = std::move(page.nextCursor);
+      return response;
+    }
+
+    GameDetailsResponse gameDetails(const Session & session, const GameRequest & request) const {
+      Game * game = marketplace.findGameByTitle(request.title);
+      if (!game) {
+        return fail < GameDetailsResponse > (ApiStatus::NOT_FOUND, "Game not found!");
+      }
+      GameDetailsResponse response;
+      response.game = marketplace.withGame(game, [](const Game & found) {
+        GameDetails details;
+        static_cast < GameSummary & > (details) = summarize(found);
+        details.description = std::string(found.getDescription());
+        details.releaseDate = found.getReleaseDate();
+        return details;
+      });
+      if (session.user) {
+        std::tie(response.game.owned, response.game.wishlisted) = marketplace.withUser(session.user, [ & ](const User & user) {
+          return std::make_pair(user.owns(game -> getHandle()), user.wishlisted(game -> getHandle()));
+        });
+      }
+      return response;
+    }
+
+    ReviewsResponse reviews(const GameRequest & request) const {
+      Game * game = marketplace.findGameByTitle(request.title);
+      if (!game) {
+        return fail < ReviewsResponse > (ApiStatus::NOT_FOUND, "Game not found!");
+      }
+      return marketplace.withGame(game, [](const Game & found) {
+        ReviewsResponse response;
+        response.reviews.reserve(found.getReviews().size());
+        for (const auto & review: found.getReviews()) {
+          response.reviews.emplace_back(std::string(review.first), review.second);
+        }
+        response.averageRating = found.getAverageRating();
+        response.histogram = found.getRatingHistogram();
+        return response;
+      });
+    }
+
+    GameListResponse library(const Session & session) const {
+      if (!session.user) {
+        return fail < GameListResponse > (ApiStatus::UNAUTHENTICATED, "You need to log in to view your library.");
+      }
+      return listGames(marketplace.libraryOf(session.user));
+    }
+
+    GameListResponse wishlist(const Session & session) const {
+      if (!session.user) {
+        return fail < GameListResponse > (ApiStatus::UNAUTHENTICATED, "You need to log in to view your wishlist.");
+      }
+      return listGames(marketplace.wishlistOf(session.user));
+    }
+
+    ApiResponse buy(const Session & session, const GameRequest & request) {
+      ApiResponse response;
+      Game * game = accountGame(session, request.title, response);
+      if (game && !marketplace.purchaseGame(session.user, game)) {
+        response = failure(ApiStatus::CONFLICT, "You already own this game in your library.");
+      }
+      return response;
+    }
+
+    ApiResponse removeFromLibrary(const Session & session, const GameRequest & request) {
+      ApiResponse response;
+      Game * game = accountGame(session, request.title, response);
+      if (game && !marketplace.removeFromLibrary(session.user, game)) {
+        response = failure(ApiStatus::NOT_FOUND, "Game not found in your library!");
+      }
+      return response;
+    }
+
+    ApiResponse addToWishlist(const Session & session, const GameRequest & request) {
+      ApiResponse response;
+      Game * game = accountGame(session, request.title, response);
+      if (game && !marketplace.addToWishlist(session.user, game)) {
+        response = failure(ApiStatus::CONFLICT, "You already have this game in your wish list.");
+      }
+      return response;
+    }
+
+    ApiResponse removeFromWishlist(const Session & session, const GameRequest & request) {
+      ApiResponse response;
+      Game * game = accountGame(session, request.title, response);
+      if (game && !marketplace.removeFromWishlist(session.user, game)) {
+        response = failure(ApiStatus::NOT_FOUND, "Game not found in your wishlist!");
+      }
+      return response;
+    }
+
+    ApiResponse review(const Session & session, const ReviewRequest & request) {
+      ApiResponse response;
+      Game * game = accountGame(session, request.title, response);
+      if (!game) return response;
+      try {
+        marketplace.submitReview(session.user, game, request.text, request.stars);
+      } catch (const std::invalid_argument & e) {
+        response = failure(ApiStatus::INVALID, e.what());
+      } catch (const std::runtime_error & e) {
+        response = failure(ApiStatus::FORBIDDEN, e.what());
+      }
+      return response;
+    }
+
+    // Developers only, and only for their own games
+    GameListResponse developerGames(const Session & session) const {
+      if (!session.user || session.user -> getRole() != UserRole::DEVELOPER) {
+        return fail < GameListResponse > (ApiStatus::FORBIDDEN, "Developers only.");
+      }
+      return listGames(marketplace.gamesByDeveloper(session.user -> getUsername()));
+    }
+
+    ApiResponse changePrice(const Session & session, const PriceChangeRequest & request) {
+      if (!session.user || session.user -> getRole() != UserRole::DEVELOPER) {
+        return failure(ApiStatus::FORBIDDEN, "Developers only.");
+      }
+      if (!std::isfinite(request.newPrice) || request.newPrice < 0) {
+        return failure(ApiStatus::INVALID, "Price must be a non-negative amount.");
+      }
+      for (auto * game: marketplace.gamesByDeveloper(session.user -> getUsername())) {
+        if (game -> getTitle() == request.title) {
+          marketplace.changePrice(game, request.newPrice);
+          return ApiResponse();
+        }
+      }
+      return failure(ApiStatus::NOT_FOUND, "Game not found or you don't have permission to change its price.");
+    }
+
+    ApiResponse setWeeklySale(const Session & session, const SaleRequest & request) {
+      if (!session.user || session.user -> getRole() != UserRole::MANAGER) {
+        return failure(ApiStatus::FORBIDDEN, "Managers only.");
+      }
+      Game * game = marketplace.findGameByTitle(request.title);
+      if (!game) {
+        return failure(ApiStatus::NOT_FOUND, "Game not found.");
+      }
+      if (request.days <= 0) {
+        return failure(ApiStatus::INVALID, "A sale must last at least a day.");
+      }
+      std::time_t start = request.start == 0 ? std::time(nullptr) : request.start;
+      try {
+        marketplace.scheduleSale(game, request.discountPercentage, start, start + static_cast < std::time_t > (request.days) * 86400);
+      } catch (const std::invalid_argument & e) {
+        return failure(ApiStatus::INVALID, e.what());
+      }
+      return ApiResponse();
+    }
+
+    // Sales per game for a developer; per developer, plus the last week day
+    // by day, for a manager. Read from running totals, never from the rows.
+    SalesResponse salesHistory(const Session & session) const {
+      if (!session.user || (session.user -> getRole() != UserRole::DEVELOPER && session.user -> getRole() != UserRole::MANAGER)) {
+        return fail < SalesResponse > (ApiStatus::FORBIDDEN, "Developers and managers only.");
+      }
+      SalesResponse response;
+      if (session.user -> getRole() == UserRole::DEVELOPER) {
+        for (const auto & game: marketplace.gameSales(session.user -> getUsername())) {
+          response.rows.push_back({game.first, game.second.units, game.second.revenueCents / 100.0});
+        }
+      } else {
+        for (const auto & developer: marketplace.salesByDeveloper()) {
+          response.rows.push_back({developer.first, developer.second.units, developer.second.revenueCents / 100.0});
+        }
+        std::time_t now = std::time(nullptr);
+        for (const auto & day: marketplace.dailySales(now - 6 * SalesLedger::SecondsPerDay, now)) {
+          response.days.push_back({day.first, day.second.units, day.second.revenueCents / 100.0});
+        }
+      }
+      return response;
+    }
+
+    AllocationResponse allocationStats(const Session & session) const {
+      if (!session.admin) {
+        return fail < AllocationResponse > (ApiStatus::FORBIDDEN, "Administrators only.");
+      }
+      AllocationResponse response;
+      response.report = marketplace.allocationStats();
+      return response;
+    }
+};
+
+// Interactive menus on std::cin/std::cout; every action goes through the API
+class TextClient {
+  private:
+    MarketplaceApi & api;
+    Session session;
+    std::string input;
+
+    static std::string ratingName(GameRating rating) {
+      switch (rating) {
+      case GameRating::E:
+        return "Everyone";
+      case GameRating::E10:
+        return "Everyone 10+";
+      case GameRating::T:
+        return "Teen";
+      case GameRating::M:
+        return "Mature";
+      case GameRating::AO:
+        return "Adults Only";
+      default:
+        return "Unknown";
+      }
+    }
+
+    static void printDetails(const GameDetails & game) {
+      std::cout << "\nGame Details:\n";
+      std::cout << "Title: " << game.title << std::endl;
+      std::cout << "Genre: " << game.genre << std::endl;
+      std::cout << "Description: " << game.description << std::endl;
+      std::cout << "Price: $" << game.price << std::endl;
+      std::cout << "Maturity Rating: " << ratingName(game.rating) << std::endl;
+      std::cout << "Release Date: " << game.releaseDate << std::endl;
+    }
+
+    void printReviews(const std::string & title) {
+      std::cout << "\nReviews for " << title << ":\n";
+      ReviewsResponse response = api.reviews({
+        title
+      });
+      if (response.averageRating > 0) {
+        for (const auto & review: response.reviews) {
+          std::cout << review.first << " - " << review.second << " stars\n";
+        }
+        std::cout << "Average rating: " << response.averageRating << " stars\n";
+        for (int stars = 5; stars >= 1; --stars) {
+          std::cout << stars << " stars: " << response.histogram[stars - 1] << "\n";
+        }
+      } else {
+        std::cout << "There are no reviews for this game yet.\n";
+      }
+    }
+
+    // Prompts for text and a 1-5 rating until the review is accepted
+    void promptReview(const std::string & title) {
+      int rating;
+      std::string reviewText;
+      std::cout << "Enter your review (text): ";
+      std::cin.ignore();
+      std::getline(std::cin, reviewText);
+
+      while (true) {
+        std::cout << "Enter rating (1-5 stars): ";
+        if (!(std::cin >> rating)) return;
+        if (rating >= 1 && rating <= 5) {
+          ApiResponse response = api.review(session, {
+            title, reviewText, rating
+          });
+          if (response.ok()) {
+            std::cout << "Review submitted successfully!\n";
+            break;
+          }
+          std::cout << "Error: " << response.error << std::endl;
+        } else {
+          std::cout << "Invalid rating. Please enter a rating between 1 and 5.\n";
+        }
+      }
+    }
+
+    std::string promptTitle(const std::string & prompt) {
+      std::string title;
+      std::cout << prompt;
+      std::cin.ignore(); // Ignore the newline character in buffer
+      std::getline(std::cin, title);
+      return title;
+    }
+
+    // Newest posts first, ten at a time
+    void communityMenu() {
+      FeedRequest page;
+      page.pageSize = 10;
+      while (std::cin) {
+        std::cout << "\nCommunity Tab:\n";
+        FeedResponse feed = api.communityFeed(page);
+        for (const auto & post: feed.posts) {
+          std::cout << post.author << ": " << post.content << std::endl;
+        }
+
+        std::cout << "\nOptions:\n";
+        std::cout << "1. Write a post\n";
+        std::cout << "2. navbar\n";
+        if (!feed.nextCursor.empty()) std::cout << "3. Older posts\n";
+        std::cout << "Enter your choice: ";
+        std::cin >> input;
+
+        if (input == "1") {
+          if (session.loggedIn()) {
+            std::cout << "Post: ";
+            std::cin.ignore(); // Ignore the newline in buffer
+            std::string content;
+            std::getline(std::cin, content);
+            ApiResponse response = api.writePost(session, {
+              content
+            });
+            if (!response.ok()) std::cout << response.error << "\n";
+            page.cursor.clear(); // back to the newest, where the post is
+          } else {
+            std::cout << "You need to be logged in to write a post.\n";
+          }
+        } else if (input == "2") {
+          break; // Go back to navbar
+        } else if (input == "3" && !feed.nextCursor.empty()) {
+          page.cursor = feed.nextCursor;
+        } else {
+          std::cout << "Invalid choice!\n";
+        }
+      }
+    }
+
+    void browseGameMenu(const std::string & title) {
+      while (std::cin) {
+        GameDetailsResponse details = api.gameDetails(session, {
+          title
+        });
+        if (!details.ok()) {
+          std::cout << "Game not found!\n";
+          return;
+        }
+        printDetails(details.game);
+
+        std::cout << "\nOptions:\n";
+        std::cout << "1. Buy Game\n";
+        std::cout << "2. Add to Wishlist\n";
+        std::cout << "3. Review Game\n";
+        std::cout << "4. See Reviews\n";
+        std::cout << "5. back\n";
+        std::cout << "Enter your choice: ";
+        std::cin >> input;
+
+        if (input == "1") { //buy game
+          if (!session.loggedIn()) {
+            std::cout << "You need to be logged in to buy a game.\n";
+          } else if (api.buy(session, {
+              title
+            }).ok()) {
+            std::cout << "Game '" << title << "' purchased and added to your library.\n";
+          } else {
+            std::cout << "You already own this game in your library.\n";
+          }
+        } else if (input == "2") { //add to wishlist
+          if (!session.loggedIn()) {
+            std::cout << "You need to be logged to add a game to the wishlist.\n";
+          } else if (api.addToWishlist(session, {
+              title
+            }).ok()) {
+            std::cout << "Game '" << title << "' added to your wish list.\n";
+          } else {
+            std::cout << "You already have this game in your wish list.\n";
+          }
+        } else if (input == "3") { //review game
+          if (!session.loggedIn()) {
+            std::cout << "You need to be logged in to review a game.\n";
+          } else if (details.game.owned) {
+            promptReview(title);
+          } else {
+            std::cout << "You can only review games in your library.\n";
+          }
+        } else if (input == "4") { //see reviews
+          printReviews(title);
+        } else if (input == "5") { //back
+          break; // Go back to browse games
+        } else {
+          std::cout << "Invalid choice!\n";
+        }
+      }
+    }
+
+    void browseMenu() {
+      while (std::cin) {
+        std::cout << "\nBrowse Games:\n";
+        std::cout << "1. Games on Sale\n";
+        std::cout << "2. View All Games\n";
+        std::cout << "3. navbar\n";
+        std::cout << "Enter your choice: ";
+        std::cin >> input;
+
+        if (input == "1") { // Games on Sale
+          std::cout << "\nGames on Sale:\n";
+          PageRequest page;
+          size_t shown = 0;
+          while (true) {
+            GameListResponse sale = api.gamesOnSale(page);
+            for (const auto & game: sale.games) {
+              std::cout << ++shown << ". " << game.title << " - $" << game.price << std::endl;
+            }
+            if (sale.nextCursor.empty()) break;
+            std::cout << "Show more? (y/n): ";
+            std::cin >> input;
+            if (input != "y") break;
+            page.cursor = sale.nextCursor;
+          }
+        } else if (input == "2") { // View all Games
+          PageRequest page;
+          size_t shown = 0;
+          bool more = true;
+          while (more) {
+            GameListResponse all = api.allGames(page);
+            for (const auto & game: all.games) {
+              std::cout << ++shown << ". " << game.title << std::endl;
+            }
+
+            std::cout << "\nOptions:\n";
+            std::cout << "1. View Game\n";
+            std::cout << "2. back\n";
+            if (!all.nextCursor.empty()) std::cout << "3. Next page\n";
+            std::cout << "Enter your choice: ";
+            std::cin >> input;
+
+            more = false;
+            if (input == "1") {
+              browseGameMenu(promptTitle("Enter the title of the game to view: "));
+            } else if (input == "2") {
+              break; // Go back to browse games menu
+            } else if (input == "3" && !all.nextCursor.empty()) {
+              page.cursor = all.nextCursor;
+              more = true;
+            } else {
+              std::cout << "Invalid choice!\n";
+            }
+          }
+          if (input == "2") break;
+        } else if (input == "3") { //navbar
+          break; // Go back to navbar
+        } else {
+          std::cout << "Invalid choice!\n";
+        }
+      }
+    }
+
+    void searchMenu() {
+      std::cout << "Advanced Search Options:\n";
+      SearchRequest request;
+
+      // Title search
+      std::cout << "Enter game title (or press Enter to skip): ";
+      std::cin.ignore();
+      std::getline(std::cin, request.title);
+
+      // Price range
+      std::cout << "Enter minimum price (0 to skip): ";
+      std::cin >> request.minPrice;
+      std::cout << "Enter maximum price (enter a large number to skip): ";
+      std::cin >> request.maxPrice;
+
+      // Category/Genre
+      std::cout << "Enter game category/genre (or press Enter to skip): ";
+      std::cin.ignore();
+      std::getline(std::cin, request.category);
+
+      // Rating
+      std::cout << "Select game rating:\n";
+      std::cout << "1. E (Everyone)\n";
+      std::cout << "2. E10 (Everyone 10+)\n";
+      std::cout << "3. T (Teen)\n";
+      std::cout << "4. M (Mature)\n";
+      std::cout << "5. AO (Adults Only)\n";
+      std::cout << "0. Skip rating filter\n";
+      std::cout << "Enter your choice: ";
+      int ratingChoice = 0;
+      std::cin >> ratingChoice;
+
+      switch (ratingChoice) {
+      case 2:
+        request.rating = GameRating::E10;
+        break;
+      case 3:
+        request.rating = GameRating::T;
+        break;
+      case 4:
+        request.rating = GameRating::M;
+        break;
+      case 5:
+        request.rating = GameRating::AO;
+        break;
+      default:
+        request.rating = GameRating::E;
+        break;
+      }
+
+      // Release date range
+      std::cout << "Enter earliest release date (Unix timestamp, 0 to skip): ";
+      std::cin >> request.minReleaseDate;
+      std::cout << "Enter latest release date (Unix timestamp, a large number to skip): ";
+      std::cin >> request.maxReleaseDate;
+
+      GameListResponse results = api.search(request);
+      if (!results.games.empty()) {
+        std::cout << "\nSearch results:\n";
+        for (const auto & game: results.games) {
+          std::cout << "- " << game.title <<
+            " (Price: $" << game.price <<
+            ", Genre: " << game.genre <<
+            ", Rating: " << static_cast < int > (game.rating) <<
+            ")\n";
+        }
+      } else {
+        std::cout << "No games found matching your search criteria.\n";
+      }
+    }
+
+    void libraryGameMenu(const std::string & title) {
+      GameDetailsResponse details = api.gameDetails(session, {
+        title
+      });
+      if (!details.ok() || !details.game.owned) {
+        std::cout << "Game not found in your library!\n";
+        return;
+      }
+      while (std::cin) {
+        printDetails(details.game);
+
+        std::cout << "\nOptions:\n";
+        std::cout << "1. Review Game\n";
+        std::cout << "2. See Reviews\n";
+        std::cout << "3. Delete from Library\n";
+        std::cout << "4. back\n";
+        std::cout << "Enter your choice: ";
+        std::cin >> input;
+
+        if (input == "1") { // Review game
+          promptReview(title);
+        } else if (input == "2") { // See reviews
+          printReviews(title);
+        } else if (input == "3") { // Delete from Library
+          if (api.removeFromLibrary(session, {
+              title
+            }).ok()) {
+            std::cout << "Game '" << title << "' removed from your library.\n";
+            break; // Exit the game details menu
+          }
+        } else if (input == "4") { // Back
+          break;
+        } else {
+          std::cout << "Invalid choice!\n";
+        }
+      }
+    }
+
+    void wishlistGameMenu(const std::string & title) {
+      GameDetailsResponse details = api.gameDetails(session, {
+        title
+      });
+      if (!details.ok() || !details.game.wishlisted) {
+        std::cout << "Game not found in your wishlist!\n";
+        return;
+      }
+      while (std::cin) {
+        printDetails(details.game);
+
+        std::cout << "\nOptions:\n";
+        std::cout << "1. Buy Game\n";
+        std::cout << "2. Remove from Wishlist\n";
+        std::cout << "3. back\n";
+        std::cout << "Enter your choice: ";
+        std::cin >> input;
+
+        if (input == "1") { // Buy Game
+          if (api.buy(session, {
+              title
+            }).ok()) {
+            std::cout << "Game '" << title << "' purchased and added to your library.\n";
+            // Remove from wishlist after purchase
+            api.removeFromWishlist(session, {
+              title
+            });
+          } else {
+            std::cout << "You already own this game in your library.\n";
+          }
+        } else if (input == "2") { // Remove from Wishlist
+          if (api.removeFromWishlist(session, {
+              title
+            }).ok()) {
+            std::cout << "Game '" << title << "' removed from your wishlist.\n";
+            break; // Exit the game details menu
+          }
+        } else if (input == "3") { // Back
+          break;
+        } else {
+          std::cout << "Invalid choice!\n";
+        }
+      }
+    }
+
+    void wishlistMenu() {
+      while (std::cin) {
+        std::cout << "\nWishlist:\n";
+        for (const auto & game: api.wishlist(session).games) {
+          std::cout << "- " << game.title << std::endl;
+        }
+
+        std::cout << "\nOptions:\n";
+        std::cout << "1. Add to Wishlist\n";
+        std::cout << "2. View Game \n";
+        std::cout << "3. back\n";
+        std::cout << "Enter your choice: ";
+        std::cin >> input;
+
+        if (input == "1") { //add to wishlist
+          std::string title = promptTitle("Enter the title of the game to add to wishlist: ");
+          ApiResponse response = api.addToWishlist(session, {
+            title
+          });
+          if (response.ok()) {
+            std::cout << title << " added to wishlist.\n";
+          } else {
+            std::cout << response.error << "\n";
+          }
+        } else if (input == "2") { //View Game
+          wishlistGameMenu(promptTitle("Enter the title of the game to view: "));
+        } else if (input == "3") {
+          break; // Go back to Library
+        } else {
+          std::cout << "Invalid choice!\n";
+        }
+      }
+    }
+
+    void libraryMenu() {
+      if (!session.loggedIn()) {
+        std::cout << "You need to log in to view your library.\n";
+        return;
+      }
+      while (std::cin) {
+        std::cout << "\nLibrary:\n";
+        GameListResponse library = api.library(session);
+        if (library.ok()) {
+          for (const auto & game: library.games) {
+            std::cout << "- " << game.title << std::endl;
+          }
+        } else {
+          std::cout << library.error << "\n";
+        }
+
+        std::cout << "\nOptions:\n";
+        std::cout << "1. View Game\n";
+        std::cout << "2. Wishlist\n";
+        std::cout << "3. navbar\n";
+        std::cout << "Enter your choice: ";
+        std::cin >> input;
+
+        if (input == "1") { //view game in library
+          libraryGameMenu(promptTitle("Enter the title of the game to view: "));
+        } else if (input == "2") { //wishlist
+          wishlistMenu();
+        } else if (input == "3") { //navbar
+          break; // Go back to navbar
+        } else { //inval choice
+          std::cout << "Invalid choice!\n";
+        }
+      }
+    }
+
+    void loginMenu() {
+      std::cout << "\nLogin:\n";
+      std::cout << "1. Customer\n";
+      std::cout << "2. Developer\n";
+      std::cout << "3. Manager\n";
+      std::cout << "4. Administrator\n";
+      std::cout << "Enter your role: ";
+      std::cin >> input;
+
+      LoginRequest request;
+      if (input == "1") {
+        request.role = UserRole::CUSTOMER;
+      } else if (input == "2") {
+        request.role = UserRole::DEVELOPER;
+      } else if (input == "3") {
+        request.role = UserRole::MANAGER;
+      } else if (input == "4") {
+        request.role = UserRole::ADMINISTRATOR;
+      } else {
+        std::cout << "Invalid role!\n";
+        return;
+      }
+
+      // Display the first account of the role for testing
+      std::cout << "\nFor testing, use:\n";
+      std::cout << "Username: " << api.loginHint(request.role) << std::endl;
+      std::cout << "Password: password\n\n";
+
+      std::cout << "Enter username: ";
+      std::cin >> request.username;
+      std::cout << "Enter password: ";
+      std::cin >> request.password;
+
+      ApiResponse response = api.login(session, request);
+      if (!response.ok()) {
+        std::cout << response.error << "\n";
+        return;
+      }
+      std::cout << "Login successful!\n";
+
+      // Redirect to the appropriate UI based on role
+      if (request.role == UserRole::DEVELOPER) {
+        developerMenu();
+      } else if (request.role == UserRole::MANAGER) {
+        managerMenu();
+      } else if (request.role == UserRole::ADMINISTRATOR) {
+        adminMenu();
+      }
+    }
+
+    void printSales(const std::string & heading) {
+      std::cout << "\n" << heading << ":\n";
+      SalesResponse sales = api.salesHistory(session);
+      for (const auto & row: sales.rows) {
+        std::cout << row.name << ": " << row.units << " sales, $" << row.revenue << "\n";
+      }
+      if (!sales.days.empty()) {
+        std::cout << "\nLast 7 days:\n";
+      }
+      for (const auto & day: sales.days) {
+        char date[16];
+        std::tm calendar;
+        std::strftime(date, sizeof(date), "%Y-%m-%d", gmtime_r( & day.start, & calendar));
+        std::cout << date << ": " << day.units << " sales, $" << day.revenue << "\n";
+      }
+    }
+
+    void developerMenu() {
+      while (std::cin) {
+        std::cout << "\nDeveloper UI\n";
+        std::cout << "1. Change Game Price\n";
+        std::cout << "2. View Sales History\n";
+        std::cout << "3. List My Games\n";
+        std::cout << "4. Logout\n";
+        std::cout << "Enter your choice: ";
+        std::cin >> input;
+
+        if (input == "1") {
+          std::string title = promptTitle("Enter the title of the game to change price: ");
+          bool owned = false;
+          for (const auto & game: api.developerGames(session).games) {
+            owned = owned || game.title == title;
+          }
+          if (owned) {
+            PriceChangeRequest request {
+              title, 0.0
+            };
+            std::cout << "Enter the new price: $";
+            std::cin >> request.newPrice;
+            ApiResponse response = api.changePrice(session, request);
+            std::cout << (response.ok() ? std::string("Price updated successfully!") : response.error) << "\n";
+          } else {
+            std::cout << "Game not found or you don't have permission to change its price.\n";
+          }
+        } else if (input == "2") {
+          printSales("Sales History");
+        } else if (input == "3") {
+          std::cout << "\nYour Games:\n";
+          for (const auto & game: api.developerGames(session).games) {
+            std::cout << "- " << game.title << std::endl;
+          }
+        } else if (input == "4") {
+          std::cout << "Logging out...\n";
+          break;
+        } else {
+          std::cout << "Invalid choice!\n";
+        }
+      }
+    }
+
+    void managerMenu() {
+      while (std::cin) {
+        std::cout << "\nManager UI\n";
+        std::cout << "1. Set Weekly Sale\n";
+        std::cout << "2. View Developer Sales History\n";
+        std::cout << "3. Logout\n";
+        std::cout << "Enter your choice: ";
+        std::cin >> input;
+
+        if (input == "1") {
+          std::string title = promptTitle("Enter the name of the game to put on sale: ");
+          if (api.gameDetails(session, {
+              title
+            }).ok()) {
+            SaleRequest request {
+              title, 0.0
+            };
+            std::cout << "Enter the discount percentage: ";
+            std::cin >> request.discountPercentage;
+            ApiResponse response = api.setWeeklySale(session, request);
+            std::cout << (response.ok() ? std::string("Weekly sale set successfully!") : response.error) << "\n";
+          } else {
+            std::cout << "Game not found.\n";
+          }
+        } else if (input == "2") {
+          printSales("Developer Sales History");
+        } else if (input == "3") {
+          std::cout << "Logging out...\n";
+          break;
+        } else {
+          std::cout << "Invalid choice!\n";
+        }
+      }
+    }
+
+    void adminMenu() {
+      while (std::cin) {
+        std::cout << "\nAdministrator UI\n";
+        std::cout << "1. Logout\n";
+        std::cout << "2. Allocation Stats\n";
+        std::cout << "Enter your choice: ";
+        std::cin >> input;
+
+        if (input == "1") {
+          std::cout << "Logging out...\n";
+          break; // Exit the admin UI loop
+        } else if (input == "2") {
+          GameMarketplace::AllocationReport report = api.allocationStats(session).report;
+          auto printPool = [](const std::string & name, const auto & stats) {
+            std::cout << name << ": " << stats.live << " live, " << stats.peak << " peak, " <<
+              stats.created << " created, " << stats.slabs << " slabs (" <<
+              stats.bytesReserved << " bytes)\n";
+          };
+          printPool("Users", report.users);
+          printPool("Games", report.games);
+          printPool("Administrators", report.administrators);
+          std::cout << "Posts: " << report.posts.posts << " live in " << report.posts.segments << " segments, " <<
+            report.posts.residentSegments << " in memory (" << report.posts.residentBytes << " bytes), " <<
+            report.posts.spilledBytes << " bytes spilled\n";
+          std::cout << "Sales ledger: " << report.sales.rows << " rows in " << report.sales.chunks << " chunks (" <<
+            report.sales.bytes << " bytes)\n";
+          std::cout << "Text arena: " << report.text.bytesStored << " of " << report.text.bytesReserved <<
+            " bytes used in " << report.text.blocks << " blocks\n";
+        } else {
+          std::cout << "Invalid choice!\n";
+        }
+      }
+    }
+
+  public:
+    explicit TextClient(MarketplaceApi & api): api(api) {}
+
+    void run() {
+      while (std::cin) {
+        std::cout << "\nWelcome to the Game Store!\n";
+
+        if (session.loggedIn()) {
+          std::cout << "Logged in as: " << session.username() << " (";
+          switch (session.role()) {
+          case UserRole::CUSTOMER:
+            std::cout << "Customer";
+            break;
+          case UserRole::DEVELOPER:
+            std::cout << "Developer";
+            break;
+          case UserRole::MANAGER:
+            std::cout << "Manager";
+            break;
+          case UserRole::ADMINISTRATOR:
+            std::cout << "Administrator";
+            break;
+          }
+          std::cout << ")\n";
+        }
+
+        std::cout << "Navigation:\n";
+        std::cout << "1. Community\n";
+        std::cout << "2. Browse Games\n";
+        std::cout << "3. Search Games\n";
+        std::cout << "4. Library\n";
+        std::cout << (session.loggedIn() ? "5. Logout\n" : "5. Login\n");
+        std::cout << "0. Exit\n";
+
+        std::cout << "Enter your choice: ";
+        std::cin >> input;
+
+        if (input == "1") { // Community
+          communityMenu();
+        } else if (input == "2") { // Browse Games
+          browseMenu();
+        } else if (input == "3") { // Search Games
+          searchMenu();
+        } else if (input == "4") { // Library
+          libraryMenu();
+        } else if (input == "5") { // Login/Logout
+          if (session.loggedIn()) {
+            api.logout(session);
+            std::cout << "Logged out successfully.\n";
+          } else {
+            loginMenu();
+          }
+        } else if (input == "0") { // Exit
+          std::cout << "Exiting...\n";
+          break;
+        } else {
+          std::cout << "Invalid choice!\n";
+        }
+      }
+    }
+};
+
+// ---------------------------------------------------------------------------
+// HTTP/JSON front end
+//
+// A small HTTP/1.1 server over the request API. Each worker thread runs its
+// own edge-triggered epoll loop; the listening socket is shared with
+// EPOLLEXCLUSIVE, and an accepted connection stays on the worker that accepted
+// it, so requests never hop threads. Connections and their read/write buffers
+// are recycled, and responses are serialized straight into the connection's
+// output buffer, so a keep-alive request does not allocate once buffers have
+// grown to size.
+//
+//   POST   /login                  {"role","username","password"} -> {"token"}
+//   POST   /logout
+//   GET    /search?title=&category=&minPrice=&maxPrice=&rating=&minDate=&maxDate=
+//               &order=catalog|price|-price|rating|newest|relevance&limit=&cursor=
+//   GET    /games?limit=&cursor=
+//   GET    /games/<title>
+//   GET    /games/<title>/reviews
+//   POST   /games/<title>/reviews  {"text","stars"}
+//   POST   /games/<title>/purchase
+//   GET    /library
+//   GET    /wishlist
+//   POST   /wishlist/<title>
+//   DELETE /wishlist/<title>
+//   GET    /posts?author=&limit=&cursor=
+//   POST   /posts                  {"content"}
+//   DELETE /posts/<id>
+//
+// Authenticated endpoints take "Authorization: Bearer <token>". Lists come a
+// page at a time (50 by default) with a "next" cursor while more remain.
+// /login answers 503 while too many password checks are already queued.
+// ---------------------------------------------------------------------------
+
+// Appends text as a JSON string literal
+inline void appendJsonString(std::string & out, std::string_view text) {
+  out.push_back('"');
+  for (char c: text) {
+    switch (c) {
+    case '"':
+      out += "\\\"";
+      break;
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    case '\r':
+      out += "\\r";
+      break;
+    case '\t':
+      out += "\\t";
+      break;
+    default:
+      if (static_cast < unsigned char > (c) < 0x20) {
+        char escaped[8];
+        std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast < unsigned > (c));
+        out += escaped;
+      } else {
+        out.push_back(c);
+      }
+    }
+  }
+  out.push_back('"');
+}
+
+inline void appendJsonNumber(std::string & out, double value) {
+  char digits[32];
+  int length = std::snprintf(digits, sizeof(digits), "%.15g", value);
+  out.append(digits, static_cast < size_t > (length));
+}
+
+// Reads one top-level field of a flat JSON object: a string (unescaped into
+// value) or a bare literal such as a number. Returns false if it is missing.
+inline bool readJsonField(std::string_view json, std::string_view key, std::string & value) {
+  size_t position = 0;
+  while ((position = json.find('"', position)) != std::string_view::npos) {
+    size_t keyEnd = json.find('"', position + 1);
+    if (keyEnd == std::string_view::npos) return false;
+    std::string_view name = json.substr(position + 1, keyEnd - position - 1);
+    size_t colon = json.find_first_not_of(" \t\r\n", keyEnd + 1);
+    if (name != key || colon == std::string_view::npos || json[colon] != ':') {
+      // Not this key (or a string value); skip past it
+      position = keyEnd + 1;
+      continue;
+    }
+    size_t start = json.find_first_not_of(" \t\r\n", colon + 1);
+    if (start == std::string_view::npos) return false;
+    value.clear();
+    if (json[start] != '"') {
+      size_t end = json.find_first_of(",} \t\r\n", start);
+      value.assign(json.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start));
+      return true;
+    }
+    for (size_t i = start + 1; i < json.size(); ++i) {
+      if (json[i] == '"') return true;
+      if (json[i] == '\\' && i + 1 < json.size()) {
+        char escaped = json[++i];
+        value.push_back(escaped == 'n' ? '\n' : escaped == 't' ? '\t' : escaped == 'r' ? '\r' : escaped);
+      } else {
+        value.push_back(json[i]);
+      }
+    }
+    return false;
+  }
+  return false;
+}
+
+// Decodes %XX escapes and '+' in a URL component
+inline void urlDecode(std::string_view encoded, std::string & decoded) {
+  decoded.clear();
+  for (size_t i = 0; i < encoded.size(); ++i) {
+    if (encoded[i] == '%' && i + 2 < encoded.size() && std::isxdigit(static_cast < unsigned char > (encoded[i + 1])) &&
+      std::isxdigit(static_cast < unsigned char > (encoded[i + 2]))) {
+      decoded.push_back(static_cast < char > (std::stoi(std::string(encoded.substr(i + 1, 2)), nullptr, 16)));
+      i += 2;
+    } else {
+      decoded.push_back(encoded[i] == '+' ? ' ' : encoded[i]);
+    }
+  }
+}
+
+// Finds name in an a=1&b=2 query string; false if absent
+inline bool queryParameter(std::string_view query, std::string_view name, std::string & value) {
+  while (!query.empty()) {
+    size_t end = query.find('&');
+    std::string_view pair = query.substr(0, end);
+    size_t equals = pair.find('=');
+    if (pair.substr(0, equals) == name) {
+      urlDecode(equals == std::string_view::npos ? std::string_view() : pair.substr(equals + 1), value);
+      return true;
+    }
+    if (end == std::string_view::npos) break;
+    query.remove_prefix(end + 1);
+  }
+  return false;
+}
+
+struct HttpRequest {
+  std::string_view method;
+  std::string_view path;
+  std::string_view query;
+  std::string_view authorization;
+  std::string_view body;
+  bool keepAlive = true;
+};
+
+// Maps HTTP requests onto MarketplaceApi calls and renders JSON bodies
+class HttpRouter {
+  private:
+    MarketplaceApi & api;
+    // Bearer tokens are 128 random bits in hex: keyed by the high half,
+    // checked against the low half, so a lookup needs no string copy
+    std::shared_mutex sessionsMutex;
+    std::unordered_map < std::uint64_t, std::pair < std::uint64_t, Session >> sessions;
+
+    static bool parseToken(std::string_view text, std::uint64_t & high, std::uint64_t & low) {
+      if (text.size() != 32) return false;
+      high = low = 0;
+      for (size_t i = 0; i < 32; ++i) {
+        char c = text[i];
+        int digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+        if (digit < 0) return false;
+        std::uint64_t & half = i < 16 ? high : low;
+        half = (half << 4) | static_cast < std::uint64_t > (digit);
+      }
+      return true;
+    }
+
+    static std::string_view bearerToken(const HttpRequest & request) {
+      static constexpr std::string_view prefix = "Bearer ";
+      if (request.authorization.substr(0, prefix.size()) != prefix) return std::string_view();
+      return request.authorization.substr(prefix.size());
+    }
+
+    static int statusCode(ApiStatus status) {
+      switch (status) {
+      case ApiStatus::OK:
+        return 200;
+      case ApiStatus::UNAUTHENTICATED:
+        return 401;
+      case ApiStatus::FORBIDDEN:
+        return 403;
+      case ApiStatus::NOT_FOUND:
+        return 404;
+      case ApiStatus::CONFLICT:
+        return 409;
+      case ApiStatus::BUSY:
+        return 503;
+      default:
+        return 400;
+      }
+    }
+
+    static int error(std::string & body, int code, std::string_view message) {
+      body += "{\"error\":";
+      appendJsonString(body, message);
+      body += "}";
+      return code;
+    }
+
+    static int respond(std::string & body, const ApiResponse & response) {
+      if (!response.ok()) return error(body, statusCode(response.status), response.error);
+      body += "{\"ok\":true}";
+      return 200;
+    }
+
+    static void appendSummary(std::string & body, const GameSummary & game) {
+      body += "{\"id\":";
+      appendJsonString(body, game.gameId);
+      body += ",\"title\":";
+      appendJsonString(body, game.title);
+      body += ",\"genre\":";
+      appendJsonString(body, game.genre);
+      body += ",\"price\":";
+      appendJsonNumber(body, game.price);
+      body += ",\"rating\":";
+      appendJsonNumber(body, static_cast < int > (game.rating));
+    }
+
+    static int respond(std::string & body, const GameListResponse & response) {
+      if (!response.ok()) return error(body, statusCode(response.status), response.error);
+      body += "{\"games\":[";
+      for (size_t i = 0; i < response.games.size(); ++i) {
+        if (i > 0) body.push_back(',');
+        appendSummary(body, response.games[i]);
+        body.push_back('}');
+      }
+      body += "]";
+      if (!response.nextCursor.empty()) {
+        body += ",\"next\":";
+        appendJsonString(body, response.nextCursor);
+      }
+      body += "}";
+      return 200;
+    }
+
+    static int respond(std::string & body, const FeedResponse & response) {
+      if (!response.ok()) return error(body, statusCode(response.status), response.error);
+      body += "{\"posts\":[";
+      for (size_t i = 0; i < response.posts.size(); ++i) {
+        body += i > 0 ? ",{\"id\":" : "{\"id\":";
+        appendJsonNumber(body, static_cast < double > (response.posts[i].id));
+        body += ",\"author\":";
+        appendJsonString(body, response.posts[i].author);
+        body += ",\"content\":";
+        appendJsonString(body, response.posts[i].content);
+        body += ",\"timestamp\":";
+        appendJsonNumber(body, static_cast < double > (response.posts[i].timestamp));
+        body += "}";
+      }
+      body += "]";
+      if (!response.nextCursor.empty()) {
+        body += ",\"next\":";
+        appendJsonString(body, response.nextCursor);
+      }
+      body += "}";
+      return 200;
+    }
+
+    // limit (default 50, capped at 1000) and cursor for paged lists
+    static void pageParameters(const HttpRequest & request, size_t & pageSize, std::string & cursor) {
+      std::string value;
+      pageSize = 50;
+      if (queryParameter(request.query, "limit", value)) {
+        pageSize = std::min < size_t > (1000, std::max(1L, std::atol(value.c_str())));
+      }
+      queryParameter(request.query, "cursor", cursor);
+    }
+
+    Session sessionFor(const HttpRequest & request) {
+      std::uint64_t high, low;
+      if (!parseToken(bearerToken(request), high, low)) return Session();
+      std::shared_lock < std::shared_mutex > lock(sessionsMutex);
+      auto it = sessions.find(high);
+      return it == sessions.end() || it -> second.first != low ? Session() : it -> second.second;
+    }
+
+    int login(const HttpRequest & request, std::string & body) {
+      static const std::pair < const char * , UserRole > roles[] = {
+        {"customer", UserRole::CUSTOMER}, {"developer", UserRole::DEVELOPER},
+        {"manager", UserRole::MANAGER}, {"administrator", UserRole::ADMINISTRATOR}
+      };
+      std::string roleName;
+      LoginRequest login;
+      if (!readJsonField(request.body, "role", roleName) || !readJsonField(request.body, "username", login.username) ||
+        !readJsonField(request.body, "password", login.password)) {
+        return error(body, 400, "role, username and password are required");
+      }
+      auto role = std::find_if(std::begin(roles), std::end(roles), [ & ](const auto & entry) {
+        return roleName == entry.first;
+      });
+      if (role == std::end(roles)) return error(body, 400, "Unknown role");
+      login.role = role -> second;
+
+      Session session;
+      ApiResponse response = api.login(session, login);
+      if (!response.ok()) return respond(body, response);
+      thread_local std::mt19937_64 generator(std::random_device {}());
+      std::uint64_t high, low = generator();
+      {
+        std::unique_lock < std::shared_mutex > lock(sessionsMutex);
+        do {
+          high = generator();
+        } while (sessions.count(high) != 0);
+        sessions[high] = std::make_pair(low, session);
+      }
+      char token[33];
+      std::snprintf(token, sizeof(token), "%016llx%016llx",
+        static_cast < unsigned long long > (high), static_cast < unsigned long long > (low));
+      body += "{\"token\":";
+      appendJsonString(body, token);
+      body += "}";
+      return 200;
+    }
+
+    int gameRoute(const HttpRequest & request, const Session & session, std::string_view rest, std::string & body) {
+      size_t slash = rest.find('/');
+      std::string title;
+      urlDecode(rest.substr(0, slash), title);
+      std::string_view action = slash == std::string_view::npos ? std::string_view() : rest.substr(slash + 1);
+
+      if (action.empty() && request.method == "GET") {
+        GameDetailsResponse response = api.gameDetails(session, {
+          title
+        });
+        if (!response.ok()) return respond(body, static_cast < const ApiResponse & > (response));
+        appendSummary(body, response.game);
+        body += ",\"description\":";
+        appendJsonString(body, response.game.description);
+        body += ",\"releaseDate\":";
+        appendJsonNumber(body, static_cast < double > (response.game.releaseDate));
+        body += ",\"owned\":";
+        body += response.game.owned ? "true" : "false";
+        body += ",\"wishlisted\":";
+        body += response.game.wishlisted ? "true" : "false";
+        body += "}";
+        return 200;
+      }
+      if (action == "reviews" && request.method == "GET") {
+        ReviewsResponse response = api.reviews({
+          title
+        });
+        if (!response.ok()) return respond(body, static_cast < const ApiResponse & > (response));
+        body += "{\"averageRating\":";
+        appendJsonNumber(body, response.averageRating);
+        body += ",\"reviews\":[";
+        for (size_t i = 0; i < response.reviews.size(); ++i) {
+          body += i > 0 ? ",{\"text\":" : "{\"text\":";
+          appendJsonString(body, response.reviews[i].first);
+          body += ",\"stars\":";
+          appendJsonNumber(body, response.reviews[i].second);
+          body += "}";
+        }
+        body += "]}";
+        return 200;
+      }
+      if (action == "reviews" && request.method == "POST") {
+        ReviewRequest review {
+          title, "", 0
+        };
+        std::string stars;
+        if (!readJsonField(request.body, "text", review.text) || !readJsonField(request.body, "stars", stars)) {
+          return error(body, 400, "text and stars are required");
+        }
+        review.stars = std::atoi(stars.c_str());
+        return respond(body, api.review(session, review));
+      }
+      if (action == "purchase" && request.method == "POST") {
+        return respond(body, api.buy(session, {
+          title
+        }));
+      }
+      return error(body, 404, "No such endpoint");
+    }
+
+  public:
+    explicit HttpRouter(MarketplaceApi & api): api(api) {}
+
+    // Writes the JSON body for request and returns the HTTP status code
+    int handle(const HttpRequest & request, std::string & body) {
+      Session session = sessionFor(request);
+      std::string_view path = request.path;
+      static constexpr std::string_view gamesPrefix = "/games/";
+      static constexpr std::string_view wishlistPrefix = "/wishlist/";
+      static constexpr std::string_view postsPrefix = "/posts/";
+
+      if (path == "/login" && request.method == "POST") return login(request, body);
+      if (path == "/logout" && request.method == "POST") {
+        std::uint64_t high, low;
+        if (!parseToken(bearerToken(request), high, low)) return error(body, 401, "Not logged in");
+        std::unique_lock < std::shared_mutex > lock(sessionsMutex);
+        auto it = sessions.find(high);
+        if (it != sessions.end() && it -> second.first == low) sessions.erase(it);
+        body += "{\"ok\":true}";
+        return 200;
+      }
+      if (path == "/search" && request.method == "GET") {
+        SearchRequest search;
+        std::string value;
+        queryParameter(request.query, "title", search.title);
+        queryParameter(request.query, "category", search.category);
+        if (queryParameter(request.query, "minPrice", value)) search.minPrice = std::atof(value.c_str());
+        if (queryParameter(request.query, "maxPrice", value)) search.maxPrice = std::atof(value.c_str());
+        if (queryParameter(request.query, "rating", value)) search.rating = static_cast < GameRating > (std::atoi(value.c_str()) % 5);
+        if (queryParameter(request.query, "minDate", value)) search.minReleaseDate = std::atoll(value.c_str());
+        if (queryParameter(request.query, "maxDate", value)) search.maxReleaseDate = std::atoll(value.c_str());
+        if (queryParameter(request.query, "order", value)) {
+          static const std::pair < const char * , SearchOrder > orders[] = {
+            {"catalog", SearchOrder::CATALOG}, {"price", SearchOrder::PRICE_LOW_TO_HIGH},
+            {"-price", SearchOrder::PRICE_HIGH_TO_LOW}, {"rating", SearchOrder::TOP_RATED},
+            {"newest", SearchOrder::NEWEST}, {"relevance", SearchOrder::RELEVANCE}
+          };
+          auto found = std::find_if(std::begin(orders), std::end(orders), [ & ](const auto & entry) {
+            return value == entry.first;
+          });
+          if (found == std::end(orders)) return error(body, 400, "Unknown order");
+          search.order = found -> second;
+        }
+        pageParameters(request, search.pageSize, search.cursor);
+        return respond(body, api.search(search));
+      }
+      if (path == "/games" && request.method == "GET") {
+        PageRequest page;
+        pageParameters(request, page.pageSize, page.cursor);
+        return respond(body, api.allGames(page));
+      }
+      if (path.substr(0, gamesPrefix.size()) == gamesPrefix) {
+        return gameRoute(request, session, path.substr(gamesPrefix.size()), body);
+      }
+      if (path == "/library" && request.method == "GET") return respond(body, api.library(session));
+      if (path == "/wishlist" && request.method == "GET") return respond(body, api.wishlist(session));
+      if (path.substr(0, wishlistPrefix.size()) == wishlistPrefix) {
+        std::string title;
+        urlDecode(path.substr(wishlistPrefix.size()), title);
+        if (request.method == "POST") return respond(body, api.addToWishlist(session, {
+          title
+        }));
+        if (request.method == "DELETE") return respond(body, api.removeFromWishlist(session, {
+          title
+        }));
+      }
+      if (path == "/posts" && request.method == "GET") {
+        FeedRequest feed;
+        queryParameter(request.query, "author", feed.author);
+        pageParameters(request, feed.pageSize, feed.cursor);
+        return respond(body, api.communityFeed(feed));
+      }
+      if (path.substr(0, postsPrefix.size()) == postsPrefix && request.method == "DELETE") {
+        std::string id(path.substr(postsPrefix.size()));
+        char * end = nullptr;
+        RemovePostRequest remove {std::strtoull(id.c_str(), & end, 10)};
+        if (id.empty() || * end != '\0') return error(body, 400, "Invalid post id");
+        return respond(body, api.removePost(session, remove));
+      }
+      if (path == "/posts" && request.method == "POST") {
+        PostRequest post;
+        if (!readJsonField(request.body, "content", post.content)) return error(body, 400, "content is required");
+        return respond(body, api.writePost(session, post));
+      }
+      return error(body, 404, "No such endpoint");
+    }
+};
+
+class HttpServer {
+  private:
+    static constexpr size_t MaxHeaderBytes = 16 * 1024;
+    static constexpr size_t MaxBodyBytes = 1024 * 1024;
+    static constexpr int MaxEvents = 256;
+
+    struct Connection {
+      int fd = -1;
+      std::string in;
+      std::string out;
+      size_t outSent = 0;
+      bool closeAfterWrite = false;
+    };
+
+    // Per-thread state; connections are recycled with their buffers intact
+    struct Worker {
+      int epollFd = -1;
+      std::vector < std::unique_ptr < Connection >> connections;
+      std::vector < Connection * > idle;
+      std::string body;
+      std::thread thread;
+    };
+
+    HttpRouter router;
+    int listenFd = -1;
+    int wakeFd = -1; // becomes readable on stop(), waking every worker
+    std::uint16_t boundPort = 0;
+    std::vector < std::unique_ptr < Worker >> workers;
+
+    static void setNonBlocking(int fd) {
+      ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    }
+
+    static const char * reason(int code) {
+      switch (code) {
+      case 200:
+        return "OK";
+      case 400:
+        return "Bad Request";
+      case 401:
+        return "Unauthorized";
+      case 403:
+        return "Forbidden";
+      case 404:
+        return "Not Found";
+      case 409:
+        return "Conflict";
+      case 413:
+        return "Payload Too Large";
+      case 431:
+        return "Request Header Fields Too Large";
+      case 503:
+        return "Service Unavailable";
+      default:
+        return "Internal Server Error";
+      }
+    }
+
+    static bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+      return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+        return std::tolower(static_cast < unsigned char > (x)) == std::tolower(static_cast < unsigned char > (y));
+      });
+    }
+
+    static void appendResponse(Connection & connection, int code, const std::string & body, bool keepAlive) {
+      char head[160];
+      int length = std::snprintf(head, sizeof(head),
+        "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\nContent-Length: %zu\r\nConnection: %s\r\n\r\n",
+        code, reason(code), body.size(), keepAlive ? "keep-alive" : "close");
+      connection.out.append(head, static_cast < size_t > (length));
+      connection.out.append(body);
+    }
+
+    // Parses the complete request starting at offset in connection.in; the
+    // request's views point into that buffer. Returns the bytes it used, 0 if
+    // more input is needed, or -1 after queueing an error response.
+    long parseRequest(Connection & connection, HttpRequest & request, Worker & worker, size_t offset) {
+      std::string_view data(connection.in);
+      data.remove_prefix(offset);
+      size_t headerEnd = data.find("\r\n\r\n");
+      if (headerEnd == std::string_view::npos) {
+        if (data.size() <= MaxHeaderBytes) return 0;
+        worker.body = "{\"error\":\"Headers too large\"}";
+        appendResponse(connection, 431, worker.body, false);
+        return -1;
+      }
+
+      std::string_view head = data.substr(0, headerEnd);
+      size_t lineEnd = head.find("\r\n");
+      std::string_view requestLine = head.substr(0, lineEnd);
+      size_t firstSpace = requestLine.find(' ');
+      size_t secondSpace = requestLine.find(' ', firstSpace + 1);
+      if (firstSpace == std::string_view::npos || secondSpace == std::string_view::npos) {
+        worker.body = "{\"error\":\"Malformed request line\"}";
+        appendResponse(connection, 400, worker.body, false);
+        return -1;
+      }
+      request = HttpRequest();
+      request.method = requestLine.substr(0, firstSpace);
+      std::string_view target = requestLine.substr(firstSpace + 1, secondSpace - firstSpace - 1);
+      std::string_view version = requestLine.substr(secondSpace + 1);
+      size_t question = target.find('?');
+      request.path = target.substr(0, question);
+      if (question != std::string_view::npos) request.query = target.substr(question + 1);
+      request.keepAlive = version == "HTTP/1.1";
+
+      size_t contentLength = 0;
+      while (lineEnd != std::string_view::npos) {
+        size_t next = head.find("\r\n", lineEnd + 2);
+        std::string_view line = head.substr(lineEnd + 2, next == std::string_view::npos ? std::string_view::npos : next - lineEnd - 2);
+        lineEnd = next;
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos) continue;
+        std::string_view name = line.substr(0, colon);
+        std::string_view value = line.substr(colon + 1);
+        value.remove_prefix(std::min(value.find_first_not_of(' '), value.size()));
+        if (equalsIgnoreCase(name, "Content-Length")) {
+          contentLength = static_cast < size_t > (std::strtoull(std::string(value).c_str(), nullptr, 10));
+        } else if (equalsIgnoreCase(name, "Connection")) {
+          if (equalsIgnoreCase(value, "close")) request.keepAlive = false;
+          if (equalsIgnoreCase(value, "keep-alive")) request.keepAlive = true;
+        } else if (equalsIgnoreCase(name, "Authorization")) {
+          request.authorization = value;
+        }
+      }
+      if (contentLength > MaxBodyBytes) {
+        worker.body = "{\"error\":\"Body too large\"}";
+        appendResponse(connection, 413, worker.body, false);
+        return -1;
+      }
+      size_t total = headerEnd + 4 + contentLength;
+      if (data.size() < total) return 0;
+      request.body = data.substr(headerEnd + 4, contentLength);
+      return static_cast < long > (total);
+    }
+
+    void closeConnection(Worker & worker, Connection * connection) {
+      ::epoll_ctl(worker.epollFd, EPOLL_CTL_DEL, connection -> fd, nullptr);
+      ::close(connection -> fd);
+      connection -> fd = -1;
+      connection -> in.clear();
+      connection -> out.clear();
+      connection -> outSent = 0;
+      connection -> closeAfterWrite = false;
+      worker.idle.push_back(connection);
+    }
+
+    // Writes as much pending output as the socket takes; false once closed
+    bool flush(Worker & worker, Connection * connection) {
+      while (connection -> outSent < connection -> out.size()) {
+        ssize_t n = ::send(connection -> fd, connection -> out.data() + connection -> outSent,
+          connection -> out.size() - connection -> outSent, MSG_NOSIGNAL);
+        if (n < 0) {
+          if (errno == EAGAIN || errno == EWOULDBLOCK) return true; // EPOLLOUT resumes it
+          closeConnection(worker, connection);
+          return false;
+        }
+        connection -> outSent += static_cast < size_t > (n);
+      }
+      connection -> out.clear();
+      connection -> outSent = 0;
+      if (connection -> closeAfterWrite) {
+        closeConnection(worker, connection);
+        return false;
+      }
+      return true;
+    }
+
+    void acceptConnections(Worker & worker) {
+      while (true) {
+        int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return; // EAGAIN: another worker or nothing left
+        int noDelay = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, & noDelay, sizeof(noDelay));
+        Connection * connection;
+        if (worker.idle.empty()) {
+          worker.connections.push_back(std::make_unique < Connection > ());
+          connection = worker.connections.back().get();
+        } else {
+          connection = worker.idle.back();
+          worker.idle.pop_back();
+        }
+        connection -> fd = fd;
+        epoll_event event {};
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.ptr = connection;
+        ::epoll_ctl(worker.epollFd, EPOLL_CTL_ADD, fd, & event);
+      }
+    }
+
+    void serveReadable(Worker & worker, Connection * connection) {
+      // Edge-triggered: drain the socket completely
+      bool peerClosed = false;
+      char chunk[16 * 1024];
+      while (true) {
+        ssize_t n = ::recv(connection -> fd, chunk, sizeof(chunk), 0);
+        if (n > 0) {
+          connection -> in.append(chunk, static_cast < size_t > (n));
+          continue;
+        }
+        if (n == 0) peerClosed = true;
+        else if (errno != EAGAIN && errno != EWOULDBLOCK) peerClosed = true;
+        break;
+      }
+
+      // Answer every complete request buffered so far, pipelined ones included
+      size_t consumed = 0;
+      while (!connection -> closeAfterWrite && consumed < connection -> in.size()) {
+        HttpRequest request;
+        long used = parseRequest( * connection, request, worker, consumed);
+        if (used == 0) break;
+        if (used < 0) {
+          connection -> closeAfterWrite = true;
+          break;
+        }
+        worker.body.clear();
+        int code;
+        try {
+          code = router.handle(request, worker.body);
+        } catch (const std::exception & e) {
+          worker.body.clear();
+          worker.body += "{\"error\":";
+          appendJsonString(worker.body, e.what());
+          worker.body += "}";
+          code = 500;
+        }
+        appendResponse( * connection, code, worker.body, request.keepAlive);
+        if (!request.keepAlive) connection -> closeAfterWrite = true;
+        consumed += static_cast < size_t > (used);
+      }
+      connection -> in.erase(0, consumed);
+
+      if (!flush(worker, connection)) return;
+      if (peerClosed) closeConnection(worker, connection);
+    }
 
+    void run(Worker & worker) {
+      epoll_event events[MaxEvents];
+      while (true) {
+        int count = ::epoll_wait(worker.epollFd, events, MaxEvents, -1);
+        if (count < 0) {
+          if (errno == EINTR) continue;
+          return;
+        }
+        for (int i = 0; i < count; ++i) {
+          if (events[i].data.ptr == & listenFd) {
+            acceptConnections(worker);
+            continue;
+          }
+          if (events[i].data.ptr == & wakeFd) {
+            for (auto & connection: worker.connections) {
+              if (connection -> fd >= 0) ::close(connection -> fd);
+            }
+            return;
+          }
+          Connection * connection = static_cast < Connection * > (events[i].data.ptr);
+          if (connection -> fd < 0) continue; // closed earlier in this batch
+          if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+            serveReadable(worker, connection);
+          } else if (events[i].events & EPOLLOUT) {
+            flush(worker, connection);
+          }
+        }
+      }
+    }
+
+  public:
+    // Listens on port (0 picks a free one) and starts threads workers
+    HttpServer(MarketplaceApi & api, std::uint16_t port, unsigned threads): router(api) {
+      listenFd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+      int reuse = 1;
+      ::setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, & reuse, sizeof(reuse));
+      sockaddr_in address {};
+      address.sin_family = AF_INET;
+      address.sin_addr.s_addr = htonl(INADDR_ANY);
+      address.sin_port = htons(port);
+      if (listenFd < 0 || ::bind(listenFd, reinterpret_cast < sockaddr * > ( & address), sizeof(address)) != 0 ||
+        ::listen(listenFd, SOMAXCONN) != 0) {
+        if (listenFd >= 0) ::close(listenFd);
+        throw std::runtime_error("Cannot listen on port " + std::to_string(port));
+      }
+      socklen_t length = sizeof(address);
+      ::getsockname(listenFd, reinterpret_cast < sockaddr * > ( & address), & length);
+      boundPort = ntohs(address.sin_port);
+      wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+      for (unsigned i = 0; i < std::max(1u, threads); ++i) {
+        auto worker = std::make_unique < Worker > ();
+        worker -> epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+        epoll_event event {};
+        event.events = EPOLLIN | EPOLLEXCLUSIVE;
+        event.data.ptr = & listenFd;
+        ::epoll_ctl(worker -> epollFd, EPOLL_CTL_ADD, listenFd, & event);
+        event.events = EPOLLIN;
+        event.data.ptr = & wakeFd;
+        ::epoll_ctl(worker -> epollFd, EPOLL_CTL_ADD, wakeFd, & event);
+        Worker & self = * worker;
+        worker -> thread = std::thread([this, & self] {
+          run(self);
+        });
+        workers.push_back(std::move(worker));
+      }
+    }
+
+    HttpServer(const HttpServer & ) = delete;
+    HttpServer & operator = (const HttpServer & ) = delete;
+
+    ~HttpServer() {
+      stop();
+    }
+
+    std::uint16_t port() const {
+      return boundPort;
+    }
+
+    // Closes every connection and joins the workers
+    void stop() {
+      if (workers.empty()) return;
+      std::uint64_t one = 1;
+      if (::write(wakeFd, & one, sizeof(one)) < 0) {
+        std::cerr << "Cannot wake HTTP workers" << std::endl;
+      }
+      for (auto & worker: workers) {
+        worker -> thread.join();
+        ::close(worker -> epollFd);
+      }
+      workers.clear();
+      ::close(wakeFd);
+      ::close(listenFd);
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Benchmarks, run with: game_marketplace --bench <name>
+// ---------------------------------------------------------------------------
+
+// Mirror of the original heap-allocated Game layout, used as the baseline
+struct PointerScanGame {
+  std::string gameId;
+  std::string title;
+  std::string description;
+  double price;
+  std::string genre;
+  GameRating rating;
+  std::time_t releaseDate;
+  std::string developerName;
+  double averageUserRating;
+  int totalReviews;
+  std::vector < std::pair < std::string, int >> reviews;
+};
+
+template < typename Fn >
+double averageMillis(int repetitions, Fn && fn) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < repetitions; ++i) fn();
+  std::chrono::duration < double, std::milli > elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / repetitions;
+}
+
+// Columnar filter pass vs the old pointer-vector scan at 10k, 100k and 1M games
+void benchmarkFilterScan() {
+  GameRating ratings[] = {GameRating::E, GameRating::E10, GameRating::T, GameRating::M, GameRating::AO};
+  for (int count : {10000, 100000, 1000000}) {
+    std::mt19937 gen(42);
+    std::uniform_real_distribution < > priceDistrib(0.0, 70.0);
+    std::uniform_int_distribution < > genreDistrib(1, 50);
+
+    GameMarketplace marketplace;
+    std::vector < PointerScanGame * > baseline;
+    baseline.reserve(count);
+    for (int i = 0; i < count; ++i) {
+      double price = priceDistrib(gen);
+      std::string genre = "Genre " + std::to_string(genreDistrib(gen));
+      GameRating rating = ratings[i % 5];
+      Game * game = marketplace.createGame("Game " + std::to_string(i), "Description", price, genre, rating, "developer1");
+      baseline.push_back(new PointerScanGame {
+        std::string(game -> getGameId()), std::string(game -> getTitle()), "Description", price, genre, rating,
+        game -> getReleaseDate(), "developer1", 0.0, 0, {}
+      });
+    }
+
+    // Shuffle the baseline allocations' visiting order the way a long-lived heap would
+    std::shuffle(baseline.begin(), baseline.end(), gen);
+
+    size_t columnarHits = 0, pointerHits = 0;
+    const int repetitions = count >= 1000000 ? 5 : 50;
+    double columnar = averageMillis(repetitions, [&] {
+      columnarHits = marketplace.searchGames("", 10.0, 40.0, "", GameRating::M).size();
+    });
+    double pointer = averageMillis(repetitions, [&] {
+      pointerHits = 0;
+      for (auto * game: baseline) {
+        bool priceMatch = game -> price >= 10.0 && game -> price <= 40.0;
+        bool ratingMatch = game -> rating == GameRating::M;
+        bool releaseDateMatch = game -> releaseDate >= 0 &&
+          game -> releaseDate <= std::numeric_limits < std::time_t > ::max();
+        if (priceMatch && ratingMatch && releaseDateMatch) pointerHits++;
+      }
+    });
+
+    std::cout << count << " games: pointer scan " << pointer << " ms, columnar "
+      << columnar << " ms (" << pointerHits << "/" << columnarHits << " matches)\n";
+    for (auto * game: baseline) delete game;
+  }
+}
+
+// Scalar filter kernel vs the SIMD kernels at a cache-resident and a
+// memory-bound catalog size, checking that every kernel produces the same
+// bitmap for a spread of queries. Returns false on any mismatch.
+bool benchmarkFilterKernels() {
+  std::vector < std::pair < const char * , FilterKernel >> kernels = {{"scalar", filterKernelScalar}};
+#ifdef MARKETPLACE_X86_KERNELS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse4.2")) kernels.push_back({"sse4.2", filterKernelSse42});
+  if (__builtin_cpu_supports("avx2")) kernels.push_back({"avx2", filterKernelAvx2});
+#endif
+
+  bool allIdentical = true;
+  for (int count : {100000, 1000000}) {
+    std::mt19937 gen(7);
+    std::uniform_real_distribution < > priceDistrib(0.0, 70.0);
+    std::uniform_int_distribution < > genreDistrib(1, 50);
+    std::uniform_int_distribution < > ratingDistrib(0, 4);
+    std::uniform_int_distribution < std::time_t > dateDistrib(1000000000, 1700000000);
+
+    CatalogStore store;
+    for (int i = 0; i < count; ++i) {
+      store.append(nullptr, priceDistrib(gen), "Genre " + std::to_string(genreDistrib(gen)),
+        static_cast < GameRating > (ratingDistrib(gen)), dateDistrib(gen));
+    }
+    std::vector < std::uint8_t > allGenres(store.genreCount(), 1);
+    std::vector < std::uint8_t > someGenres(store.genreCount(), 0);
+    for (std::uint32_t id = 0; id < store.genreCount(); id += 3) someGenres[id] = 1;
+
+    bool identical = true;
+    for (int query = 0; query < 50; ++query) {
+      double low = priceDistrib(gen), high = low + priceDistrib(gen);
+      std::time_t from = dateDistrib(gen), to = from + dateDistrib(gen) / 4;
+      GameRating rating = static_cast < GameRating > (ratingDistrib(gen));
+      const auto & genres = query % 2 ? someGenres : allGenres;
+      SelectionBitmap reference = store.filter(low, high, rating, from, to, genres, filterKernelScalar);
+      for (const auto & kernel: kernels) {
+        if (store.filter(low, high, rating, from, to, genres, kernel.second).words != reference.words) {
+          std::cout << kernel.first << " kernel differs from scalar on query " << query << "\n";
+          identical = false;
+        }
+      }
+    }
+    std::cout << count << " games: kernel results " << (identical ? "bit-identical" : "MISMATCH")
+      << " across 50 queries\n";
+    allIdentical = allIdentical && identical;
+
+    for (const auto * genres : {&allGenres, &someGenres}) {
+      double scalarMillis = 0;
+      for (const auto & kernel: kernels) {
+        double millis = averageMillis(count >= 1000000 ? 20 : 200, [&] {
+          store.filter(10.0, 40.0, GameRating::M, 1200000000, 1600000000, *genres, kernel.second);
+        });
+        if (kernel.second == filterKernelScalar) scalarMillis = millis;
+        std::cout << "  " << kernel.first << (genres == &allGenres ? ", any genre: " : ", genre filter: ")
+          << millis << " ms per pass (" << scalarMillis / millis << "x)\n";
+      }
+    }
+  }
+  return allIdentical;
+}
+
+// Startup from a snapshot vs generating the same marketplace again
+void benchmarkSnapshot() {
+  SyntheticConfig config;
+  config.games = 1000000;
+  config.users = 1000000;
+  config.reviewsPerGame = 3;
+  config.meanLibrary = 5;
+  const std::string path = "benchmark.snap";
+
+  auto start = std::chrono::steady_clock::now();
+  auto seconds = [ & ] {
+    std::chrono::duration < double > elapsed = std::chrono::steady_clock::now() - start;
+    start = std::chrono::steady_clock::now();
+    return elapsed.count();
+  };
+
+  {
+    GameMarketplace marketplace;
+    marketplace.populateSynthetic(config);
+    std::cout << "Generate " << config.games << " games, " << config.users << " users: " << seconds() << " s\n";
+    marketplace.saveSnapshot(path);
+    std::cout << "Save snapshot: " << seconds() << " s\n";
+  }
+  seconds();
+  {
+    GameMarketplace marketplace;
+    marketplace.loadSnapshot(path);
+    std::cout << "Load snapshot: " << seconds() << " s ("
+      << marketplace.searchGames("Crimson Kingdom").size() << " search hits after load)\n";
+  }
+  std::remove(path.c_str());
+}
+
+// Mixed read/write workload against one marketplace from 1 up to
+// hardware_concurrency threads: 80% lookups, 8% ownership checks, 8% wishlist
+// toggles, 2% price changes, 1% reviews and 1% searches
+void benchmarkConcurrency() {
+  const int gameCount = 50000, userCount = 10000, opsPerThread = 200000;
+  SyntheticConfig config;
+  config.games = gameCount;
+  config.users = userCount;
+  config.posts = 1000;
   GameMarketplace marketplace;
+  marketplace.populateSynthetic(config);
+  std::vector < Game * > created = marketplace.catalogGames();
+  std::vector < User * > registered = marketplace.usersWithRole(UserRole::CUSTOMER);
+  // Every user owns the game they review below
+  for (int i = 0; i < userCount; ++i) marketplace.purchaseGame(registered[i], created[i % gameCount]);
+
+  auto worker = [ & ](unsigned seed) {
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution < > gameDistrib(0, gameCount - 1), userDistrib(0, userCount - 1), opDistrib(0, 99);
+    double sink = 0;
+    for (int op = 0; op < opsPerThread; ++op) {
+      int kind = opDistrib(gen);
+      int userIndex = userDistrib(gen);
+      Game * game = created[gameDistrib(gen)];
+      User * user = registered[userIndex];
+      if (kind < 80) {
+        Game * found = marketplace.findGameById(game -> getGameId());
+        sink += marketplace.priceOf(found) + marketplace.reviewsOf(found).size();
+      } else if (kind < 88) {
+        sink += marketplace.ownsGame(user, game);
+      } else if (kind < 96) {
+        if (!marketplace.addToWishlist(user, game)) marketplace.removeFromWishlist(user, game);
+      } else if (kind < 98) {
+        marketplace.changePrice(game, (op % 60) + 0.99);
+      } else if (kind < 99) {
+        marketplace.submitReview(user, created[userIndex % gameCount], "Benchmark review", op % 5 + 1);
+      } else {
+        sink += marketplace.searchGames("Kingdom", 10.0, 30.0).size();
+      }
+    }
+    return sink;
+  };
+
+  unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+  std::vector < unsigned > threadCounts;
+  for (unsigned threads = 1; threads < maxThreads; threads *= 2) threadCounts.push_back(threads);
+  threadCounts.push_back(maxThreads);
+
+  double baseline = 0;
+  for (unsigned threads: threadCounts) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector < std::thread > pool;
+    for (unsigned t = 0; t < threads; ++t) {
+      pool.emplace_back([ & , t] {
+        volatile double sink = worker(1000 * threads + t);
+        (void) sink;
+      });
+    }
+    for (auto & thread: pool) thread.join();
+    std::chrono::duration < double > elapsed = std::chrono::steady_clock::now() - start;
+    double opsPerSecond = threads * static_cast < double > (opsPerThread) / elapsed.count();
+    if (threads == 1) baseline = opsPerSecond;
+    std::cout << threads << " threads: " << static_cast < long long > (opsPerSecond) << " ops/s ("
+      << opsPerSecond / baseline << "x)\n";
+  }
+}
 
+// Per-operation latency through the request API on the default marketplace
+void benchmarkApi() {
+  const int iterations = 20000;
+  GameMarketplace marketplace;
+  marketplace.setPasswordCost(1); // measures the API around the hash; --bench login times the hash
+  marketplace.populateWithDefaults();
+  MarketplaceApi api(marketplace);
+  Session customer, developer, manager;
+  api.login(customer, {
+    UserRole::CUSTOMER, "customer1", "password"
+  });
+  api.login(developer, {
+    UserRole::DEVELOPER, api.loginHint(UserRole::DEVELOPER), "password"
+  });
+  api.login(manager, {
+    UserRole::MANAGER, "manager1", "password"
+  });
+  std::string developerGame = api.developerGames(developer).games.front().title;
+  api.buy(customer, {
+    "Game 1"
+  });
+
+  auto measure = [ & ](const std::string & name, auto operation) {
+    std::vector < double > micros(iterations);
+    for (int i = 0; i < iterations; ++i) {
+      auto start = std::chrono::steady_clock::now();
+      operation(i);
+      micros[i] = std::chrono::duration < double, std::micro > (std::chrono::steady_clock::now() - start).count();
+    }
+    std::sort(micros.begin(), micros.end());
+    std::cout << name << ": p50 " << micros[iterations / 2] << " us, p99 " << micros[iterations * 99 / 100] << " us\n";
+  };
+
+  measure("login/logout", [ & ](int) {
+    Session session;
+    api.login(session, {
+      UserRole::CUSTOMER, "customer2", "password"
+    });
+    api.logout(session);
+  });
+  measure("browse page", [ & ](int) {
+    api.allGames(PageRequest());
+  });
+  measure("game details", [ & ](int) {
+    api.gameDetails(customer, {
+      "Game 4"
+    });
+  });
+  measure("search", [ & ](int) {
+    SearchRequest request;
+    request.title = "Game";
+    request.maxPrice = 25.0;
+    api.search(request);
+  });
+  measure("buy/remove", [ & ](int) {
+    api.buy(customer, {
+      "Game 2"
+    });
+    api.removeFromLibrary(customer, {
+      "Game 2"
+    });
+  });
+  measure("wishlist toggle", [ & ](int) {
+    api.addToWishlist(customer, {
+      "Game 3"
+    });
+    api.removeFromWishlist(customer, {
+      "Game 3"
+    });
+  });
+  measure("review", [ & ](int i) {
+    api.review(customer, {
+      "Game 1", "Benchmark review", i % 5 + 1
+    });
+  });
+  measure("post", [ & ](int) {
+    api.writePost(customer, {
+      "Benchmark post"
+    });
+  });
+  measure("price change", [ & ](int i) {
+    api.changePrice(developer, {
+      developerGame, 10.0 + i % 10
+    });
+  });
+  measure("weekly sale", [ & ](int) {
+    api.setWeeklySale(manager, {
+      "Game 5", 10.0
+    });
+  });
+}
+
+// Starts the HTTP server on a free port and drives it from keep-alive client
+// threads over loopback, reporting throughput and latency percentiles
+void benchmarkHttp() {
+  const int clients = 8, requestsPerClient = 5000;
+  GameMarketplace marketplace;
   marketplace.populateWithDefaults();
+  for (int i = 11; i <= 5000; ++i) {
+    marketplace.createGame("Game " + std::to_string(i), "Description", (i % 60) + 0.99,
+      "Genre " + std::to_string(i % 40), GameRating::E, "developer" + std::to_string(i % 100));
+  }
+  MarketplaceApi api(marketplace);
+  HttpServer server(api, 0, std::max(1u, std::thread::hardware_concurrency()));
+
+  const std::string requests[] = {
+    "GET /games/Game%204 HTTP/1.1\r\nHost: bench\r\n\r\n",
+    "GET /games/Game%204/reviews HTTP/1.1\r\nHost: bench\r\n\r\n",
+    "GET /search?title=Game%2012&maxPrice=40 HTTP/1.1\r\nHost: bench\r\n\r\n",
+    "GET /posts HTTP/1.1\r\nHost: bench\r\n\r\n"
+  };
+
+  std::vector < std::vector < double >> latencies(clients);
+  auto client = [ & ](int index) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    int noDelay = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, & noDelay, sizeof(noDelay));
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(server.port());
+    if (::connect(fd, reinterpret_cast < sockaddr * > ( & address), sizeof(address)) != 0) {
+      ::close(fd);
+      return;
+    }
+    std::string response;
+    char chunk[16 * 1024];
+    latencies[index].reserve(requestsPerClient);
+    for (int i = 0; i < requestsPerClient; ++i) {
+      const std::string & request = requests[(index + i) % 4];
+      auto start = std::chrono::steady_clock::now();
+      if (::send(fd, request.data(), request.size(), MSG_NOSIGNAL) != static_cast < ssize_t > (request.size())) break;
+      // Read until the whole Content-Length body is in
+      response.clear();
+      size_t expected = std::string::npos;
+      while (response.size() < expected) {
+        ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) break;
+        response.append(chunk, static_cast < size_t > (n));
+        size_t headerEnd = response.find("\r\n\r\n");
+        size_t lengthAt = response.find("Content-Length: ");
+        if (expected == std::string::npos && headerEnd != std::string::npos && lengthAt != std::string::npos) {
+          expected = headerEnd + 4 + std::strtoull(response.c_str() + lengthAt + 16, nullptr, 10);
+        }
+      }
+      latencies[index].push_back(std::chrono::duration < double, std::micro > (std::chrono::steady_clock::now() - start).count());
+    }
+    ::close(fd);
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector < std::thread > threads;
+  for (int i = 0; i < clients; ++i) threads.emplace_back(client, i);
+  for (auto & thread: threads) thread.join();
+  std::chrono::duration < double > elapsed = std::chrono::steady_clock::now() - start;
+  server.stop();
+
+  std::vector < double > all;
+  for (const auto & perClient: latencies) all.insert(all.end(), perClient.begin(), perClient.end());
+  if (all.empty()) {
+    std::cout << "No requests completed\n";
+    return;
+  }
+  std::sort(all.begin(), all.end());
+  std::cout << all.size() << " requests over " << clients << " keep-alive connections: "
+    << static_cast < long long > (all.size() / elapsed.count()) << " req/s, p50 "
+    << all[all.size() / 2] << " us, p99 " << all[all.size() * 99 / 100] << " us\n";
+}
+
+// First-page and deep-page latency of the ranked browse path against the old
+// approach of filtering the whole catalog and sorting the result
+void benchmarkTopK() {
+  const std::time_t latest = std::numeric_limits < std::time_t > ::max();
+  for (int count : {100000, 1000000}) {
+    std::mt19937 gen(42);
+    std::uniform_real_distribution < > priceDistrib(0.0, 70.0);
+    GameMarketplace marketplace;
+    for (int i = 0; i < count; ++i) {
+      marketplace.createGame("Game " + std::to_string(i), "Description", priceDistrib(gen),
+        "Genre " + std::to_string(i % 50), GameRating::E, "developer1");
+    }
+    // Build the sort index up front so it is not charged to the first sample
+    marketplace.searchGamesPage("", 0.0, 1000.0, "", GameRating::E, 0, latest, SearchOrder::PRICE_LOW_TO_HIGH, 1);
+
+    const int repetitions = count >= 1000000 ? 3 : 20;
+    double fullSort = averageMillis(repetitions, [ & ] {
+      auto games = marketplace.searchGames("", 0.0, 1000.0, "", GameRating::E);
+      std::sort(games.begin(), games.end(), [](const Game * a, const Game * b) {
+        return a -> getPrice() < b -> getPrice();
+      });
+    });
+    std::cout << count << " games: filter + full sort " << fullSort << " ms\n";
+
+    for (size_t pageSize : {size_t(20), size_t(200)}) {
+      SearchPage page;
+      double first = averageMillis(1000, [ & ] {
+        page = marketplace.searchGamesPage("", 0.0, 1000.0, "", GameRating::E, 0, latest,
+          SearchOrder::PRICE_LOW_TO_HIGH, pageSize);
+      });
+      // Walk 50 pages in, then time fetching the next one from its cursor
+      for (int i = 0; i < 50 && !page.nextCursor.empty(); ++i) {
+        page = marketplace.searchGamesPage("", 0.0, 1000.0, "", GameRating::E, 0, latest,
+          SearchOrder::PRICE_LOW_TO_HIGH, pageSize, page.nextCursor);
+      }
+      std::string cursor = page.nextCursor;
+      double deep = averageMillis(1000, [ & ] {
+        marketplace.searchGamesPage("", 0.0, 1000.0, "", GameRating::E, 0, latest,
+          SearchOrder::PRICE_LOW_TO_HIGH, pageSize, cursor);
+      });
+      double titled = averageMillis(repetitions, [ & ] {
+        marketplace.searchGamesPage("Game 1", 0.0, 1000.0, "", GameRating::E, 0, latest,
+          SearchOrder::PRICE_LOW_TO_HIGH, pageSize);
+      });
+      std::cout << "  page of " << pageSize << ": first " << first * 1000 << " us, page 51 "
+        << deep * 1000 << " us, title-filtered top-K " << titled << " ms\n";
+    }
+  }
+}
+
+// Title search at 1M generated titles: exact, case- and accent-folded and
+// typo queries. Each title is an adjective, a noun and its index, so every
+// adjective-noun pair names 3125 games and the trie holds a million numbers.
+void benchmarkFuzzySearch() {
+  const char * adjectives[] = {"Dark", "Super", "Final", "Eternal", "Crimson", "Silent", "Ancient", "Galactic",
+    "Mystic", "Broken", "Infinite", "Hollow", "Savage", "Radiant", "Frozen", "Cyber"};
+  const char * nouns[] = {"Souls", "Fantasy", "Legends", "Kingdom", "Empire", "Odyssey", "Frontier", "Dungeon",
+    "Horizon", "Requiem", "Crusade", "Pokémon", "Café", "Rampage", "Chronicles", "Outlaws", "Voyage", "Citadel",
+    "Paradox", "Tactics"};
+  const int count = 1000000;
+  GameMarketplace marketplace;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < count; ++i) {
+    std::string title = std::string(adjectives[i % 16]) + " " + nouns[(i / 16) % 20] + " " + std::to_string(i);
+    marketplace.createGame(title, "Description", 19.99, "Genre " + std::to_string(i % 50), GameRating::E, "developer1");
+  }
+  std::chrono::duration < double > built = std::chrono::steady_clock::now() - start;
+  std::cout << count << " titles indexed in " << built.count() << " s\n";
+
+  // Games 4242, 12997 and 160179 are "Final Odyssey", "Silent Café" and "Eternal Pokémon"
+  const char * queries[] = {"Final Odyssey 4242", "final odyssey 4242", "SILENT CAFE 12997", "fianl odysey 4242",
+    "odyssey final 4242", "pokemn 160179", "eternl pokemon", "anicent requeim", "crimsn"};
+  for (const char * query: queries) {
+    size_t hits = 0;
+    double millis = averageMillis(20, [ & ] {
+      hits = marketplace.searchGames(query).size();
+    });
+    double paged = averageMillis(20, [ & ] {
+      marketplace.searchGamesPage(query, 0.0, 1000.0, "", GameRating::E, 0, std::numeric_limits < std::time_t > ::max(),
+        SearchOrder::RELEVANCE, 20);
+    });
+    std::cout << "  \"" << query << "\": " << millis << " ms, top 20 by relevance " << paged << " ms (" << hits << " matches)\n";
+  }
+}
+
+// Appends 50M posts to a feed that spills cold segments to disk, then times
+// the first page, a page from the cold middle of the log and a per-author page
+void benchmarkFeed() {
+  const std::uint64_t count = 50000000;
+  CommunityFeed feed;
+  feed.spillTo("benchmark.feed");
+  std::time_t now = std::time(nullptr);
+  auto start = std::chrono::steady_clock::now();
+  for (std::uint64_t i = 1; i <= count; ++i) {
+    feed.append("user" + std::to_string(i % 10000), "Post number " + std::to_string(i), now);
+  }
+  std::chrono::duration < double > built = std::chrono::steady_clock::now() - start;
+  CommunityFeed::Stats stats = feed.stats();
+  std::cout << count << " posts appended in " << built.count() << " s; " << stats.residentSegments << " of " <<
+    stats.segments << " segments in memory (" << stats.residentBytes / (1024 * 1024) << " MiB), " <<
+    stats.spilledBytes / (1024 * 1024) << " MiB spilled\n";
+
+  double first = averageMillis(1000, [ & ] {
+    feed.latest(20);
+  });
+  auto coldStart = std::chrono::steady_clock::now();
+  feed.latest(20, count / 2);
+  std::chrono::duration < double, std::milli > cold = std::chrono::steady_clock::now() - coldStart;
+  double warm = averageMillis(1000, [ & ] {
+    feed.latest(20, count / 2);
+  });
+  double author = averageMillis(1000, [ & ] {
+    feed.latestBy("user42", 20);
+  });
+  std::cout << "  first page " << first * 1000 << " us, page at post " << count / 2 << ": " << cold.count() <<
+    " ms from disk then " << warm * 1000 << " us, one author's latest 20 " << author * 1000 << " us\n";
+}
+
+// Records 100M purchases of 10k games by 500 developers, then times the
+// developer and manager reports against rescanning every row
+void benchmarkSalesLedger() {
+  const size_t count = 100000000;
+  const std::uint32_t gameCount = 10000, developerCount = 500, buyerCount = 1000000;
+  SalesLedger ledger;
+  for (std::uint32_t i = 0; i < buyerCount; ++i) ledger.buyerKey("user" + std::to_string(i));
+  for (std::uint32_t i = 0; i < developerCount; ++i) ledger.developerKey("developer" + std::to_string(i));
+  std::mt19937_64 gen(42);
+  std::time_t now = std::time(nullptr);
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < count; ++i) {
+    std::uint64_t bits = gen();
+    std::uint32_t game = static_cast < std::uint32_t > (bits % gameCount);
+    std::uint16_t discount = (bits >> 40) % 4 == 0 ? 2500 : 0;
+    std::uint32_t listCents = 499 + game % 50 * 100;
+    ledger.record({
+      static_cast < std::uint32_t > ((bits >> 14) % buyerCount), {game, 0}, game % developerCount, {
+        listCents - listCents * discount / 10000, discount,
+          now - static_cast < std::time_t > ((bits >> 34) % (365 * SalesLedger::SecondsPerDay))
+      }
+    });
+  }
+  std::chrono::duration < double > built = std::chrono::steady_clock::now() - start;
+  SalesLedger::Stats stats = ledger.stats();
+  std::cout << count << " purchases recorded in " << built.count() << " s (" << stats.bytes / (1024 * 1024) <<
+    " MiB in " << stats.chunks << " chunks)\n";
+
+  // One developer's games are 7, 507, 1007, ...
+  const std::uint32_t developer = 7;
+  std::uint64_t rolledUp = 0, scanned = 0;
+  double report = averageMillis(1000, [ & ] {
+    rolledUp = 0;
+    for (std::uint32_t game = developer; game < gameCount; game += developerCount) rolledUp += ledger.game({game, 0}).revenueCents;
+  });
+  double rescan = averageMillis(1, [ & ] {
+    std::vector < std::uint64_t > perGame(gameCount);
+    ledger.forEach([ & ](const SalesLedger::Row & row) {
+      if (row.developer == developer) perGame[row.game.slot] += row.sale.priceCents;
+    });
+    scanned = 0;
+    for (std::uint64_t cents: perGame) scanned += cents;
+  });
+  std::cout << "  developer report (" << gameCount / developerCount << " games): " << report * 1000 <<
+    " us from rollups, " << rescan << " ms rescanning" << (rolledUp == scanned ? "" : " (totals differ!)") << "\n";
+
+  double managers = averageMillis(100, [ & ] {
+    rolledUp = 0;
+    for (std::uint32_t i = 0; i < developerCount; ++i) rolledUp += ledger.developer("developer" + std::to_string(i)).units;
+  });
+  double week = averageMillis(1000, [ & ] {
+    ledger.days(now - 6 * SalesLedger::SecondsPerDay, now);
+  });
+  std::cout << "  manager report (" << developerCount << " developers): " << managers * 1000 << " us, " <<
+    rolledUp << " units; last 7 days by day: " << week * 1000 << " us\n";
+}
+
+// Schedules 200k sales of 1-7 days over 1M games within a month, then moves
+// the clock through them an hour at a time, timing price reads and the sale
+// list halfway
+void benchmarkPricing() {
+  const std::uint32_t gameCount = 1000000, ruleCount = 200000;
+  const std::time_t day = 24 * 60 * 60, start = 1700000000;
+  CatalogStore store;
+  store.reserve(gameCount);
+  for (std::uint32_t i = 0; i < gameCount; ++i) store.append(nullptr, 5.0 + i % 60, "Genre", GameRating::E, 0);
+  PricingEngine pricing(store);
+  for (std::uint32_t i = 0; i < gameCount; ++i) pricing.track(i);
+  pricing.advance(start);
+
+  std::mt19937 gen(7);
+  auto begin = std::chrono::steady_clock::now();
+  for (std::uint32_t i = 0; i < ruleCount; ++i) {
+    std::time_t opens = start + 1 + gen() % (30 * day);
+    pricing.addRule(gen() % gameCount, static_cast < std::uint16_t > (500 + gen() % 20 * 250), opens, opens + day * (1 + gen() % 7));
+  }
+  std::chrono::duration < double, std::milli > scheduled = std::chrono::steady_clock::now() - begin;
+
+  double sweep = 0;
+  auto advanceTo = [ & ](std::time_t from, std::time_t to) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (std::time_t now = from; now <= to; now += 3600) pricing.advance(now);
+    sweep += std::chrono::duration < double, std::milli > (std::chrono::steady_clock::now() - t0).count();
+  };
+  advanceTo(start, start + 15 * day);
+  volatile double sink = 0;
+  double reads = averageMillis(20, [ & ] {
+    double sum = 0;
+    for (std::uint32_t slot = 0; slot < gameCount; ++slot) sum += store.price(slot);
+    sink = sink + sum;
+  });
+  size_t onSale = 0;
+  double list = averageMillis(20, [ & ] {
+    onSale = pricing.saleSlots().size();
+  });
+  advanceTo(start + 15 * day + 3600, start + 40 * day);
+
+  std::cout << ruleCount << " sales scheduled in " << scheduled.count() << " ms; " << 40 * 24 <<
+    " hourly clock steps applied " << 2 * ruleCount << " window boundaries in " << sweep << " ms\n";
+  std::cout << "  halfway: " << onSale << " games on sale, sale list in " << list << " ms, price read " <<
+    reads * 1e6 / gameCount << " ns, " << pricing.ruleCount() << " rules left at the end\n";
+}
+
+// Builds a synthetic marketplace of userCount customers and one game per 10
+// of them on every core, then checks that 1 and 4 threads build
+// byte-identical snapshots from the same seed at a smaller scale
+void benchmarkGenerate(size_t userCount) {
+  SyntheticConfig config;
+  config.users = userCount;
+  config.games = std::max < size_t > (1, userCount / 10);
+  config.posts = userCount / 10;
+  {
+    GameMarketplace marketplace;
+    auto start = std::chrono::steady_clock::now();
+    marketplace.populateSynthetic(config);
+    std::chrono::duration < double > elapsed = std::chrono::steady_clock::now() - start;
+    size_t reviews = 0;
+    for (const Game * game: marketplace.catalogGames()) reviews += game -> getReviewCount();
+    GameMarketplace::AllocationReport report = marketplace.allocationStats();
+    std::cout << config.games << " games, " << report.users.live << " users, " << report.sales.rows
+      << " purchases, " << reviews << " reviews, " << report.posts.posts << " posts on " << config.threads
+      << " threads: " << elapsed.count() << " s\n";
+  }
+
+  config.users = 20000;
+  config.games = 2000;
+  config.posts = 2000;
+  std::string snapshots[2];
+  unsigned threadCounts[2] = {1, 4};
+  for (int run = 0; run < 2; ++run) {
+    GameMarketplace marketplace;
+    config.threads = threadCounts[run];
+    marketplace.populateSynthetic(config);
+    const std::string path = "benchmark-generate.snap";
+    marketplace.saveSnapshot(path);
+    std::ifstream in(path, std::ios::binary);
+    snapshots[run].assign(std::istreambuf_iterator < char > (in), std::istreambuf_iterator < char > ());
+    std::remove(path.c_str());
+  }
+  std::cout << "1 and 4 threads, same seed: " << (snapshots[0] == snapshots[1] ? "identical" : "DIFFERENT")
+    << " snapshots\n";
+}
+
+// Logins against userCount registered customers. With 1-iteration hashes the
+// time is the username lookup plus the hop to the hashing pool, compared with
+// the scan every login used to do. Then a storm of full-cost logins from many
+// threads shows the pool capping login throughput while searches go on.
+void benchmarkLogin(size_t userCount) {
+  SyntheticConfig config;
+  config.users = userCount;
+  config.games = 10000;
+  config.meanLibrary = 1;
+  config.reviewsPerGame = 0;
+  config.posts = 0;
+  config.recordSales = false;
+  GameMarketplace marketplace;
+  marketplace.setPasswordCost(1);
+  marketplace.populateSynthetic(config);
+  std::vector < User * > customers = marketplace.usersWithRole(UserRole::CUSTOMER);
+  std::vector < std::string > names;
+  SeededRandom random(7);
+  for (int i = 0; i < 1000; ++i) names.emplace_back(customers[random.below(customers.size())] -> getUsername());
+
+  size_t next = 0, matched = 0;
+  double indexed = averageMillis(20000, [ & ] {
+    matched += marketplace.authenticate(names[next++ % names.size()], UserRole::CUSTOMER, "password") != nullptr;
+  });
+  double scan = averageMillis(5, [ & ] {
+    const std::string & name = names[next++ % names.size()];
+    matched += std::find_if(customers.begin(), customers.end(), [ & ](const User * user) {
+      return user -> getUsername() == name;
+    }) != customers.end();
+  });
+  std::cout << customers.size() << " customers: indexed login " << indexed * 1000 << " us at cost 1, scan "
+    << scan << " ms (" << matched << " matched)\n";
+
+  marketplace.setPasswordCost(PasswordHash::DefaultCost);
+  const int accounts = 8;
+  for (int i = 0; i < accounts; ++i) {
+    marketplace.registerUser("storm" + std::to_string(i), "storm@example.com", "hunter2", UserRole::CUSTOMER);
+  }
+  double single = averageMillis(5, [ & ] {
+    marketplace.authenticate("storm0", UserRole::CUSTOMER, "hunter2");
+  });
+  double idleSearch = averageMillis(200, [ & ] {
+    marketplace.searchGames("Kingdom");
+  });
+
+  unsigned clients = std::max(32u, 8 * std::thread::hardware_concurrency());
+  std::atomic < bool > stop {
+    false
+  };
+  std::atomic < size_t > succeeded {
+    0
+  }, busy {
+    0
+  };
+  std::vector < std::thread > storm;
+  for (unsigned t = 0; t < clients; ++t) {
+    storm.emplace_back([ & , t] {
+      std::string name = "storm" + std::to_string(t % accounts);
+      while (!stop.load(std::memory_order_relaxed)) {
+        try {
+          if (marketplace.authenticate(name, UserRole::CUSTOMER, "hunter2")) succeeded++;
+        } catch (const HashingPool::Busy & ) {
+          busy++;
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+      }
+    });
+  }
+  auto start = std::chrono::steady_clock::now();
+  double stormSearch = averageMillis(200, [ & ] {
+    marketplace.searchGames("Kingdom");
+  });
+  while (std::chrono::steady_clock::now() - start < std::chrono::seconds(3)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  stop = true;
+  for (auto & thread: storm) thread.join();
+  std::chrono::duration < double > elapsed = std::chrono::steady_clock::now() - start;
+  std::cout << "Cost " << PasswordHash::DefaultCost << ": one login " << single << " ms; " << clients
+    << " clients, " << marketplace.hashingThreads() << " hashing threads: " << succeeded / elapsed.count()
+    << " logins/s, " << busy << " turned away busy\n";
+  std::cout << "Title search " << idleSearch << " ms idle, " << stormSearch << " ms during the storm\n";
+}
+
+// ---------------------------------------------------------------------------
+// Tests, run with: game_marketplace --test <name>; each returns false and
+// prints what went wrong on failure
+// ---------------------------------------------------------------------------
+
+#ifdef MARKETPLACE_COUNT_ALLOCATIONS
+// Heap allocations made by the current thread, counted by the replacement
+// global operator new below so a test can assert a path does not allocate.
+// The matching deletes hand memory back to free; they stay out of line so
+// the compiler does not pair an inlined free with a new expression.
+// Test builds only, so shipping binaries keep the library's allocator:
+//   g++ -std=c++17 -O2 -pthread -DMARKETPLACE_COUNT_ALLOCATIONS -o game_marketplace_alloc "sample code lol.cpp"
+//   ./game_marketplace_alloc --test alloc
+thread_local size_t allocationsOnThisThread = 0;
+
+void * operator new(std::size_t size) {
+  ++allocationsOnThisThread;
+  if (void * p = std::malloc(size ? size : 1)) return p;
+  throw std::bad_alloc();
+}
+
+void * operator new(std::size_t size, std::align_val_t alignment) {
+  ++allocationsOnThisThread;
+  std::size_t align = static_cast < std::size_t > (alignment);
+  if (void * p = std::aligned_alloc(align, (std::max < std::size_t > (size, 1) + align - 1) / align * align)) return p;
+  throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void * p) noexcept {
+  std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void * p, std::size_t) noexcept {
+  std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void * p, std::align_val_t) noexcept {
+  std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void * p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
+
+// A warm searchGames over 100k games allocates nothing but its result vector
+bool testSearchAllocations() {
+  SyntheticConfig config;
+  config.games = 100000;
+  config.users = 1000;
+  config.posts = 0;
+  GameMarketplace marketplace;
+  marketplace.populateSynthetic(config);
+
+  struct Query {
+    const char * name;
+    std::function < size_t () > run;
+  };
+  std::vector < Query > queries = {
+    {"full filter pass", [&] { return marketplace.searchGames().size(); }},
+    {"price and rating", [&] { return marketplace.searchGames("", 10.0, 40.0, "", GameRating::M).size(); }},
+    {"category", [&] { return marketplace.searchGames("", 0.0, 1000.0, "Strategy").size(); }},
+    {"title", [&] { return marketplace.searchGames("Kingdom").size(); }},
+    {"title with a typo", [&] { return marketplace.searchGames("Kingdm", 5.0, 60.0).size(); }},
+    {"no matches", [&] { return marketplace.searchGames("zzzzqqqq").size(); }}
+  };
+  bool passed = true;
+  for (const Query & query: queries) {
+    query.run(); // sizes this thread's scratch buffers
+    size_t before = allocationsOnThisThread;
+    size_t hits = query.run();
+    size_t allocations = allocationsOnThisThread - before;
+    size_t allowed = hits > 0 ? 1 : 0;
+    std::cout << query.name << ": " << hits << " hits, " << allocations << " allocations\n";
+    if (allocations > allowed) {
+      std::cout << "  FAILED: expected at most " << allowed << " (the result vector)\n";
+      passed = false;
+    }
+  }
+  return passed;
+}
+#endif
+
+std::string stateDump(const GameMarketplace & marketplace) {
+  std::ostringstream out;
+  marketplace.writeStateDump(out);
+  return out.str();
+}
+
+// Prints the first line where two state dumps differ
+bool sameState(const std::string & expected, const std::string & actual, const std::string & what) {
+  if (expected == actual) return true;
+  std::istringstream left(expected), right(actual);
+  std::string a, b;
+  for (size_t line = 1;; ++line) {
+    bool moreLeft = static_cast < bool > (std::getline(left, a)), moreRight = static_cast < bool > (std::getline(right, b));
+    if (!moreLeft && !moreRight) break;
+    if (!moreLeft || !moreRight || a != b) {
+      std::cout << "  FAILED: " << what << " differs at line " << line << ":\n    expected: "
+        << (moreLeft ? a : "<end>") << "\n    actual:   " << (moreRight ? b : "<end>") << "\n";
+      break;
+    }
+  }
+  return false;
+}
+
+// Saves a generated marketplace, loads it into a fresh one and compares
+// games, reviews, users with their libraries and wishlists, administrators,
+// posts, sale rules and sales. Also removes a game, a post and adds a sale
+// first, so the parts a snapshot drops or renumbers are covered.
+bool testSnapshotRoundTrip() {
+  SyntheticConfig config;
+  config.games = 20000;
+  config.users = 20000;
+  config.posts = 5000;
+  config.reviewsPerGame = 3;
+  const std::string path = "roundtrip-test.snap";
+
+  std::string expected;
+  {
+    GameMarketplace marketplace;
+    marketplace.populateSynthetic(config);
+    marketplace.setPasswordCost(1);
+    marketplace.registerUser("roundtrip", "roundtrip@example.com", "secret", UserRole::CUSTOMER);
+    marketplace.removeGame(marketplace.findGameById("17"));
+    marketplace.removePost(42);
+    marketplace.scheduleSale(marketplace.findGameById("5"), 25, config.now, config.now + 7 * 86400);
+    expected = stateDump(marketplace);
+    marketplace.saveSnapshot(path);
+  }
+  GameMarketplace restored;
+  restored.loadSnapshot(path, true);
+  std::remove(path.c_str());
+  std::cout << "round trip of " << expected.size() << " bytes of state\n";
+  return sameState(expected, stateDump(restored), "loaded snapshot");
+}
+
+// Logs a run of mutations, then cuts the log at several offsets inside
+// each record (and flips a byte in one) and recovers from a copy of the
+// snapshot and the damaged log. Every complete record must be replayed and
+// the torn one dropped, leaving the log cut back to the last whole record.
+// Also recovers from a crash between compaction's snapshot rename and its
+// log reset, and checks that a log on a full device refuses further records.
+bool testWalRecovery() {
+  const std::string path = "wal-test.snap", crashPath = "wal-crash.snap";
+  auto removeFiles = [](const std::string & base) {
+    for (const char * suffix : {"", ".wal", ".feed", ".tmp"}) std::remove((base + suffix).c_str());
+  };
+  auto fileSize = [](const std::string & file) {
+    struct stat info;
+    return ::stat(file.c_str(), & info) == 0 ? static_cast < size_t > (info.st_size) : size_t(0);
+  };
+  auto readFile = [](const std::string & file) {
+    std::ifstream in(file, std::ios::binary);
+    return std::string(std::istreambuf_iterator < char > (in), std::istreambuf_iterator < char > ());
+  };
+  auto writeFile = [](const std::string & file, std::string_view bytes) {
+    std::ofstream(file, std::ios::binary | std::ios::trunc).write(bytes.data(), static_cast < std::streamsize > (bytes.size()));
+  };
+  removeFiles(path);
+  removeFiles(crashPath);
+
+  // States after 0..n records and where each record ends in the log
+  std::vector < std::string > states;
+  std::vector < size_t > ends;
+  std::string snapshot, log;
+  {
+    GameMarketplace marketplace;
+    marketplace.setPasswordCost(1);
+    marketplace.openDurable(path);
+    auto checkpoint = [ & ] {
+      states.push_back(stateDump(marketplace));
+      ends.push_back(fileSize(path + ".wal"));
+    };
+    checkpoint();
+    User * buyer = marketplace.registerUser("walbuyer", "wal@example.com", "secret", UserRole::CUSTOMER);
+    checkpoint();
+    Game * first = marketplace.findGameById("game1"), * second = marketplace.findGameById("game2"),
+      * third = marketplace.findGameById("game3");
+    marketplace.purchaseGame(buyer, first);
+    checkpoint();
+    marketplace.addToWishlist(buyer, second);
+    checkpoint();
+    marketplace.submitReview(buyer, first, "Held up after a second playthrough", 4);
+    checkpoint();
+    marketplace.changePrice(third, 12.5);
+    checkpoint();
+    std::time_t now = std::time(nullptr);
+    marketplace.scheduleSale(second, 30, now, now + 86400);
+    checkpoint();
+    std::uint64_t post = marketplace.writePost(std::string(buyer -> getUserId()), "Anyone up for co-op tonight?");
+    checkpoint();
+    marketplace.removeFromWishlist(buyer, second);
+    checkpoint();
+    marketplace.removePost(post);
+    checkpoint();
+    marketplace.removeFromLibrary(buyer, first);
+    checkpoint();
+    // Copied before closeDurable folds the log into the snapshot
+    snapshot = readFile(path);
+    log = readFile(path + ".wal");
+  }
+  const std::string compacted = readFile(path);
+  const size_t logAfterClose = fileSize(path + ".wal");
+  removeFiles(path);
+
+  bool passed = log.size() == ends.back();
+  if (!passed) std::cout << "  FAILED: log is " << log.size() << " bytes, expected " << ends.back() << "\n";
+  if (logAfterClose != 0) {
+    std::cout << "  FAILED: log still holds " << logAfterClose << " bytes after compaction\n";
+    passed = false;
+  }
+  size_t runs = 0;
+  auto recoverFrom = [ & ](std::string_view damaged, size_t records, const std::string & what,
+    const std::string & base) {
+    removeFiles(crashPath);
+    writeFile(crashPath, base);
+    writeFile(crashPath + ".wal", damaged);
+    {
+      GameMarketplace marketplace;
+      marketplace.openDurable(crashPath);
+      ++runs;
+      if (fileSize(crashPath + ".wal") != ends[records]) {
+        std::cout << "  FAILED: " << what << ": log not cut back to " << ends[records] << " bytes\n";
+        passed = false;
+      }
+      passed = sameState(states[records], stateDump(marketplace), what) && passed;
+    }
+    removeFiles(crashPath);
+  };
+  for (size_t record = 1; record < ends.size(); ++record) {
+    size_t begin = ends[record - 1], end = ends[record];
+    std::set < size_t > cuts = {begin + 1, begin + 11, begin + 12, begin + 20, (begin + end) / 2, end - 1};
+    for (size_t cut: cuts) {
+      if (cut <= begin || cut >= end) continue;
+      recoverFrom(std::string_view(log).substr(0, cut), record - 1,
+        "log cut at byte " + std::to_string(cut) + " inside record " + std::to_string(record), snapshot);
+    }
+  }
+  recoverFrom(log, ends.size() - 1, "whole log", snapshot);
+  std::string flipped = log;
+  flipped[(ends[ends.size() - 2] + ends.back()) / 2] ^= 0x40;
+  recoverFrom(flipped, ends.size() - 2, "corrupt last record", snapshot);
+  // The compacted snapshot already holds every record, so none may apply twice
+  recoverFrom(log, ends.size() - 1, "crash between snapshot rename and log reset", compacted);
+
+  // Every write to /dev/full fails: the first record must not be
+  // acknowledged, and nothing may be queued behind it
+  if (::access("/dev/full", W_OK) == 0) {
+    WriteAheadLog full("/dev/full");
+    full.start(1);
+    bool refused = false;
+    try {
+      full.waitDurable(full.append(MutationType::POST_REMOVE, "x"));
+    } catch (const std::runtime_error & ) {
+      refused = true;
+    }
+    try {
+      full.append(MutationType::POST_REMOVE, "y");
+      refused = false;
+    } catch (const std::runtime_error & ) {}
+    if (!refused) {
+      std::cout << "  FAILED: a log that cannot be written still accepted records\n";
+      passed = false;
+    }
+  }
+  std::cout << ends.size() - 1 << " records, " << runs << " recoveries\n";
+  return passed;
+}
+
+// Threads mixing purchases, reviews, price changes, searches and wishlist
+// toggles over a small catalog so they collide, then checks that the end
+// state matches what the calls reported. Run it under ThreadSanitizer too:
+//   g++ -std=c++17 -O1 -g -fsanitize=thread -pthread -o game_marketplace_tsan "sample code lol.cpp"
+//   ./game_marketplace_tsan --test stress
+bool testConcurrentStress() {
+  const int threadCount = 8, opsPerThread = 20000;
+  SyntheticConfig config;
+  config.games = 200;
+  config.users = 500;
+  config.posts = 0;
+  GameMarketplace marketplace;
+  marketplace.populateSynthetic(config);
+  std::vector < Game * > created = marketplace.catalogGames();
+  std::vector < User * > customers = marketplace.usersWithRole(UserRole::CUSTOMER);
+  const int gameCount = static_cast < int > (created.size()), userCount = static_cast < int > (customers.size());
+  std::unordered_map < const Game * , int > indexOf;
+  std::set < std::string > developers;
+  for (int i = 0; i < gameCount; ++i) {
+    indexOf[created[i]] = i;
+    developers.insert(std::string(created[i] -> getDeveloperName()));
+  }
+
+  auto countOwners = [ & ] {
+    std::vector < size_t > owners(gameCount);
+    for (User * user: customers) {
+      for (Game * game: marketplace.libraryOf(user)) owners[indexOf.at(game)]++;
+    }
+    return owners;
+  };
+  auto unitsSold = [ & ] {
+    std::uint64_t units = 0;
+    for (const auto & developer: developers) units += marketplace.developerSales(developer).units;
+    return units;
+  };
+  std::vector < size_t > ownersBefore = countOwners(), reviewsBefore(gameCount), wishlistBefore(userCount);
+  std::vector < double > pricesBefore(gameCount);
+  for (int i = 0; i < gameCount; ++i) {
+    reviewsBefore[i] = marketplace.reviewsOf(created[i]).size();
+    pricesBefore[i] = marketplace.basePriceOf(created[i]);
+  }
+  for (int i = 0; i < userCount; ++i) wishlistBefore[i] = marketplace.wishlistOf(customers[i]).size();
+  const std::uint64_t unitsBefore = unitsSold();
+
+  std::vector < std::atomic < int >> purchases(gameCount), reviews(gameCount), wishlistChange(userCount);
+  std::vector < std::atomic < bool >> repriced(gameCount);
+  std::atomic < bool > start {
+    false
+  };
+  std::atomic < int > badSearches {
+    0
+  };
+  auto worker = [ & ](unsigned seed) {
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution < > gameDistrib(0, gameCount - 1), userDistrib(0, userCount - 1), opDistrib(0, 99);
+    while (!start.load(std::memory_order_acquire)) std::this_thread::yield();
+    for (int op = 0; op < opsPerThread; ++op) {
+      int kind = opDistrib(gen), gameIndex = gameDistrib(gen), userIndex = userDistrib(gen);
+      Game * game = created[gameIndex];
+      User * user = customers[userIndex];
+      if (kind < 30) {
+        if (marketplace.purchaseGame(user, game)) purchases[gameIndex]++;
+      } else if (kind < 45) {
+        try {
+          marketplace.submitReview(user, game, "Stress review", op % 5 + 1);
+          reviews[gameIndex]++;
+        } catch (const std::runtime_error & ) {
+          // Not in the user's library
+        }
+      } else if (kind < 60) {
+        marketplace.changePrice(game, (op % 10) + 0.99);
+        repriced[gameIndex] = true;
+      } else if (kind < 75) {
+        std::set < const Game * > seen;
+        for (const Game * hit: marketplace.searchGames("Kingdom", 0.0, 1000.0)) {
+          if (!indexOf.count(hit) || !seen.insert(hit).second) badSearches++;
+        }
+      } else if (marketplace.addToWishlist(user, game)) {
+        wishlistChange[userIndex]++;
+      } else if (marketplace.removeFromWishlist(user, game)) {
+        wishlistChange[userIndex]--;
+      }
+    }
+  };
+  std::vector < std::thread > pool;
+  for (int t = 0; t < threadCount; ++t) pool.emplace_back(worker, 1000 + t);
+  start.store(true, std::memory_order_release);
+  for (auto & thread: pool) thread.join();
+
+  bool passed = true;
+  auto fail = [ & ](const std::string & what) {
+    if (passed) std::cout << what << '\n';
+    passed = false;
+  };
+  if (badSearches) fail(std::to_string(badSearches.load()) + " search hits were unknown or repeated");
+  std::vector < size_t > ownersAfter = countOwners();
+  std::uint64_t purchased = 0;
+  for (int i = 0; i < gameCount; ++i) {
+    const std::string id(created[i] -> getGameId());
+    purchased += purchases[i];
+    if (ownersAfter[i] != ownersBefore[i] + purchases[i]) {
+      fail("game " + id + ": " + std::to_string(ownersAfter[i]) + " owners, expected " +
+        std::to_string(ownersBefore[i] + purchases[i]));
+    }
+    if (marketplace.reviewsOf(created[i]).size() != reviewsBefore[i] + reviews[i]) {
+      fail("game " + id + ": review count does not match successful reviews");
+    }
+    double price = marketplace.basePriceOf(created[i]);
+    bool written = std::fabs(price - std::floor(price) - 0.99) < 1e-9 && price >= 0.99 && price <= 9.99;
+    if (repriced[i] ? !written : price != pricesBefore[i]) fail("game " + id + ": unexpected base price");
+  }
+  if (unitsSold() != unitsBefore + purchased) {
+    fail("sales ledger has " + std::to_string(unitsSold() - unitsBefore) + " new units, expected " +
+      std::to_string(purchased));
+  }
+  for (int i = 0; i < userCount; ++i) {
+    const User * user = customers[i];
+    // Every entry still resolves to a live game
+    bool resolves = marketplace.withUser(user, [](const User & owner) {
+      return owner.getLibrary().size();
+    }) == marketplace.libraryOf(user).size();
+    if (!resolves) fail("user " + std::string(user -> getUserId()) + ": a library entry does not resolve");
+    if (marketplace.wishlistOf(user).size() != wishlistBefore[i] + wishlistChange[i]) {
+      fail("user " + std::string(user -> getUserId()) + ": wishlist size does not match successful toggles");
+    }
+  }
+  std::cout << threadCount << " threads, " << purchased << " purchases\n";
+  return passed;
+}
+
+int main(int argc, char * argv[]) {
+
+  if (argc >= 3 && std::string(argv[1]) == "--bench") {
+    std::string name = argv[2];
+    if (name == "scan") {
+      benchmarkFilterScan();
+    } else if (name == "filter") {
+      if (!benchmarkFilterKernels()) return 1;
+    } else if (name == "snapshot") {
+      benchmarkSnapshot();
+    } else if (name == "concurrency") {
+      benchmarkConcurrency();
+    } else if (name == "api") {
+      benchmarkApi();
+    } else if (name == "http") {
+      benchmarkHttp();
+    } else if (name == "topk") {
+      benchmarkTopK();
+    } else if (name == "fuzzy") {
+      benchmarkFuzzySearch();
+    } else if (name == "feed") {
+      benchmarkFeed();
+    } else if (name == "ledger") {
+      benchmarkSalesLedger();
+    } else if (name == "pricing") {
+      benchmarkPricing();
+    } else if (name == "generate") {
+      // --bench generate [customers], 10 million by default
+      benchmarkGenerate(argc >= 4 ? std::stoull(argv[3]) : 10000000);
+    } else if (name == "login") {
+      // --bench login [customers], 10 million by default
+      benchmarkLogin(argc >= 4 ? std::stoull(argv[3]) : 10000000);
+    } else {
+      std::cout << "Unknown benchmark: " << name << std::endl;
+      return 1;
+    }
+    return 0;
+  }
+
+  if (argc >= 3 && std::string(argv[1]) == "--test") {
+    std::string name = argv[2];
+    bool passed;
+    if (name == "alloc") {
+#ifdef MARKETPLACE_COUNT_ALLOCATIONS
+      passed = testSearchAllocations();
+#else
+      std::cout << "alloc needs a build with -DMARKETPLACE_COUNT_ALLOCATIONS" << std::endl;
+      return 1;
+#endif
+    } else if (name == "snapshot") {
+      passed = testSnapshotRoundTrip();
+    } else if (name == "wal") {
+      passed = testWalRecovery();
+    } else if (name == "stress") {
+      passed = testConcurrentStress();
+    } else {
+      std::cout << "Unknown test: " << name << std::endl;
+      return 1;
+    }
+    std::cout << name << (passed ? ": passed" : ": FAILED") << std::endl;
+    return passed ? 0 : 1;
+  }
+
+  // Example usage
+
+  GameMarketplace marketplace;
+
+  // --snapshot <path> resumes from a saved marketplace, logs every change to
+  // <path>.wal as it happens and folds the log into the snapshot on exit
+  int snapshotAt = argc >= 3 && std::string(argv[1]) == "--snapshot" ? 1 :
+    argc >= 5 && std::string(argv[3]) == "--snapshot" ? 3 : 0;
+  if (snapshotAt) {
+    marketplace.openDurable(argv[snapshotAt + 1]);
+  } else {
+    marketplace.populateWithDefaults();
+  }
+
+  MarketplaceApi api(marketplace);
+
+  // --serve <port> [--snapshot <path>] answers HTTP until stdin closes or
+  // "quit" is entered, instead of running the menus
+  int serveAt = argc >= 3 && std::string(argv[1]) == "--serve" ? 1 :
+    argc >= 5 && std::string(argv[3]) == "--serve" ? 3 : 0;
+  if (serveAt) {
+    HttpServer server(api, static_cast < std::uint16_t > (std::stoi(argv[serveAt + 1])),
+      std::max(1u, std::thread::hardware_concurrency()));
+    std::cout << "Serving HTTP on port " << server.port() << std::endl;
+    std::string line;
+    while (std::getline(std::cin, line) && line != "quit") {}
+    server.stop();
+  } else {
+    TextClient client(api);
+    client.run();
+  }
 
-  marketplace.runTextUI();
+  marketplace.closeDurable();
 
   std::cout << "Video Game Sales Software Demo Complete!! :)" << std::endl;
 